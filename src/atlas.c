@@ -0,0 +1,256 @@
+function
+void begin_skyline_packer(Skyline_Packer* packer, u32 width, u32 height) {
+    packer->width      = width;
+    packer->height     = height;
+    packer->node_count = 1;
+    packer->nodes      = (Skyline_Node*)malloc(sizeof(Skyline_Node)*(width + 1));
+    packer->nodes[0]   = (Skyline_Node) { .x = 0, .y = 0, .width = width };
+}
+
+function
+void end_skyline_packer(Skyline_Packer* packer) {
+    free(packer->nodes);
+    memset(packer, 0, sizeof(*packer));
+}
+
+function
+void remove_skyline_node(Skyline_Packer* packer, u32 index) {
+    memmove(packer->nodes + index, packer->nodes + index + 1, sizeof(Skyline_Node)*(packer->node_count - index - 1));
+    packer->node_count -= 1;
+}
+
+// NOTE: Finds the height a rectangle would rest at if its left edge sat on the node at index.
+function
+b32 skyline_fit(Skyline_Packer* packer, u32 index, u32 width, u32 height, u32* out_y) {
+    b32 result = false;
+    
+    u32 x = packer->nodes[index].x;
+    if (x + width <= packer->width) {
+        u32 y = 0;
+        u32 remaining = width;
+        for (u32 node_index = index; ; ++node_index) {
+            Skyline_Node* node = packer->nodes + node_index;
+            y = Max(y, node->y);
+            if (node->width >= remaining) {
+                break;
+            }
+            remaining -= node->width;
+        }
+        
+        if (y + height <= packer->height) {
+            *out_y = y;
+            result = true;
+        }
+    }
+    
+    return result;
+}
+
+function
+b32 skyline_pack(Skyline_Packer* packer, u32 width, u32 height, u32* out_x, u32* out_y) {
+    b32 result = false;
+    
+    u32 best_index = UINT32_MAX;
+    u32 best_top   = UINT32_MAX;
+    u32 best_width = UINT32_MAX;
+    u32 best_y     = 0;
+    for (u32 node_index = 0; node_index < packer->node_count; ++node_index) {
+        u32 y;
+        if (skyline_fit(packer, node_index, width, height, &y)) {
+            u32 top = y + height;
+            u32 node_width = packer->nodes[node_index].width;
+            if ((top < best_top) || ((top == best_top) && (node_width < best_width))) {
+                best_index = node_index;
+                best_top   = top;
+                best_width = node_width;
+                best_y     = y;
+            }
+        }
+    }
+    
+    if (best_index != UINT32_MAX) {
+        Skyline_Node new_node = { .x = packer->nodes[best_index].x, .y = best_top, .width = width };
+        
+        Assert(packer->node_count < packer->width + 1);
+        memmove(packer->nodes + best_index + 1, packer->nodes + best_index, sizeof(Skyline_Node)*(packer->node_count - best_index));
+        packer->nodes[best_index] = new_node;
+        packer->node_count += 1;
+        
+        // NOTE: Cut away whatever the new node now shadows.
+        for (u32 node_index = best_index + 1; node_index < packer->node_count; ) {
+            Skyline_Node* prev = packer->nodes + node_index - 1;
+            Skyline_Node* node = packer->nodes + node_index;
+            u32 prev_end = prev->x + prev->width;
+            if (node->x >= prev_end) {
+                break;
+            }
+            
+            u32 shrink = prev_end - node->x;
+            if (node->width <= shrink) {
+                remove_skyline_node(packer, node_index);
+            } else {
+                node->x     += shrink;
+                node->width -= shrink;
+                break;
+            }
+        }
+        
+        for (u32 node_index = 0; node_index + 1 < packer->node_count; ) {
+            Skyline_Node* node = packer->nodes + node_index;
+            Skyline_Node* next = packer->nodes + node_index + 1;
+            if (node->y == next->y) {
+                node->width += next->width;
+                remove_skyline_node(packer, node_index + 1);
+            } else {
+                ++node_index;
+            }
+        }
+        
+        *out_x = new_node.x;
+        *out_y = best_y;
+        result = true;
+    }
+    
+    return result;
+}
+
+//
+// NOTE: Batch distance field atlas. Everything is packed up front, since the sizes are known
+// before any field is computed, and then every mask is its own small job that writes straight
+// into its own rectangle of the atlas, so the jobs never touch the same pixels.
+//
+
+typedef struct Atlas_Worker_Scratch {
+    Distance_Field_Scratch field;
+    u32* padded;
+    u32 padded_capacity;
+} __attribute__((aligned(64))) Atlas_Worker_Scratch;
+
+typedef struct Atlas_Job_Data {
+    Distance_Field_Atlas_Desc* desc;
+    Image_u32* masks;
+    Distance_Field_Atlas* atlas;
+    Atlas_Worker_Scratch* worker_scratch;
+} Atlas_Job_Data;
+
+internal int compare_atlas_entries_by_height(const void* a_ptr, const void* b_ptr) {
+    const Atlas_Entry* a = (const Atlas_Entry*)a_ptr;
+    const Atlas_Entry* b = (const Atlas_Entry*)b_ptr;
+    int result = (a->height < b->height) - (a->height > b->height);
+    if (!result) {
+        result = (a->width < b->width) - (a->width > b->width);
+    }
+    return result;
+}
+
+internal void atlas_job(void* user_data, u32 job_index, u32 worker_index) {
+    Atlas_Job_Data* data = (Atlas_Job_Data*)user_data;
+    Atlas_Worker_Scratch* scratch = data->worker_scratch + worker_index;
+    Atlas_Entry* entry = data->atlas->entries + job_index;
+    Image_u32* mask = data->masks + entry->source_index;
+    if (!entry->width) {
+        // NOTE: Didn't fit in the atlas
+        return;
+    }
+    
+    u32 pixel_count = entry->width*entry->height;
+    if (scratch->padded_capacity < pixel_count) {
+        free(scratch->padded);
+        scratch->padded_capacity = pixel_count;
+        scratch->padded = (u32*)malloc(sizeof(u32)*pixel_count);
+    }
+    
+    Image_u32 padded = get_scratch_image(scratch->padded, entry->width, entry->height);
+    clear_image(&padded, (Color_ARGB) {});
+    blit_image(&padded, entry->padding, entry->padding, mask);
+    
+    write_signed_distance_field(&padded, data->desc->spread, data->desc->seeding, &scratch->field,
+                                &data->atlas->image, entry->x, entry->y);
+}
+
+function
+Distance_Field_Atlas produce_distance_field_atlas(Job_Pool* pool, Image_u32* masks, u32 mask_count, Distance_Field_Atlas_Desc* desc) {
+    Distance_Field_Atlas atlas = {};
+    atlas.entry_count = mask_count;
+    atlas.entries = (Atlas_Entry*)malloc(sizeof(Atlas_Entry)*mask_count);
+    
+    for (u32 mask_index = 0; mask_index < mask_count; ++mask_index) {
+        Atlas_Entry* entry = atlas.entries + mask_index;
+        memset(entry, 0, sizeof(*entry));
+        entry->source_index = mask_index;
+        entry->padding      = desc->padding;
+        entry->width        = masks[mask_index].width  + 2*desc->padding;
+        entry->height       = masks[mask_index].height + 2*desc->padding;
+    }
+    
+    // NOTE: Tallest first packs a lot tighter. The jobs run in this order too, which puts
+    // the big ones first and leaves the small ones to even out the tail.
+    qsort(atlas.entries, mask_count, sizeof(Atlas_Entry), compare_atlas_entries_by_height);
+    
+    u32 atlas_height = 0;
+    Skyline_Packer packer;
+    begin_skyline_packer(&packer, desc->atlas_width, UINT32_MAX / 2);
+    for (u32 entry_index = 0; entry_index < mask_count; ++entry_index) {
+        Atlas_Entry* entry = atlas.entries + entry_index;
+        if (skyline_pack(&packer, entry->width, entry->height, &entry->x, &entry->y)) {
+            atlas_height = Max(atlas_height, entry->y + entry->height);
+        } else {
+            fprintf(stderr, "error: Mask %u (%ux%u) is wider than the atlas.\n", entry->source_index, entry->width, entry->height);
+            entry->width  = 0;
+            entry->height = 0;
+        }
+    }
+    end_skyline_packer(&packer);
+    
+    atlas.image = allocate_image_u8(desc->atlas_width, atlas_height);
+    
+    Atlas_Worker_Scratch* worker_scratch = (Atlas_Worker_Scratch*)allocate_aligned(sizeof(Atlas_Worker_Scratch)*pool->worker_count, 64);
+    memset(worker_scratch, 0, sizeof(Atlas_Worker_Scratch)*pool->worker_count);
+    
+    Atlas_Job_Data data = {};
+    data.desc           = desc;
+    data.masks          = masks;
+    data.atlas          = &atlas;
+    data.worker_scratch = worker_scratch;
+    parallel_for(pool, mask_count, atlas_job, &data);
+    
+    for (u32 worker_index = 0; worker_index < pool->worker_count; ++worker_index) {
+        free_distance_field_scratch(&worker_scratch[worker_index].field);
+        free(worker_scratch[worker_index].padded);
+    }
+    free_aligned(worker_scratch);
+    
+    // NOTE: Back to source order for the caller.
+    Atlas_Entry* sorted = atlas.entries;
+    atlas.entries = (Atlas_Entry*)malloc(sizeof(Atlas_Entry)*mask_count);
+    for (u32 entry_index = 0; entry_index < mask_count; ++entry_index) {
+        atlas.entries[sorted[entry_index].source_index] = sorted[entry_index];
+    }
+    free(sorted);
+    
+    return atlas;
+}
+
+function
+void free_distance_field_atlas(Distance_Field_Atlas* atlas) {
+    free_image(&atlas->image);
+    free(atlas->entries);
+    memset(atlas, 0, sizeof(*atlas));
+}
+
+// NOTE: One line per mask, in source order. Coordinates are in pixels from the bottom left.
+function
+void write_atlas_metadata(char* file_name, Distance_Field_Atlas* atlas) {
+    FILE* out_file = fopen(file_name, "wb");
+    if (out_file) {
+        fprintf(out_file, "# atlas %u %u\n", atlas->image.width, atlas->image.height);
+        fprintf(out_file, "# index x y width height padding\n");
+        for (u32 entry_index = 0; entry_index < atlas->entry_count; ++entry_index) {
+            Atlas_Entry* entry = atlas->entries + entry_index;
+            fprintf(out_file, "%u %u %u %u %u %u\n", entry->source_index, entry->x, entry->y, entry->width, entry->height, entry->padding);
+        }
+        fclose(out_file);
+    } else {
+        fprintf(stderr, "error: Unable to write output file %s.\n", file_name);
+    }
+}
@@ -0,0 +1,51 @@
+/* date = October 19th 2026 11:48 am */
+
+#ifndef ATLAS_H
+#define ATLAS_H
+
+//
+// NOTE: Skyline packer, bottom-left heuristic. The skyline is the list of top edges of
+// everything packed so far, as spans that together cover the full atlas width.
+//
+
+typedef struct Skyline_Node {
+    u32 x;
+    u32 y;
+    u32 width;
+} Skyline_Node;
+
+typedef struct Skyline_Packer {
+    u32 width;
+    u32 height;
+    u32 node_count;
+    // NOTE: Every node is at least one pixel wide, so there are at most width of them, plus one
+    // while a pack has inserted its node and not yet cut away the ones it shadows.
+    Skyline_Node* nodes;
+} Skyline_Packer;
+
+typedef struct Atlas_Entry {
+    u32 source_index;
+    
+    // NOTE: The packed rectangle in the atlas, padding included. The mask itself starts at
+    // (x + padding, y + padding).
+    u32 x;
+    u32 y;
+    u32 width;
+    u32 height;
+    u32 padding;
+} Atlas_Entry;
+
+typedef struct Distance_Field_Atlas_Desc {
+    u32 atlas_width;
+    u32 padding; // NOTE: Border around each mask so the field has room to fall off, about the spread
+    f32 spread;
+    DistanceFieldSeeding seeding;
+} Distance_Field_Atlas_Desc;
+
+typedef struct Distance_Field_Atlas {
+    Image_u8 image;
+    u32 entry_count;
+    Atlas_Entry* entries; // NOTE: In the same order as the source masks
+} Distance_Field_Atlas;
+
+#endif //ATLAS_H
@@ -0,0 +1,464 @@
+//
+// NOTE: Building
+//
+
+typedef struct BVH_Subtree {
+    u32 node_index; // NOTE: Where its root goes in the top levels
+    u32 first;
+    u32 count;
+    BVH_Node* nodes; // NOTE: A stretchy buffer, its root first
+} BVH_Subtree;
+
+typedef struct BVH_Build {
+    Mesh* mesh;
+    Rect3* triangle_bounds;
+    V3* centroids;
+    u32* indices;
+    
+    // NOTE: The depth the top levels stop at and hand what's under them to jobs.
+    u32 subtree_depth;
+    BVH_Subtree* subtrees; // NOTE: A stretchy buffer
+} BVH_Build;
+
+// NOTE: Half the surface area, which is all the heuristic needs.
+internal f32 get_half_area(V3 dim) {
+    f32 result = dim.x*dim.y + dim.y*dim.z + dim.z*dim.x;
+    return result;
+}
+
+internal void bvh_bounds_job(void* user_data, u32 job_index, u32 worker_index) {
+    BVH_Build* build = (BVH_Build*)user_data;
+    Mesh* mesh = build->mesh;
+    
+    u32 first = job_index*BVH_BOUNDS_BATCH;
+    u32 last  = Min(first + BVH_BOUNDS_BATCH, mesh->triangle_count);
+    for (u32 triangle_index = first; triangle_index < last; ++triangle_index) {
+        Triangle* triangle = mesh->triangles + triangle_index;
+        V3 p0 = mesh->vertices[triangle->a];
+        V3 p1 = mesh->vertices[triangle->b];
+        V3 p2 = mesh->vertices[triangle->c];
+        Rect3 bounds = rect_min_max(min(min(p0, p1), p2), max(max(p0, p1), p2));
+        build->triangle_bounds[triangle_index] = bounds;
+        build->centroids[triangle_index] = rect_center(bounds);
+    }
+}
+
+internal u32 get_bvh_bin(f32 centroid, f32 centroid_min, f32 bin_scale) {
+    u32 result = (u32)Clamp((centroid - centroid_min)*bin_scale, 0.0f, (f32)(BVH_BIN_COUNT - 1));
+    return result;
+}
+
+internal void build_bvh_node(BVH_Build* build, BVH_Node** nodes, u32 node_index, u32 first, u32 count, u32 depth) {
+    if ((depth == build->subtree_depth) && (count >= BVH_MIN_SUBTREE_SIZE)) {
+        BVH_Subtree subtree = {};
+        subtree.node_index = node_index;
+        subtree.first      = first;
+        subtree.count      = count;
+        buf_push(build->subtrees, subtree);
+        return;
+    }
+    
+    u32* indices = build->indices + first;
+    V3 bounds_min = build->triangle_bounds[indices[0]].min;
+    V3 bounds_max = build->triangle_bounds[indices[0]].max;
+    V3 centroid_min = build->centroids[indices[0]];
+    V3 centroid_max = centroid_min;
+    for (u32 i = 1; i < count; ++i) {
+        Rect3 triangle_bounds = build->triangle_bounds[indices[i]];
+        bounds_min   = min(bounds_min, triangle_bounds.min);
+        bounds_max   = max(bounds_max, triangle_bounds.max);
+        centroid_min = min(centroid_min, build->centroids[indices[i]]);
+        centroid_max = max(centroid_max, build->centroids[indices[i]]);
+    }
+    
+    BVH_Node* node = *nodes + node_index;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        node->min[axis] = bounds_min[axis];
+        node->max[axis] = bounds_max[axis];
+    }
+    node->first = first;
+    node->count = count;
+    if ((count == 1) || (depth + 1 >= BVH_MAX_DEPTH)) {
+        return;
+    }
+    
+    // NOTE: Each bin's triangles and bounds, swept from both ends to cost every split between
+    // two bins. The cost is each side's area times its triangles, over the node's area.
+    u32 best_axis = 0;
+    u32 best_split = 0;
+    f32 best_cost = F32_MAX;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        f32 extent = centroid_max[axis] - centroid_min[axis];
+        if (!(extent > 0.0f)) {
+            continue;
+        }
+        f32 bin_scale = (f32)BVH_BIN_COUNT / extent;
+        
+        u32 bin_counts[BVH_BIN_COUNT] = {};
+        V3 bin_min[BVH_BIN_COUNT];
+        V3 bin_max[BVH_BIN_COUNT];
+        for (u32 bin = 0; bin < BVH_BIN_COUNT; ++bin) {
+            bin_min[bin] = v3(F32_MAX, F32_MAX, F32_MAX);
+            bin_max[bin] = v3(F32_MIN, F32_MIN, F32_MIN);
+        }
+        for (u32 i = 0; i < count; ++i) {
+            u32 bin = get_bvh_bin(build->centroids[indices[i]][axis], centroid_min[axis], bin_scale);
+            Rect3 triangle_bounds = build->triangle_bounds[indices[i]];
+            ++bin_counts[bin];
+            bin_min[bin] = min(bin_min[bin], triangle_bounds.min);
+            bin_max[bin] = max(bin_max[bin], triangle_bounds.max);
+        }
+        
+        // NOTE: right_costs[split] is for bins [split, BVH_BIN_COUNT).
+        f32 right_costs[BVH_BIN_COUNT];
+        u32 right_count = 0;
+        V3 right_min = v3(F32_MAX, F32_MAX, F32_MAX);
+        V3 right_max = v3(F32_MIN, F32_MIN, F32_MIN);
+        for (u32 split = BVH_BIN_COUNT - 1; split > 0; --split) {
+            right_count += bin_counts[split];
+            right_min = min(right_min, bin_min[split]);
+            right_max = max(right_max, bin_max[split]);
+            right_costs[split] = right_count ? get_half_area(right_max - right_min)*(f32)right_count : 0.0f;
+        }
+        
+        u32 left_count = 0;
+        V3 left_min = v3(F32_MAX, F32_MAX, F32_MAX);
+        V3 left_max = v3(F32_MIN, F32_MIN, F32_MIN);
+        for (u32 split = 1; split < BVH_BIN_COUNT; ++split) {
+            left_count += bin_counts[split - 1];
+            left_min = min(left_min, bin_min[split - 1]);
+            left_max = max(left_max, bin_max[split - 1]);
+            if (!left_count || (left_count == count)) {
+                continue;
+            }
+            
+            f32 cost = get_half_area(left_max - left_min)*(f32)left_count + right_costs[split];
+            if (cost < best_cost) {
+                best_cost  = cost;
+                best_axis  = axis;
+                best_split = split;
+            }
+        }
+    }
+    
+    u32 left_count = 0;
+    if (best_cost < F32_MAX) {
+        f32 node_area = get_half_area(bounds_max - bounds_min);
+        f32 split_cost = BVH_TRAVERSAL_COST + ((node_area > 0.0f) ? best_cost / node_area : (f32)count);
+        if ((count <= BVH_MAX_LEAF_SIZE) && ((f32)count <= split_cost)) {
+            return;
+        }
+        
+        f32 bin_scale = (f32)BVH_BIN_COUNT / (centroid_max[best_axis] - centroid_min[best_axis]);
+        u32 i = 0;
+        u32 j = count;
+        while (i < j) {
+            if (get_bvh_bin(build->centroids[indices[i]][best_axis], centroid_min[best_axis], bin_scale) < best_split) {
+                ++i;
+            } else {
+                --j;
+                Swap(indices[i], indices[j]);
+            }
+        }
+        left_count = i;
+    } else if (count <= BVH_MAX_LEAF_SIZE) {
+        return;
+    } else {
+        // NOTE: Every centroid is in the same place, so any split is as good as another.
+        left_count = count / 2;
+    }
+    
+    u32 left = (u32)buf_len(*nodes);
+    BVH_Node empty = {};
+    buf_push(*nodes, empty);
+    buf_push(*nodes, empty);
+    
+    node = *nodes + node_index;
+    node->first = left;
+    node->count = 0;
+    
+    build_bvh_node(build, nodes, left,     first,              left_count,         depth + 1);
+    build_bvh_node(build, nodes, left + 1, first + left_count, count - left_count, depth + 1);
+}
+
+internal void bvh_subtree_job(void* user_data, u32 job_index, u32 worker_index) {
+    BVH_Build* build = (BVH_Build*)user_data;
+    BVH_Subtree* subtree = build->subtrees + job_index;
+    
+    // NOTE: A copy, so the subtree doesn't split itself up again.
+    BVH_Build subtree_build = *build;
+    subtree_build.subtree_depth = 0xFFFFFFFF;
+    
+    BVH_Node root = {};
+    buf_push(subtree->nodes, root);
+    build_bvh_node(&subtree_build, &subtree->nodes, 0, subtree->first, subtree->count, build->subtree_depth);
+}
+
+// NOTE: pool can be 0 to build on this thread. The mesh has to outlive the result, which is
+// freed with free_bvh.
+function
+BVH build_bvh(Mesh* mesh, Job_Pool* pool) {
+    BVH result = {};
+    if (!mesh->triangle_count) {
+        return result;
+    }
+    
+    BVH_Build build = {};
+    build.mesh            = mesh;
+    build.triangle_bounds = (Rect3*)malloc(sizeof(Rect3)*(umm)mesh->triangle_count);
+    build.centroids       = (V3*)malloc(sizeof(V3)*(umm)mesh->triangle_count);
+    build.indices         = (u32*)malloc(sizeof(u32)*(umm)mesh->triangle_count);
+    build.subtree_depth   = 0xFFFFFFFF;
+    for (u32 i = 0; i < mesh->triangle_count; ++i) {
+        build.indices[i] = i;
+    }
+    
+    u32 bounds_job_count = (mesh->triangle_count + BVH_BOUNDS_BATCH - 1) / BVH_BOUNDS_BATCH;
+    if (pool) {
+        parallel_for(pool, bounds_job_count, bvh_bounds_job, &build);
+        
+        // NOTE: Enough subtrees to keep every worker busy even when they come out uneven.
+        build.subtree_depth = 0;
+        while ((1u << build.subtree_depth) < BVH_SUBTREES_PER_WORKER*pool->worker_count) {
+            ++build.subtree_depth;
+        }
+    } else {
+        for (u32 job_index = 0; job_index < bounds_job_count; ++job_index) {
+            bvh_bounds_job(&build, job_index, 0);
+        }
+    }
+    
+    BVH_Node* nodes = 0;
+    BVH_Node root = {};
+    buf_push(nodes, root);
+    build_bvh_node(&build, &nodes, 0, 0, mesh->triangle_count, 0);
+    
+    u32 subtree_count = (u32)buf_len(build.subtrees);
+    if (subtree_count) {
+        parallel_for(pool, subtree_count, bvh_subtree_job, &build);
+        
+        // NOTE: Each subtree's root takes the place left for it, and the rest goes on the end,
+        // shifted down one since its root isn't there.
+        for (u32 subtree_index = 0; subtree_index < subtree_count; ++subtree_index) {
+            BVH_Subtree* subtree = build.subtrees + subtree_index;
+            u32 offset = (u32)buf_len(nodes) - 1;
+            for (u32 i = 0; i < buf_len(subtree->nodes); ++i) {
+                BVH_Node node = subtree->nodes[i];
+                if (!node.count) {
+                    node.first += offset;
+                }
+                if (i == 0) {
+                    nodes[subtree->node_index] = node;
+                } else {
+                    buf_push(nodes, node);
+                }
+            }
+            buf_free(subtree->nodes);
+        }
+    }
+    
+    result.node_count       = (u32)buf_len(nodes);
+    result.nodes            = (BVH_Node*)malloc(sizeof(BVH_Node)*(umm)result.node_count);
+    result.triangle_count   = mesh->triangle_count;
+    result.triangle_indices = build.indices;
+    memcpy(result.nodes, nodes, sizeof(BVH_Node)*(umm)result.node_count);
+    
+    buf_free(nodes);
+    buf_free(build.subtrees);
+    free(build.centroids);
+    free(build.triangle_bounds);
+    return result;
+}
+
+function
+void free_bvh(BVH* bvh) {
+    free(bvh->nodes);
+    free(bvh->triangle_indices);
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+//
+// NOTE: Ray casts
+//
+
+// NOTE: Where the ray enters the node's box, if it does before max_t. inverse_direction can
+// have infinities for axis aligned rays, the comparisons still come out right unless the
+// origin is exactly on a slab.
+internal b32 intersect_bvh_node(BVH_Node* node, V3 origin, V3 inverse_direction, f32 max_t, f32* t) {
+    f32 t_enter = 0.0f;
+    f32 t_exit  = max_t;
+    for (u32 axis = 0; axis < 3; ++axis) {
+        f32 t0 = (node->min[axis] - origin[axis])*inverse_direction[axis];
+        f32 t1 = (node->max[axis] - origin[axis])*inverse_direction[axis];
+        t_enter = Max(t_enter, Min(t0, t1));
+        t_exit  = Min(t_exit,  Max(t0, t1));
+    }
+    
+    b32 result = (t_enter <= t_exit);
+    *t = t_enter;
+    return result;
+}
+
+// NOTE: Möller-Trumbore, both sides count.
+internal b32 intersect_triangle(V3 origin, V3 direction, V3 p0, V3 p1, V3 p2, f32 max_t, BVH_Hit* hit) {
+    V3 edge1 = p1 - p0;
+    V3 edge2 = p2 - p0;
+    V3 p = cross(direction, edge2);
+    f32 det = dot(edge1, p);
+    if (det == 0.0f) {
+        return false;
+    }
+    
+    f32 one_over_det = 1.0f / det;
+    V3 s = origin - p0;
+    f32 u = dot(s, p)*one_over_det;
+    if ((u < 0.0f) || (u > 1.0f)) {
+        return false;
+    }
+    
+    V3 q = cross(s, edge1);
+    f32 v = dot(direction, q)*one_over_det;
+    if ((v < 0.0f) || (u + v > 1.0f)) {
+        return false;
+    }
+    
+    f32 t = dot(edge2, q)*one_over_det;
+    if (!((t >= 0.0f) && (t < max_t))) {
+        return false;
+    }
+    
+    hit->t = t;
+    hit->u = u;
+    hit->v = v;
+    return true;
+}
+
+// NOTE: The closest hit along origin + t*direction for t in [0, max_t). Children are visited
+// nearest first, so most far boxes get skipped once something's been hit.
+function
+b32 intersect_bvh(BVH* bvh, Mesh* mesh, V3 origin, V3 direction, f32 max_t, BVH_Hit* hit) {
+    b32 result = false;
+    if (!bvh->node_count) {
+        return result;
+    }
+    
+    V3 inverse_direction = v3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    f32 closest = max_t;
+    
+    u32 stack[BVH_MAX_DEPTH];
+    u32 stack_count = 0;
+    f32 root_t;
+    if (intersect_bvh_node(bvh->nodes, origin, inverse_direction, closest, &root_t)) {
+        stack[stack_count++] = 0;
+    }
+    
+    while (stack_count) {
+        BVH_Node* node = bvh->nodes + stack[--stack_count];
+        if (node->count) {
+            for (u32 i = 0; i < node->count; ++i) {
+                u32 triangle_index = bvh->triangle_indices[node->first + i];
+                Triangle* triangle = mesh->triangles + triangle_index;
+                if (intersect_triangle(origin, direction, mesh->vertices[triangle->a], mesh->vertices[triangle->b],
+                                       mesh->vertices[triangle->c], closest, hit)) {
+                    hit->triangle_index = triangle_index;
+                    closest = hit->t;
+                    result = true;
+                }
+            }
+            continue;
+        }
+        
+        u32 near_child = node->first;
+        u32 far_child  = node->first + 1;
+        f32 near_t, far_t;
+        b32 near_hit = intersect_bvh_node(bvh->nodes + near_child, origin, inverse_direction, closest, &near_t);
+        b32 far_hit  = intersect_bvh_node(bvh->nodes + far_child,  origin, inverse_direction, closest, &far_t);
+        if (near_hit && far_hit && (far_t < near_t)) {
+            Swap(near_child, far_child);
+        }
+        
+        // NOTE: Pushed far first, so near comes off first. Far gets tested again against
+        // closest when it comes off, through its children or triangles.
+        Assert(stack_count + 2 <= BVH_MAX_DEPTH);
+        if (near_hit && far_hit) {
+            stack[stack_count++] = far_child;
+            stack[stack_count++] = near_child;
+        } else if (near_hit) {
+            stack[stack_count++] = near_child;
+        } else if (far_hit) {
+            stack[stack_count++] = far_child;
+        }
+    }
+    
+    return result;
+}
+
+//
+// NOTE: Frustum culling
+//
+
+// NOTE: Appends the triangles of every leaf that might be inside to out, which needs room for
+// all of them, and returns how many. Once a node is all inside a plane its children skip it.
+function
+u32 get_bvh_triangles_in_frustum(BVH* bvh, Frustum* frustum, u32* out) {
+    u32 result = 0;
+    if (!bvh->node_count) {
+        return result;
+    }
+    
+    // NOTE: Each entry is a node and a mask of the planes it's still not all inside.
+    u32 all_planes = (1 << ArrayCount(frustum->planes)) - 1;
+    u32 stack_nodes[BVH_MAX_DEPTH];
+    u32 stack_masks[BVH_MAX_DEPTH];
+    u32 stack_count = 0;
+    stack_nodes[stack_count] = 0;
+    stack_masks[stack_count] = all_planes;
+    ++stack_count;
+    
+    while (stack_count) {
+        --stack_count;
+        BVH_Node* node = bvh->nodes + stack_nodes[stack_count];
+        u32 mask = stack_masks[stack_count];
+        
+        // NOTE: The corner furthest along each plane's normal decides if the box is all
+        // outside, the nearest one if it's all inside.
+        b32 outside = false;
+        for (u32 plane_index = 0; plane_index < ArrayCount(frustum->planes); ++plane_index) {
+            if (!(mask & (1 << plane_index))) {
+                continue;
+            }
+            
+            V4 plane = frustum->planes[plane_index];
+            f32 furthest = plane.w;
+            f32 nearest  = plane.w;
+            for (u32 axis = 0; axis < 3; ++axis) {
+                furthest += plane[axis]*((plane[axis] > 0.0f) ? node->max[axis] : node->min[axis]);
+                nearest  += plane[axis]*((plane[axis] > 0.0f) ? node->min[axis] : node->max[axis]);
+            }
+            if (furthest < 0.0f) {
+                outside = true;
+                break;
+            }
+            if (nearest >= 0.0f) {
+                mask &= ~(1 << plane_index);
+            }
+        }
+        if (outside) {
+            continue;
+        }
+        
+        if (node->count) {
+            memcpy(out + result, bvh->triangle_indices + node->first, sizeof(u32)*node->count);
+            result += node->count;
+        } else {
+            Assert(stack_count + 2 <= BVH_MAX_DEPTH);
+            for (u32 child = 0; child < 2; ++child) {
+                stack_nodes[stack_count] = node->first + child;
+                stack_masks[stack_count] = mask;
+                ++stack_count;
+            }
+        }
+    }
+    
+    return result;
+}
@@ -0,0 +1,62 @@
+/* date = October 20th 2026 12:30 am */
+
+#ifndef BVH_H
+#define BVH_H
+
+//
+// NOTE: Bounding volume hierarchies over a mesh's triangles, for ray casts and for culling
+// groups of triangles against a frustum without going over all of them.
+//
+// The build splits top down, binning the triangles' centroids along each axis and taking the
+// split with the lowest surface area heuristic cost, or making a leaf when that's cheaper.
+// With a Job_Pool the top few levels are split on the calling thread and the subtrees under
+// them are built by jobs, then stitched into one array. Nodes are flattened depth first,
+// with the two children of a node next to each other, and each leaf's triangles are a
+// contiguous run of triangle_indices.
+//
+
+// NOTE: Centroid bins per axis when looking for a split.
+#define BVH_BIN_COUNT 16
+
+// NOTE: Leaves hold at most this many triangles.
+#define BVH_MAX_LEAF_SIZE 8
+
+// NOTE: The cost of visiting a node, relative to testing a triangle.
+#define BVH_TRAVERSAL_COST 1.0f
+
+// NOTE: Triangles per job when finding their bounds, and subtree jobs per worker.
+#define BVH_BOUNDS_BATCH 4096
+#define BVH_SUBTREES_PER_WORKER 4
+
+// NOTE: Subtrees smaller than this are built wherever they're reached instead of by a job.
+#define BVH_MIN_SUBTREE_SIZE 1024
+
+// NOTE: Nodes this deep are leaves however many triangles they have, so traversal stacks,
+// which hold at most one node per level plus one, can be this big.
+#define BVH_MAX_DEPTH 64
+
+// NOTE: 32 bytes, two to a cache line.
+typedef struct BVH_Node {
+    f32 min[3];
+    u32 first; // NOTE: Leaves, the first of their triangles in triangle_indices. Inner nodes, the
+               // left child, with the right one after it.
+    f32 max[3];
+    u32 count; // NOTE: Leaves, how many triangles. Inner nodes, 0.
+} BVH_Node;
+
+typedef struct BVH {
+    u32 node_count;
+    BVH_Node* nodes; // NOTE: nodes[0] is the root, unless the mesh is empty.
+    
+    u32 triangle_count;
+    u32* triangle_indices; // NOTE: Into the mesh's triangles, in leaf order.
+} BVH;
+
+typedef struct BVH_Hit {
+    f32 t;
+    u32 triangle_index;
+    f32 u; // NOTE: Barycentric weights of the triangle's b and c.
+    f32 v;
+} BVH_Hit;
+
+#endif //BVH_H
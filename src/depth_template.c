@@ -0,0 +1,66 @@
+//
+// NOTE: Stamps out a depth only pipeline, a function
+//     void PIPELINE_NAME(Image_f32* depth, PIPELINE_UNIFORMS* uniforms, u32 triangle_count);
+// Define these and include this file:
+//     PIPELINE_NAME
+//     PIPELINE_UNIFORMS
+//     PIPELINE_VERTEX_SHADER    Only the position is used
+// It's for shadow maps and depth prepasses. There's no color, no varyings and no fragment
+// shader, just a less than depth test and write, four pixels per step. The depths come out
+// the same as from the other pipelines for the same positions.
+//
+
+#if !defined(PIPELINE_NAME) || !defined(PIPELINE_UNIFORMS) || !defined(PIPELINE_VERTEX_SHADER)
+#error "A depth only pipeline needs all its parameters defined before including depth_template.c"
+#endif
+
+function
+void PIPELINE_NAME(Image_f32* depth, PIPELINE_UNIFORMS* uniforms, u32 triangle_count) {
+    for (u32 triangle_index = 0; triangle_index < triangle_count; ++triangle_index) {
+        Raster_Vertex vertices[3];
+        for (u32 corner = 0; corner < 3; ++corner) {
+            PIPELINE_VERTEX_SHADER(uniforms, triangle_index, corner, &vertices[corner]);
+        }
+        
+        Raster_Vertex clipped[4];
+        u32 clipped_count = clip_to_near_plane(&vertices[0], &vertices[1], &vertices[2], 0, clipped);
+        for (u32 fan_index = 2; fan_index < clipped_count; ++fan_index) {
+            Triangle_Setup setup;
+            if (!setup_triangle(&setup, &clipped[0], &clipped[fan_index - 1], &clipped[fan_index], 0, depth->width, depth->height)) {
+                continue;
+            }
+            
+            for (s32 y = setup.bounds.min.y; y < setup.bounds.max.y; ++y) {
+                s32 span_begin, span_end;
+                if (!get_span(&setup, y, &span_begin, &span_end)) {
+                    continue;
+                }
+                
+                Varying_Stepper stepper;
+                begin_varyings(&stepper, &setup, span_begin, y);
+                
+                f32* depth_row = get_pixel_pointer(depth, 0, y);
+                s32 x = span_begin;
+                for (; x + 4 <= span_end; x += 4) {
+                    // NOTE: min is the test and the write in one, a tie writes the same value.
+                    __m128 old_depth = _mm_loadu_ps(depth_row + x);
+                    _mm_storeu_ps(depth_row + x, _mm_min_ps(get_depths(&stepper, &setup, 4), old_depth));
+                    step_varyings(&stepper, &setup, 4);
+                }
+                
+                if (x < span_end) {
+                    u32 count = span_end - x;
+                    f32 new_depth[4];
+                    _mm_storeu_ps(new_depth, get_depths(&stepper, &setup, count));
+                    for (u32 i = 0; i < count; ++i) {
+                        depth_row[x + i] = Min(depth_row[x + i], new_depth[i]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+#undef PIPELINE_NAME
+#undef PIPELINE_UNIFORMS
+#undef PIPELINE_VERTEX_SHADER
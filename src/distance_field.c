@@ -0,0 +1,755 @@
+function
+u32 u32_log2(u32 n) {
+    // https://stackoverflow.com/questions/994593/how-to-do-an-integer-log2-in-c
+#define S(k) if (n >= (1 << k)) { i += k; n >>= k; }
+    u32 i = -(n == 0);
+    S(16); S(8); S(4); S(2); S(1);
+    return i;
+#undef S
+}
+
+//
+// NOTE: Jump flooding. Seeds are stored as (x + 1, y + 1) in the bg / ra halves of the
+// pixel so that zero can mean "no seed found yet", which caps the size at 65535 - 1.
+//
+
+// NOTE: Keeps pixel as the closest seed to (x, y) if it beats the best one so far.
+internal void consider_seed(Color_ARGB pixel, u32 x, u32 y, V2* edge_points, u32 width, Color_ARGB* closest, f32* closest_distance) {
+    if (pixel.argb) {
+        u32 seed_x = (u32)pixel.bg - 1;
+        u32 seed_y = (u32)pixel.ra - 1;
+        V2 seed = edge_points ? edge_points[seed_y*width + seed_x] : v2((f32)seed_x, (f32)seed_y);
+        f32 diff_x = seed.x - (f32)x;
+        f32 diff_y = seed.y - (f32)y;
+        f32 distance_sq = diff_x*diff_x + diff_y*diff_y;
+        if (*closest_distance > distance_sq) {
+            *closest_distance = distance_sq;
+            *closest = pixel;
+        }
+    }
+}
+
+// NOTE: Runs the flood over an already seeded image. If edge_points is given, a seed at (x, y)
+// stands for the sub-pixel edge position edge_points[y*width + x] rather than its pixel center.
+// scratch has to be the same size as seeds, its contents don't matter.
+function
+void jump_flood(Image_u32* seeds, V2* edge_points, Image_u32* scratch) {
+    Image_u32* image_read  = seeds;
+    Image_u32* image_write = scratch;
+    
+    u32 N = Max(seeds->width, seeds->height);
+    u32 N_log2 = u32_log2(N);
+    for (u32 pass_index = 0; pass_index < N_log2; ++pass_index) {
+        s32 offset = (s32)(1 << (N_log2 - pass_index - 1));
+        
+        V2i pairs[] = {
+            { -offset, -offset }, { 0, -offset }, { offset, -offset },
+            { -offset, 0       }, { 0, 0       }, { offset, 0       },
+            { -offset, offset  }, { 0, offset  }, { offset, offset  },
+        };
+        
+        for (u32 y = 0; y < image_read->height; ++y) {
+            for (u32 x = 0; x < image_read->width; ++x) {
+                f32 closest_distance = F32_MAX;
+                Color_ARGB closest = {};
+                
+                for (u32 pair_index = 0; pair_index < 9; ++pair_index) {
+                    s32 read_x = (s32)x + pairs[pair_index].x;
+                    s32 read_y = (s32)y + pairs[pair_index].y;
+                    if (read_x < 0)                        { read_x = 0; }
+                    if (read_x >= (s32)image_read->width)  { read_x = image_read->width - 1; }
+                    if (read_y < 0)                        { read_y = 0; }
+                    if (read_y >= (s32)image_read->height) { read_y = image_read->height - 1; }
+                    
+                    Color_ARGB pixel = { .argb = get_pixel(image_read, read_x, read_y) };
+                    consider_seed(pixel, x, y, edge_points, seeds->width, &closest, &closest_distance);
+                }
+                
+                // NOTE: The center tap is always among the candidates, so every pixel gets written
+                // and there's no need to copy the read image over before swapping.
+                set_pixel(image_write, x, y, closest);
+            }
+        }
+        
+        Swap(image_read, image_write);
+    }
+    
+    if (image_read != seeds) {
+        copy_image(image_read, seeds);
+    }
+}
+
+// NOTE: The same flood over a tiled image. Pixels are visited a tile at a time, so most taps
+// of the short passes land in tiles that are already in cache, where the linear layout
+// misses on every row above and below.
+function
+void jump_flood(Tiled_Image_u32* seeds, V2* edge_points, Tiled_Image_u32* scratch) {
+    Tiled_Image_u32* image_read  = seeds;
+    Tiled_Image_u32* image_write = scratch;
+    
+    u32 N = Max(seeds->width, seeds->height);
+    u32 N_log2 = u32_log2(N);
+    for (u32 pass_index = 0; pass_index < N_log2; ++pass_index) {
+        s32 offset = (s32)(1 << (N_log2 - pass_index - 1));
+        
+        V2i pairs[] = {
+            { -offset, -offset }, { 0, -offset }, { offset, -offset },
+            { -offset, 0       }, { 0, 0       }, { offset, 0       },
+            { -offset, offset  }, { 0, offset  }, { offset, offset  },
+        };
+        
+        for (u32 tile_y = 0; tile_y < seeds->tiles_y; ++tile_y) {
+            for (u32 tile_x = 0; tile_x < seeds->tiles_x; ++tile_x) {
+                u32* write_tile = get_tile_pointer(image_write, tile_x, tile_y);
+                u32 tile_width, tile_height;
+                get_tile_extent(seeds, tile_x, tile_y, &tile_width, &tile_height);
+                
+                for (u32 row = 0; row < tile_height; ++row) {
+                    for (u32 column = 0; column < tile_width; ++column) {
+                        u32 x = (tile_x << IMAGE_TILE_SHIFT) + column;
+                        u32 y = (tile_y << IMAGE_TILE_SHIFT) + row;
+                        
+                        f32 closest_distance = F32_MAX;
+                        Color_ARGB closest = {};
+                        
+                        for (u32 pair_index = 0; pair_index < 9; ++pair_index) {
+                            s32 read_x = Clamp((s32)x + pairs[pair_index].x, 0, (s32)seeds->width  - 1);
+                            s32 read_y = Clamp((s32)y + pairs[pair_index].y, 0, (s32)seeds->height - 1);
+                            
+                            Color_ARGB pixel = { .argb = get_pixel(image_read, read_x, read_y) };
+                            consider_seed(pixel, x, y, edge_points, seeds->width, &closest, &closest_distance);
+                        }
+                        
+                        write_tile[(row << IMAGE_TILE_SHIFT) + column] = closest.argb;
+                    }
+                }
+            }
+        }
+        
+        Swap(image_read, image_write);
+    }
+    
+    if (image_read != seeds) {
+        memcpy(seeds->pixels, image_read->pixels, sizeof(u32)*IMAGE_TILE_PIXELS*(umm)seeds->tiles_x*seeds->tiles_y);
+    }
+}
+
+function
+void jump_flood(Image_u32* seeds, V2* edge_points) {
+    Image_u32 scratch = allocate_image(seeds->width, seeds->height);
+    jump_flood(seeds, edge_points, &scratch);
+    free_image(&scratch);
+}
+
+function
+void seed_nearest_seed_map(Image_u32* src, DistanceFieldType type, Image_u32* result) {
+    for (u32 y = 0; y < result->height; ++y) {
+        for (u32 x = 0; x < result->width; ++x) {
+            Color_ARGB pixel = (Color_ARGB) { .argb = get_pixel(src, x, y) };
+            if (((type == DistanceField_Outer) && (pixel.a > 127)) ||
+                ((type == DistanceField_Inner) && (pixel.a <= 127)))
+            {
+                set_pixel(result, x, y, (Color_ARGB) { .bg = x + 1, .ra = y + 1 });
+            } else {
+                set_pixel(result, x, y, (Color_ARGB) {});
+            }
+        }
+    }
+}
+
+// NOTE: With a pool, the result and the flood scratch come from it and the result goes back with release_image.
+function
+Image_u32 produce_nearest_seed_map(Image_u32* src, DistanceFieldType type, Image_Pool* pool) {
+    Image_u32 result  = acquire_image(pool, src->width, src->height);
+    Image_u32 scratch = acquire_image(pool, src->width, src->height);
+    seed_nearest_seed_map(src, type, &result);
+    jump_flood(&result, 0, &scratch);
+    release_image(pool, &scratch);
+    return result;
+}
+
+function
+Image_u32 produce_nearest_seed_map(Image_u32* src, DistanceFieldType type) {
+    Image_u32 result = produce_nearest_seed_map(src, type, 0);
+    return result;
+}
+
+function
+f32 get_seed_distance(Image_u32* seeds, u32 x, u32 y) {
+    f32 result = F32_MAX;
+    
+    Color_ARGB pixel = { .argb = get_pixel(seeds, x, y) };
+    if (pixel.argb) {
+        s32 diff_x = (s32)pixel.bg - 1 - (s32)x;
+        s32 diff_y = (s32)pixel.ra - 1 - (s32)y;
+        result = sqrtf((f32)(diff_x*diff_x + diff_y*diff_y));
+    }
+    
+    return result;
+}
+
+function
+Image_u32 produce_distance_field(Image_u32* src, u32 bullshit_multiplier, DistanceFieldType type, Image_Pool* pool) {
+    Image_u32 result = produce_nearest_seed_map(src, type, pool);
+    
+    u32 N = Max(src->width, src->height);
+    for (u32 y = 0; y < result.height; ++y) {
+        for (u32 x = 0; x < result.width; ++x) {
+            f32 distance = get_seed_distance(&result, x, y);
+            s32 write_distance = 255;
+            if (distance < (f32)N) {
+                write_distance = bullshit_multiplier*(u32)(255*(distance / (f32)N));
+            }
+            if (write_distance < 0)   { write_distance = 0; }
+            if (write_distance > 255) { write_distance = 255; }
+            write_distance = (255 - write_distance);
+            // NOTE: Each seed is only read at its own position, so overwriting in place is fine.
+            set_pixel(&result, x, y, rgb(write_distance, write_distance, write_distance));
+        }
+    }
+    
+    return result;
+}
+
+function
+Image_u32 produce_distance_field(Image_u32* src, u32 bullshit_multiplier, DistanceFieldType type) {
+    Image_u32 result = produce_distance_field(src, bullshit_multiplier, type, 0);
+    return result;
+}
+
+function
+Image_u32 produce_signed_distance_field(Image_u32* src, u32 bullshit_multiplier, Image_Pool* pool) {
+    Image_u32 positive_distance_field = produce_distance_field(src, 8, DistanceField_Outer, pool);
+    Image_u32 negative_distance_field = produce_distance_field(src, 8, DistanceField_Inner, pool);
+    
+    for (u32 y = 0; y < positive_distance_field.height; ++y) {
+        for (u32 x = 0; x < positive_distance_field.width; ++x) {
+            u8 positive = (Color_ARGB) { .argb = get_pixel(&positive_distance_field, x, y) }.r;
+            u8 negative = (Color_ARGB) { .argb = get_pixel(&negative_distance_field, x, y) }.r;
+            u8 combined = (255 - positive) / 2 + negative / 2;
+            // NOTE: We're overwriting the contents of positive_distance_field, but this is fine because we're not reading from this position again
+            set_pixel(&positive_distance_field, x, y, (Color_ARGB) { .r = combined, .g = combined, .b = combined, .a = 255 });
+        }
+    }
+    
+    release_image(pool, &negative_distance_field);
+    
+    return positive_distance_field;
+}
+
+function
+Image_u32 produce_signed_distance_field(Image_u32* src, u32 bullshit_multiplier) {
+    Image_u32 result = produce_signed_distance_field(src, bullshit_multiplier, 0);
+    return result;
+}
+
+//
+// NOTE: Anti-aliased seeding, after Gustavson & Strand's anti-aliased euclidean distance transform.
+// Instead of thresholding alpha at 127, every pixel on the boundary becomes a seed and gets a
+// sub-pixel edge position estimated from its coverage and the local alpha gradient. Only one
+// flood is needed since the sign comes straight from the coverage of the pixel itself.
+//
+
+function
+f32 get_alpha(Image_u32* src, s32 x, s32 y) {
+    x = Clamp(x, 0, (s32)src->width - 1);
+    y = Clamp(y, 0, (s32)src->height - 1);
+    f32 result = (f32)((Color_ARGB) { .argb = get_pixel(src, x, y) }.a) / 255.0f;
+    return result;
+}
+
+function
+V2 estimate_alpha_gradient(Image_u32* src, s32 x, s32 y) {
+    f32 sqrt2 = 1.41421356f;
+    
+    f32 gx = -      get_alpha(src, x - 1, y - 1) +       get_alpha(src, x + 1, y - 1)
+             - sqrt2*get_alpha(src, x - 1, y    ) + sqrt2*get_alpha(src, x + 1, y    )
+             -       get_alpha(src, x - 1, y + 1) +       get_alpha(src, x + 1, y + 1);
+    f32 gy = -      get_alpha(src, x - 1, y - 1) +       get_alpha(src, x - 1, y + 1)
+             - sqrt2*get_alpha(src, x    , y - 1) + sqrt2*get_alpha(src, x    , y + 1)
+             -       get_alpha(src, x + 1, y - 1) +       get_alpha(src, x + 1, y + 1);
+    
+    V2 result = noz(v2(gx, gy));
+    return result;
+}
+
+// NOTE: Distance from the pixel center to the edge along the (normalized) gradient, assuming
+// the edge is a straight line through the pixel and alpha is its exact area coverage.
+function
+f32 estimate_edge_distance(V2 gradient, f32 alpha) {
+    f32 result;
+    
+    f32 gx = abs(gradient.x);
+    f32 gy = abs(gradient.y);
+    if ((gx == 0.0f) || (gy == 0.0f)) {
+        result = 0.5f - alpha;
+    } else {
+        if (gx < gy) {
+            Swap(gx, gy);
+        }
+        f32 a1 = 0.5f*gy / gx;
+        if (alpha < a1) {
+            result = 0.5f*(gx + gy) - sqrtf(2.0f*gx*gy*alpha);
+        } else if (alpha < (1.0f - a1)) {
+            result = (0.5f - alpha)*gx;
+        } else {
+            result = -0.5f*(gx + gy) + sqrtf(2.0f*gx*gy*(1.0f - alpha));
+        }
+    }
+    
+    return result;
+}
+
+function
+void seed_nearest_edge_map(Image_u32* src, V2* edge_points, Image_u32* result) {
+    for (s32 y = 0; y < (s32)result->height; ++y) {
+        for (s32 x = 0; x < (s32)result->width; ++x) {
+            f32 alpha  = get_alpha(src, x, y);
+            b32 inside = (alpha >= 0.5f);
+            
+            // NOTE: Partially covered pixels are always on the edge. Fully covered or empty
+            // pixels are only on it if a neighbour falls on the other side.
+            b32 is_edge = (alpha > 0.0f) && (alpha < 1.0f);
+            if (!is_edge) {
+                is_edge = (((x > 0)                         && ((get_alpha(src, x - 1, y) >= 0.5f) != inside)) ||
+                           ((x < (s32)result->width - 1)  && ((get_alpha(src, x + 1, y) >= 0.5f) != inside)) ||
+                           ((y > 0)                         && ((get_alpha(src, x, y - 1) >= 0.5f) != inside)) ||
+                           ((y < (s32)result->height - 1) && ((get_alpha(src, x, y + 1) >= 0.5f) != inside)));
+            }
+            
+            if (is_edge) {
+                V2 gradient = estimate_alpha_gradient(src, x, y);
+                f32 edge_distance = estimate_edge_distance(gradient, alpha);
+                edge_points[y*result->width + x] = v2((f32)x, (f32)y) + edge_distance*gradient;
+                set_pixel(result, x, y, (Color_ARGB) { .bg = x + 1, .ra = y + 1 });
+            } else {
+                set_pixel(result, x, y, (Color_ARGB) {});
+            }
+        }
+    }
+}
+
+function
+Image_u32 produce_nearest_edge_map(Image_u32* src, V2* edge_points) {
+    Image_u32 result = allocate_image(src->width, src->height);
+    seed_nearest_edge_map(src, edge_points, &result);
+    jump_flood(&result, edge_points);
+    return result;
+}
+
+//
+// NOTE: Scratch memory for the signed distance field producers, so batches of small fields can
+// reuse the same working buffers instead of allocating several images per field.
+//
+
+function
+void reserve_distance_field_scratch(Distance_Field_Scratch* scratch, u32 width, u32 height) {
+    u32 pixel_count = width*height;
+    if (scratch->capacity < pixel_count) {
+        free(scratch->outer);
+        free(scratch->inner);
+        free(scratch->flood);
+        free(scratch->edge_points);
+        scratch->capacity    = pixel_count;
+        scratch->outer       = (u32*)malloc(sizeof(u32)*pixel_count);
+        scratch->inner       = (u32*)malloc(sizeof(u32)*pixel_count);
+        scratch->flood       = (u32*)malloc(sizeof(u32)*pixel_count);
+        scratch->edge_points = (V2*)malloc(sizeof(V2)*pixel_count);
+    }
+}
+
+function
+void free_distance_field_scratch(Distance_Field_Scratch* scratch) {
+    free(scratch->outer);
+    free(scratch->inner);
+    free(scratch->flood);
+    free(scratch->edge_points);
+    memset(scratch, 0, sizeof(*scratch));
+}
+
+function
+Image_u32 get_scratch_image(u32* pixels, u32 width, u32 height) {
+    Image_u32 result = {};
+    result.width  = width;
+    result.height = height;
+    result.pitch  = width;
+    result.pixels = pixels;
+    return result;
+}
+
+//
+// NOTE: Compact single channel signed distance fields. These keep the full float distance
+// until the final write instead of combining two quantized 8 bit fields.
+// The sign convention is negative inside the shape, in pixels. The unorm encodings map
+// [spread, -spread] to [0, 1], so like produce_signed_distance_field the inside is bright
+// and the edge sits at 0.5.
+//
+
+// NOTE: With a scratch, the source lives in the scratch buffers and nothing gets allocated.
+function
+Signed_Distance_Source make_signed_distance_source(Image_u32* src, DistanceFieldSeeding seeding, Distance_Field_Scratch* scratch) {
+    Signed_Distance_Source source = {};
+    source.seeding = seeding;
+    source.src     = src;
+    
+    if (scratch) {
+        reserve_distance_field_scratch(scratch, src->width, src->height);
+        Image_u32 flood = get_scratch_image(scratch->flood, src->width, src->height);
+        
+        source.scratch     = scratch;
+        source.outer_seeds = get_scratch_image(scratch->outer, src->width, src->height);
+        switch (seeding) {
+            case DistanceFieldSeeding_Threshold: {
+                source.inner_seeds = get_scratch_image(scratch->inner, src->width, src->height);
+                seed_nearest_seed_map(src, DistanceField_Outer, &source.outer_seeds);
+                seed_nearest_seed_map(src, DistanceField_Inner, &source.inner_seeds);
+                jump_flood(&source.outer_seeds, 0, &flood);
+                jump_flood(&source.inner_seeds, 0, &flood);
+            } break;
+            
+            case DistanceFieldSeeding_AntiAliased: {
+                source.edge_points = scratch->edge_points;
+                seed_nearest_edge_map(src, source.edge_points, &source.outer_seeds);
+                jump_flood(&source.outer_seeds, source.edge_points, &flood);
+            } break;
+            
+            InvalidDefaultCase;
+        }
+    } else {
+        switch (seeding) {
+            case DistanceFieldSeeding_Threshold: {
+                source.outer_seeds = produce_nearest_seed_map(src, DistanceField_Outer);
+                source.inner_seeds = produce_nearest_seed_map(src, DistanceField_Inner);
+            } break;
+            
+            case DistanceFieldSeeding_AntiAliased: {
+                source.edge_points = (V2*)malloc(sizeof(V2)*src->width*src->height);
+                source.outer_seeds = produce_nearest_edge_map(src, source.edge_points);
+            } break;
+            
+            InvalidDefaultCase;
+        }
+    }
+    
+    return source;
+}
+
+function
+Signed_Distance_Source make_signed_distance_source(Image_u32* src, DistanceFieldSeeding seeding) {
+    Signed_Distance_Source source = make_signed_distance_source(src, seeding, 0);
+    return source;
+}
+
+function
+void free_signed_distance_source(Signed_Distance_Source* source) {
+    if (!source->scratch) {
+        free_image(&source->outer_seeds);
+        if (source->inner_seeds.pixels) {
+            free_image(&source->inner_seeds);
+        }
+        free(source->edge_points);
+    }
+    memset(source, 0, sizeof(*source));
+}
+
+function
+f32 get_signed_distance(Signed_Distance_Source* source, u32 x, u32 y) {
+    f32 result = 0.0f;
+    
+    switch (source->seeding) {
+        case DistanceFieldSeeding_Threshold: {
+            // NOTE: Seeds are pixel centers, the edge itself lies half a pixel further out.
+            f32 outer_distance = get_seed_distance(&source->outer_seeds, x, y);
+            if (outer_distance > 0.0f) {
+                result = outer_distance - 0.5f;
+            } else {
+                result = 0.5f - get_seed_distance(&source->inner_seeds, x, y);
+            }
+        } break;
+        
+        case DistanceFieldSeeding_AntiAliased: {
+            f32 distance = F32_MAX;
+            
+            Color_ARGB pixel = { .argb = get_pixel(&source->outer_seeds, x, y) };
+            if (pixel.argb) {
+                u32 seed_x = (u32)pixel.bg - 1;
+                u32 seed_y = (u32)pixel.ra - 1;
+                V2 edge_point = source->edge_points[seed_y*source->outer_seeds.width + seed_x];
+                distance = length(edge_point - v2((f32)x, (f32)y));
+            }
+            
+            b32 inside = (get_alpha(source->src, x, y) >= 0.5f);
+            result = inside ? -distance : distance;
+        } break;
+        
+        InvalidDefaultCase;
+    }
+    
+    return result;
+}
+
+function
+f32 encode_signed_distance_unorm(f32 signed_distance, f32 spread) {
+    f32 result = 0.5f - 0.5f*(signed_distance / spread);
+    result = clamp(result, 0.0f, 1.0f);
+    return result;
+}
+
+// NOTE: Writes the field for src into dst with its bottom left corner at (dst_x, dst_y).
+function
+void write_signed_distance_field(Image_u32* src, f32 spread, DistanceFieldSeeding seeding, Distance_Field_Scratch* scratch,
+                                 Image_u8* dst, u32 dst_x, u32 dst_y)
+{
+    Assert((dst_x + src->width  <= dst->width) &&
+           (dst_y + src->height <= dst->height));
+    
+    Signed_Distance_Source source = make_signed_distance_source(src, seeding, scratch);
+    
+    for (u32 y = 0; y < src->height; ++y) {
+        for (u32 x = 0; x < src->width; ++x) {
+            f32 distance = get_signed_distance(&source, x, y);
+            f32 encoded  = encode_signed_distance_unorm(distance, spread);
+            set_pixel(dst, dst_x + x, dst_y + y, (u8)(255.0f*encoded + 0.5f));
+        }
+    }
+    
+    free_signed_distance_source(&source);
+}
+
+function
+Image_u8 produce_signed_distance_field_u8(Image_u32* src, f32 spread, DistanceFieldSeeding seeding) {
+    Image_u8 result = allocate_image_u8(src->width, src->height);
+    write_signed_distance_field(src, spread, seeding, 0, &result, 0, 0);
+    return result;
+}
+
+function
+Image_u8 produce_signed_distance_field_u8(Image_u32* src, f32 spread) {
+    Image_u8 result = produce_signed_distance_field_u8(src, spread, DistanceFieldSeeding_Threshold);
+    return result;
+}
+
+function
+Image_u16 produce_signed_distance_field_u16(Image_u32* src, f32 spread, DistanceFieldSeeding seeding) {
+    Image_u16 result = allocate_image_u16(src->width, src->height);
+    
+    Signed_Distance_Source source = make_signed_distance_source(src, seeding);
+    
+    for (u32 y = 0; y < result.height; ++y) {
+        for (u32 x = 0; x < result.width; ++x) {
+            f32 distance = get_signed_distance(&source, x, y);
+            f32 encoded  = encode_signed_distance_unorm(distance, spread);
+            set_pixel(&result, x, y, (u16)(65535.0f*encoded + 0.5f));
+        }
+    }
+    
+    free_signed_distance_source(&source);
+    
+    return result;
+}
+
+function
+Image_u16 produce_signed_distance_field_u16(Image_u32* src, f32 spread) {
+    Image_u16 result = produce_signed_distance_field_u16(src, spread, DistanceFieldSeeding_Threshold);
+    return result;
+}
+
+// NOTE: Half floats have the range to store the raw signed distance in pixels, so there's no spread.
+function
+Image_f16 produce_signed_distance_field_f16(Image_u32* src, DistanceFieldSeeding seeding) {
+    Image_f16 result = allocate_image_f16(src->width, src->height);
+    
+    Signed_Distance_Source source = make_signed_distance_source(src, seeding);
+    
+    for (u32 y = 0; y < result.height; ++y) {
+        for (u32 x = 0; x < result.width; ++x) {
+            f32 distance = get_signed_distance(&source, x, y);
+            distance = clamp(distance, -65504.0f, 65504.0f);
+            set_pixel(&result, x, y, f32_to_f16(distance));
+        }
+    }
+    
+    free_signed_distance_source(&source);
+    
+    return result;
+}
+
+function
+Image_f16 produce_signed_distance_field_f16(Image_u32* src) {
+    Image_f16 result = produce_signed_distance_field_f16(src, DistanceFieldSeeding_Threshold);
+    return result;
+}
+
+//
+// NOTE: Tiled distance fields. The image is cut into tiles that are processed one at a time,
+// each over a window grown by the spread. Anything further than the spread from a pixel
+// clamps to the same value anyway, so the window is all a tile needs to see and the result
+// matches the whole-image path. The exception is the odd pixel where jump flooding misses its
+// nearest seed, which a window can miss differently, usually by a level or two of the 8 bit
+// output. Peak memory is a handful of window-sized buffers, the full image is never resident,
+// and seed coordinates stay window-local so the 16 bit packing no longer limits the image size.
+//
+
+function
+u32 get_tiled_distance_field_border(f32 spread) {
+    // NOTE: One pixel for the half pixel between seed and edge, one more for the gradient
+    // estimate used by anti-aliased seeding.
+    u32 result = (u32)ceil_f32_to_s32(spread) + 2;
+    return result;
+}
+
+function
+void produce_signed_distance_field_tiled(Tiled_Distance_Field_Desc* desc) {
+    u32 border      = get_tiled_distance_field_border(desc->spread);
+    u32 window_size = desc->tile_size + 2*border;
+    Assert(window_size < 65535);
+    
+    Image_u32 window_storage = allocate_image(window_size, window_size);
+    u8* alpha  = (u8*)malloc(window_size*window_size);
+    u8* result = (u8*)malloc(desc->tile_size*desc->tile_size);
+    
+    for (u32 tile_y = 0; tile_y < desc->height; tile_y += desc->tile_size) {
+        for (u32 tile_x = 0; tile_x < desc->width; tile_x += desc->tile_size) {
+            u32 tile_width  = Min(desc->tile_size, desc->width  - tile_x);
+            u32 tile_height = Min(desc->tile_size, desc->height - tile_y);
+            
+            u32 window_x0 = (tile_x > border) ? tile_x - border : 0;
+            u32 window_y0 = (tile_y > border) ? tile_y - border : 0;
+            u32 window_x1 = Min(tile_x + tile_width  + border, desc->width);
+            u32 window_y1 = Min(tile_y + tile_height + border, desc->height);
+            
+            // NOTE: The storage is big enough for the unclipped window.
+            Image_u32 window = get_sub_image(&window_storage, 0, 0, window_x1 - window_x0, window_y1 - window_y0);
+            
+            desc->read_alpha(desc->user_data, window_x0, window_y0, window.width, window.height, alpha, window.width);
+            for (u32 y = 0; y < window.height; ++y) {
+                for (u32 x = 0; x < window.width; ++x) {
+                    set_pixel(&window, x, y, (Color_ARGB) { .a = alpha[y*window.width + x] });
+                }
+            }
+            
+            Signed_Distance_Source source = make_signed_distance_source(&window, desc->seeding);
+            
+            u32 offset_x = tile_x - window_x0;
+            u32 offset_y = tile_y - window_y0;
+            for (u32 y = 0; y < tile_height; ++y) {
+                for (u32 x = 0; x < tile_width; ++x) {
+                    f32 distance = get_signed_distance(&source, offset_x + x, offset_y + y);
+                    f32 encoded  = encode_signed_distance_unorm(distance, desc->spread);
+                    result[y*tile_width + x] = (u8)(255.0f*encoded + 0.5f);
+                }
+            }
+            
+            free_signed_distance_source(&source);
+            
+            desc->write_tile(desc->user_data, tile_x, tile_y, tile_width, tile_height, result, tile_width);
+        }
+    }
+    
+    free_image(&window_storage);
+    free(alpha);
+    free(result);
+}
+
+//
+// NOTE: Source and sink helpers for the tiled path. Tiles arrive in row-major order, so the
+// BMP writer only needs to hold one band of tile rows at a time, and since BMP rows are
+// stored bottom-up just like our images each finished band can be appended straight away.
+//
+
+function
+void read_alpha_from_image(void* user_data, u32 x, u32 y, u32 width, u32 height, u8* dst, u32 dst_pitch) {
+    Tiled_Distance_Field_Io* io = (Tiled_Distance_Field_Io*)user_data;
+    for (u32 row = 0; row < height; ++row) {
+        for (u32 column = 0; column < width; ++column) {
+            dst[row*dst_pitch + column] = (Color_ARGB) { .argb = get_pixel(io->src_image, x + column, y + row) }.a;
+        }
+    }
+}
+
+// NOTE: Reads from a raw 8 bit alpha file with width bytes per row, so the source can be far
+// bigger than what fits in memory.
+function
+void read_alpha_from_raw_file(void* user_data, u32 x, u32 y, u32 width, u32 height, u8* dst, u32 dst_pitch) {
+    Tiled_Distance_Field_Io* io = (Tiled_Distance_Field_Io*)user_data;
+    for (u32 row = 0; row < height; ++row) {
+        s64 offset = (s64)(y + row)*io->src_width + x;
+#if _WIN32
+        _fseeki64(io->src_file, offset, SEEK_SET);
+#else
+        fseeko(io->src_file, (off_t)offset, SEEK_SET);
+#endif
+        if (fread(dst + row*dst_pitch, width, 1, io->src_file) != 1) {
+            memset(dst + row*dst_pitch, 0, width);
+        }
+    }
+}
+
+function
+b32 begin_tiled_bmp_output(Tiled_Distance_Field_Io* io, char* file_name, u32 width, u32 height, u32 tile_size) {
+    b32 result = false;
+    
+    u32 row_size = Align4(width);
+    u64 pixel_size = (u64)row_size*height;
+    
+    u32 palette[256];
+    for (u32 i = 0; i < 256; ++i) {
+        palette[i] = (i << 16) | (i << 8) | i;
+    }
+    
+    Bitmap_Header header = {};
+    header.file_type        = 0x4D42;
+    header.file_size        = (u32)Min(sizeof(header) + sizeof(palette) + pixel_size, (u64)UINT32_MAX);
+    header.bitmap_offset    = sizeof(header) + sizeof(palette);
+    header.size             = sizeof(header) - 14;
+    header.width            = width;
+    header.height           = height;
+    header.planes           = 1;
+    header.bits_per_pixel   = 8;
+    header.compression      = 0;
+    header.size_of_bitmap   = (u32)Min(pixel_size, (u64)UINT32_MAX);
+    header.horz_resolution  = 4096;
+    header.vert_resolution  = 4096;
+    header.colors_used      = 256;
+    header.colors_important = 0;
+    
+    io->out_file = fopen(file_name, "wb");
+    if (io->out_file) {
+        fwrite(&header, sizeof(header), 1, io->out_file);
+        fwrite(palette, sizeof(palette), 1, io->out_file);
+        
+        io->out_width    = width;
+        io->out_row_size = row_size;
+        io->out_band     = (u8*)malloc((umm)row_size*tile_size);
+        memset(io->out_band, 0, (umm)row_size*tile_size);
+        result = true;
+    } else {
+        fprintf(stderr, "error: Unable to write output file %s.\n", file_name);
+    }
+    
+    return result;
+}
+
+function
+void write_tile_to_bmp(void* user_data, u32 x, u32 y, u32 width, u32 height, u8* src, u32 src_pitch) {
+    Tiled_Distance_Field_Io* io = (Tiled_Distance_Field_Io*)user_data;
+    
+    for (u32 row = 0; row < height; ++row) {
+        memcpy(io->out_band + (umm)row*io->out_row_size + x, src + row*src_pitch, width);
+    }
+    
+    // NOTE: The last tile of a band reaches the right edge of the image.
+    if (x + width == io->out_width) {
+        fwrite(io->out_band, (umm)io->out_row_size*height, 1, io->out_file);
+    }
+}
+
+function
+void end_tiled_bmp_output(Tiled_Distance_Field_Io* io) {
+    if (io->out_file) {
+        fclose(io->out_file);
+    }
+    free(io->out_band);
+    io->out_file = 0;
+    io->out_band = 0;
+}
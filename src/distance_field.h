@@ -0,0 +1,65 @@
+/* date = October 19th 2026 10:12 am */
+
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+typedef enum DistanceFieldType {
+    DistanceField_Outer,
+    DistanceField_Inner,
+} DistanceFieldType;
+
+typedef enum DistanceFieldSeeding {
+    DistanceFieldSeeding_Threshold,   // NOTE: Whole pixel seeds, alpha thresholded at 127
+    DistanceFieldSeeding_AntiAliased, // NOTE: Sub-pixel edge positions estimated from anti-aliased alpha
+} DistanceFieldSeeding;
+
+typedef struct Distance_Field_Scratch {
+    u32 capacity; // NOTE: In pixels
+    u32* outer;
+    u32* inner;
+    u32* flood;
+    V2* edge_points;
+} Distance_Field_Scratch;
+
+typedef struct Signed_Distance_Source {
+    DistanceFieldSeeding seeding;
+    Image_u32* src;
+    
+    // NOTE: For DistanceFieldSeeding_AntiAliased only outer_seeds is used, and it holds
+    // the nearest edge pixel, whose sub-pixel edge position lives in edge_points.
+    Image_u32 outer_seeds;
+    Image_u32 inner_seeds;
+    V2* edge_points;
+    
+    Distance_Field_Scratch* scratch; // NOTE: Set if the buffers above belong to a scratch
+} Signed_Distance_Source;
+
+typedef void Distance_Field_Read_Alpha(void* user_data, u32 x, u32 y, u32 width, u32 height, u8* dst, u32 dst_pitch);
+typedef void Distance_Field_Write_Tile(void* user_data, u32 x, u32 y, u32 width, u32 height, u8* src, u32 src_pitch);
+
+typedef struct Tiled_Distance_Field_Desc {
+    u32 width;
+    u32 height;
+    u32 tile_size;
+    f32 spread;
+    DistanceFieldSeeding seeding;
+    
+    Distance_Field_Read_Alpha* read_alpha;
+    Distance_Field_Write_Tile* write_tile;
+    void* user_data;
+} Tiled_Distance_Field_Desc;
+
+typedef struct Tiled_Distance_Field_Io {
+    // NOTE: Source, either an image in memory or a raw 8 bit alpha file
+    Image_u32* src_image;
+    FILE* src_file;
+    u32 src_width;
+    
+    // NOTE: Sink, a streamed 8 bit BMP
+    FILE* out_file;
+    u32 out_width;
+    u32 out_row_size;
+    u8* out_band;
+} Tiled_Distance_Field_Io;
+
+#endif //DISTANCE_FIELD_H
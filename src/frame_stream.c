@@ -0,0 +1,135 @@
+#define FRAME_STREAM_PAGE_SIZE 4096
+
+internal void convert_image_to_y4m(Image_u32* image, u8* dst) {
+    u32 width  = image->width;
+    u32 height = image->height;
+    u32 chroma_width  = (width  + 1) / 2;
+    u32 chroma_height = (height + 1) / 2;
+    
+    u8* y_plane = dst;
+    u8* u_plane = y_plane + width*height;
+    u8* v_plane = u_plane + chroma_width*chroma_height;
+    
+    for (u32 row = 0; row < height; ++row) {
+        u32* src = get_pixel_pointer(image, 0, height - 1 - row);
+        u8* y_out = y_plane + row*width;
+        for (u32 x = 0; x < width; ++x) {
+            Color_ARGB pixel = { .argb = src[x] };
+            y_out[x] = (u8)(((66*pixel.r + 129*pixel.g + 25*pixel.b + 128) >> 8) + 16);
+        }
+    }
+    
+    // NOTE: Chroma is the 2x2 average, which lands on the centered (jpeg) siting. The last
+    // row and column repeat for odd sizes.
+    for (u32 row = 0; row < chroma_height; ++row) {
+        u32 row0 = 2*row;
+        u32 row1 = Min(2*row + 1, height - 1);
+        u32* src0 = get_pixel_pointer(image, 0, height - 1 - row0);
+        u32* src1 = get_pixel_pointer(image, 0, height - 1 - row1);
+        for (u32 x = 0; x < chroma_width; ++x) {
+            u32 x0 = 2*x;
+            u32 x1 = Min(2*x + 1, width - 1);
+            Color_ARGB p[4] = { { .argb = src0[x0] }, { .argb = src0[x1] }, { .argb = src1[x0] }, { .argb = src1[x1] } };
+            s32 r = (p[0].r + p[1].r + p[2].r + p[3].r + 2) >> 2;
+            s32 g = (p[0].g + p[1].g + p[2].g + p[3].g + 2) >> 2;
+            s32 b = (p[0].b + p[1].b + p[2].b + p[3].b + 2) >> 2;
+            u_plane[row*chroma_width + x] = (u8)(((-38*r -  74*g + 112*b + 128) >> 8) + 128);
+            v_plane[row*chroma_width + x] = (u8)(((112*r -  94*g -  18*b + 128) >> 8) + 128);
+        }
+    }
+}
+
+// NOTE: path is a file or FIFO, or null / "-" for stdout.
+function
+b32 begin_frame_stream(Frame_Stream* stream, char* path, FrameStreamFormat format, u32 width, u32 height, u32 frames_per_second) {
+    memset(stream, 0, sizeof(*stream));
+    stream->format = format;
+    stream->width  = width;
+    stream->height = height;
+    
+    if (!open_output_stream(&stream->output, path)) {
+        stream->failed = true;
+        return false;
+    }
+    
+    switch (format) {
+        case FrameStreamFormat_Raw: {
+            stream->frame_size = 4*(umm)width*height;
+        } break;
+        
+        case FrameStreamFormat_Y4M: {
+            umm chroma_size = (umm)((width + 1) / 2)*((height + 1) / 2);
+            stream->frame_size = (umm)width*height + 2*chroma_size;
+            
+            char header[128];
+            int header_size = snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", width, height, frames_per_second);
+            stream->failed = !write_output_stream(&stream->output, header, header_size);
+            if (!stream->failed) {
+                stream->bytes_written += header_size;
+            }
+        } break;
+        
+        InvalidDefaultCase;
+    }
+    
+    // NOTE: The staging buffers are page aligned and padded so vmsplice only ever hands over
+    // whole pages of ours.
+    umm staging_size = (stream->frame_size + FRAME_STREAM_PAGE_SIZE - 1) & ~(umm)(FRAME_STREAM_PAGE_SIZE - 1);
+    stream->staging[0] = (u8*)allocate_aligned(staging_size, FRAME_STREAM_PAGE_SIZE);
+    stream->staging[1] = (u8*)allocate_aligned(staging_size, FRAME_STREAM_PAGE_SIZE);
+    
+    stream->use_splice = stream->output.pipe_size && (stream->frame_size >= stream->output.pipe_size);
+    
+    return !stream->failed;
+}
+
+// NOTE: image must have the size the stream was started with.
+function
+b32 write_frame(Frame_Stream* stream, Image_u32* image) {
+    Assert((image->width == stream->width) && (image->height == stream->height));
+    if (stream->failed) {
+        return false;
+    }
+    
+    u8* staging = stream->staging[stream->staging_index];
+    stream->staging_index ^= 1;
+    
+    if (stream->format == FrameStreamFormat_Y4M) {
+        char frame_header[] = "FRAME\n";
+        stream->failed = !write_output_stream(&stream->output, frame_header, sizeof(frame_header) - 1);
+        if (!stream->failed) {
+            stream->bytes_written += sizeof(frame_header) - 1;
+        }
+        
+        convert_image_to_y4m(image, staging);
+    } else {
+        umm row_size = 4*(umm)image->width;
+        for (u32 row = 0; row < image->height; ++row) {
+            memcpy(staging + row*row_size, get_pixel_pointer(image, 0, image->height - 1 - row), row_size);
+        }
+    }
+    
+    if (!stream->failed) {
+        if (stream->use_splice) {
+            stream->failed = !splice_output_stream(&stream->output, staging, stream->frame_size);
+        } else {
+            stream->failed = !write_output_stream(&stream->output, staging, stream->frame_size);
+        }
+    }
+    
+    if (stream->failed) {
+        fprintf(stderr, "error: Frame stream closed after %llu frames.\n", (unsigned long long)stream->frames_written);
+    } else {
+        stream->frames_written += 1;
+        stream->bytes_written  += stream->frame_size;
+    }
+    return !stream->failed;
+}
+
+function
+void end_frame_stream(Frame_Stream* stream) {
+    close_output_stream(&stream->output);
+    free_aligned(stream->staging[0]);
+    free_aligned(stream->staging[1]);
+    memset(stream, 0, sizeof(*stream));
+}
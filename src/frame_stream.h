@@ -0,0 +1,41 @@
+/* date = October 19th 2026 4:10 pm */
+
+#ifndef FRAME_STREAM_H
+#define FRAME_STREAM_H
+
+//
+// NOTE: Streams frames into a pipe for an encoder to pick up, instead of writing a file per
+// frame. For example:
+//
+//     render | ffmpeg -f yuv4mpegpipe -i - turntable.mp4
+//     render | ffmpeg -f rawvideo -pix_fmt bgra -s 512x512 -r 30 -i - turntable.mp4
+//
+// Frames are converted top-down into one of two staging buffers and go out as a single write.
+// When the output is a Linux pipe no larger than a frame, the staging buffer is vmsplice'd in
+// instead, and alternating between the two buffers guarantees the reader is done with one by
+// the time it gets reused.
+//
+
+typedef enum FrameStreamFormat {
+    FrameStreamFormat_Raw, // NOTE: Top-down BGRA, no header
+    FrameStreamFormat_Y4M, // NOTE: YUV4MPEG2, 4:2:0 with BT.601 limited range
+} FrameStreamFormat;
+
+typedef struct Frame_Stream {
+    FrameStreamFormat format;
+    u32 width;
+    u32 height;
+    
+    Output_Stream output;
+    b32 use_splice;
+    b32 failed;
+    
+    umm frame_size;
+    u8* staging[2];
+    u32 staging_index;
+    
+    u64 frames_written;
+    u64 bytes_written;
+} Frame_Stream;
+
+#endif //FRAME_STREAM_H
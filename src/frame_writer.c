@@ -0,0 +1,120 @@
+internal void frame_writer_thread(void* user_data) {
+    Frame_Writer* writer = (Frame_Writer*)user_data;
+    for (;;) {
+        wait_semaphore(&writer->queued);
+        
+        u32 read = atomic_load(&writer->queue_read);
+        Frame_Writer_Item* item = writer->queue + (read % writer->buffer_count);
+        if (!item->image.pixels) {
+            // NOTE: An empty item is the signal to stop, everything before it has been written.
+            break;
+        }
+        
+        f64 start_time = get_time_seconds();
+        write_image(item->file_name, &item->image);
+        writer->stats.total_write_time += get_time_seconds() - start_time;
+        writer->stats.frames_written += 1;
+        
+        Image_u32 image = item->image;
+        atomic_store(&writer->queue_read, read + 1);
+        
+        u32 free_write = atomic_load(&writer->free_write);
+        writer->free_buffers[free_write % writer->buffer_count] = image;
+        atomic_store(&writer->free_write, free_write + 1);
+        signal_semaphore(&writer->free, 1);
+    }
+}
+
+function
+void begin_frame_writer(Frame_Writer* writer, u32 width, u32 height, u32 buffer_count) {
+    memset(writer, 0, sizeof(*writer));
+    
+    // NOTE: One slot more than there are buffers, so the stop item always fits in the queue.
+    writer->buffer_count = buffer_count + 1;
+    writer->buffers      = (Image_u32*)malloc(sizeof(Image_u32)*buffer_count);
+    writer->queue        = (Frame_Writer_Item*)malloc(sizeof(Frame_Writer_Item)*writer->buffer_count);
+    writer->free_buffers = (Image_u32*)malloc(sizeof(Image_u32)*writer->buffer_count);
+    
+    for (u32 buffer_index = 0; buffer_index < buffer_count; ++buffer_index) {
+        writer->buffers[buffer_index] = allocate_image(width, height);
+        writer->free_buffers[buffer_index] = writer->buffers[buffer_index];
+    }
+    writer->free_write = buffer_count;
+    
+    create_semaphore(&writer->queued, 0);
+    create_semaphore(&writer->free, buffer_count);
+    
+    writer->thread = create_thread(frame_writer_thread, writer);
+}
+
+// NOTE: Returns a buffer to render the next frame into. Its contents are whatever the last
+// frame that used it left behind.
+function
+Image_u32 acquire_frame(Frame_Writer* writer) {
+    u32 free_read = atomic_load(&writer->free_read);
+    if (free_read == atomic_load(&writer->free_write)) {
+        f64 start_time = get_time_seconds();
+        wait_semaphore(&writer->free);
+        f64 stall_time = get_time_seconds() - start_time;
+        
+        writer->stats.stall_count      += 1;
+        writer->stats.total_stall_time += stall_time;
+        writer->stats.max_stall_time    = Max(writer->stats.max_stall_time, stall_time);
+    } else {
+        wait_semaphore(&writer->free);
+    }
+    
+    Image_u32 result = writer->free_buffers[free_read % writer->buffer_count];
+    atomic_store(&writer->free_read, free_read + 1);
+    return result;
+}
+
+// NOTE: image must have come from acquire_frame. It belongs to the writer again after this.
+function
+void submit_frame(Frame_Writer* writer, char* file_name, Image_u32* image) {
+    u32 queue_write = atomic_load(&writer->queue_write);
+    
+    Frame_Writer_Item* item = writer->queue + (queue_write % writer->buffer_count);
+    snprintf(item->file_name, sizeof(item->file_name), "%s", file_name);
+    item->image = *image;
+    
+    atomic_store(&writer->queue_write, queue_write + 1);
+    signal_semaphore(&writer->queued, 1);
+    
+    u32 depth = queue_write + 1 - atomic_load(&writer->queue_read);
+    writer->stats.max_queue_depth = Max(writer->stats.max_queue_depth, depth);
+    
+    memset(image, 0, sizeof(*image));
+}
+
+// NOTE: Waits for every submitted frame to be written.
+function
+void end_frame_writer(Frame_Writer* writer) {
+    u32 queue_write = atomic_load(&writer->queue_write);
+    Frame_Writer_Item* item = writer->queue + (queue_write % writer->buffer_count);
+    memset(item, 0, sizeof(*item));
+    atomic_store(&writer->queue_write, queue_write + 1);
+    signal_semaphore(&writer->queued, 1);
+    
+    join_thread(&writer->thread);
+    
+    for (u32 buffer_index = 0; buffer_index < writer->buffer_count - 1; ++buffer_index) {
+        free_image(&writer->buffers[buffer_index]);
+    }
+    free(writer->buffers);
+    free(writer->queue);
+    free(writer->free_buffers);
+    destroy_semaphore(&writer->queued);
+    destroy_semaphore(&writer->free);
+}
+
+function
+void print_frame_writer_stats(Frame_Writer_Stats* stats) {
+    printf("frame writer: %llu frames, max queue depth %u, %llu stalls (%.2f ms total, %.2f ms max), %.2f ms per write\n",
+           (unsigned long long)stats->frames_written,
+           stats->max_queue_depth,
+           (unsigned long long)stats->stall_count,
+           1000.0*stats->total_stall_time,
+           1000.0*stats->max_stall_time,
+           stats->frames_written ? 1000.0*stats->total_write_time / (f64)stats->frames_written : 0.0);
+}
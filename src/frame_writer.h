@@ -0,0 +1,49 @@
+/* date = October 19th 2026 2:05 pm */
+
+#ifndef FRAME_WRITER_H
+#define FRAME_WRITER_H
+
+//
+// NOTE: Asynchronous frame output. The renderer takes a buffer from the writer with
+// acquire_frame, renders into it, and hands it back with submit_frame. A writer thread
+// saves it to disk and puts the buffer back in the pool, so rendering only waits on the
+// disk if every buffer is still queued up.
+//
+// Both rings are single producer, single consumer: frames go from the render thread to the
+// writer thread, free buffers go the other way.
+//
+
+typedef struct Frame_Writer_Item {
+    char file_name[256];
+    Image_u32 image;
+} Frame_Writer_Item;
+
+typedef struct Frame_Writer_Stats {
+    u64 frames_written;
+    u32 max_queue_depth;
+    u64 stall_count;        // NOTE: acquire_frame calls that found no free buffer
+    f64 total_stall_time;   // NOTE: In seconds, spent by the render thread waiting on buffers
+    f64 max_stall_time;
+    f64 total_write_time;   // NOTE: In seconds, spent by the writer thread in write_image
+} Frame_Writer_Stats;
+
+typedef struct Frame_Writer {
+    u32 buffer_count;
+    Image_u32* buffers;
+    
+    Frame_Writer_Item* queue;
+    u32 queue_read;
+    u32 queue_write;
+    Semaphore queued;
+    
+    Image_u32* free_buffers;
+    u32 free_read;
+    u32 free_write;
+    Semaphore free;
+    
+    Thread thread;
+    
+    Frame_Writer_Stats stats;
+} Frame_Writer;
+
+#endif //FRAME_WRITER_H
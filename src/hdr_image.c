@@ -0,0 +1,301 @@
+//
+// NOTE: sRGB tables
+//
+
+global f32 srgb8_to_linear_table[256] = {
+    0.00000000f, 0.00030353f, 0.00060705f, 0.00091058f, 0.00121411f, 0.00151763f, 0.00182116f, 0.00212469f,
+    0.00242822f, 0.00273174f, 0.00303527f, 0.00334654f, 0.00367651f, 0.00402472f, 0.00439144f, 0.00477695f,
+    0.00518152f, 0.00560539f, 0.00604883f, 0.00651209f, 0.00699541f, 0.00749903f, 0.00802319f, 0.00856813f,
+    0.00913406f, 0.00972122f, 0.01032982f, 0.01096009f, 0.01161224f, 0.01228649f, 0.01298303f, 0.01370208f,
+    0.01444384f, 0.01520851f, 0.01599629f, 0.01680738f, 0.01764195f, 0.01850022f, 0.01938236f, 0.02028856f,
+    0.02121901f, 0.02217389f, 0.02315337f, 0.02415763f, 0.02518686f, 0.02624122f, 0.02732089f, 0.02842604f,
+    0.02955684f, 0.03071344f, 0.03189603f, 0.03310477f, 0.03433981f, 0.03560131f, 0.03688945f, 0.03820437f,
+    0.03954624f, 0.04091520f, 0.04231141f, 0.04373503f, 0.04518620f, 0.04666509f, 0.04817183f, 0.04970657f,
+    0.05126946f, 0.05286065f, 0.05448028f, 0.05612849f, 0.05780543f, 0.05951124f, 0.06124605f, 0.06301001f,
+    0.06480327f, 0.06662594f, 0.06847817f, 0.07036009f, 0.07227185f, 0.07421357f, 0.07618538f, 0.07818742f,
+    0.08021982f, 0.08228271f, 0.08437621f, 0.08650046f, 0.08865558f, 0.09084171f, 0.09305897f, 0.09530747f,
+    0.09758735f, 0.09989873f, 0.10224173f, 0.10461649f, 0.10702311f, 0.10946171f, 0.11193243f, 0.11443537f,
+    0.11697067f, 0.11953843f, 0.12213878f, 0.12477182f, 0.12743768f, 0.13013647f, 0.13286832f, 0.13563333f,
+    0.13843161f, 0.14126329f, 0.14412847f, 0.14702727f, 0.14995979f, 0.15292615f, 0.15592647f, 0.15896083f,
+    0.16202937f, 0.16513219f, 0.16826940f, 0.17144111f, 0.17464741f, 0.17788842f, 0.18116425f, 0.18447499f,
+    0.18782078f, 0.19120169f, 0.19461784f, 0.19806932f, 0.20155625f, 0.20507874f, 0.20863687f, 0.21223076f,
+    0.21586050f, 0.21952620f, 0.22322796f, 0.22696587f, 0.23074006f, 0.23455058f, 0.23839757f, 0.24228112f,
+    0.24620132f, 0.25015828f, 0.25415209f, 0.25818285f, 0.26225066f, 0.26635560f, 0.27049780f, 0.27467731f,
+    0.27889428f, 0.28314874f, 0.28744084f, 0.29177064f, 0.29613826f, 0.30054379f, 0.30498731f, 0.30946892f,
+    0.31398872f, 0.31854677f, 0.32314321f, 0.32777810f, 0.33245152f, 0.33716363f, 0.34191442f, 0.34670407f,
+    0.35153261f, 0.35640013f, 0.36130679f, 0.36625260f, 0.37123770f, 0.37626213f, 0.38132602f, 0.38642943f,
+    0.39157248f, 0.39675522f, 0.40197778f, 0.40724021f, 0.41254261f, 0.41788507f, 0.42326766f, 0.42869049f,
+    0.43415365f, 0.43965718f, 0.44520119f, 0.45078579f, 0.45641103f, 0.46207699f, 0.46778381f, 0.47353148f,
+    0.47932017f, 0.48514995f, 0.49102086f, 0.49693298f, 0.50288647f, 0.50888133f, 0.51491767f, 0.52099556f,
+    0.52711511f, 0.53327638f, 0.53947949f, 0.54572445f, 0.55201143f, 0.55834037f, 0.56471151f, 0.57112485f,
+    0.57758045f, 0.58407843f, 0.59061885f, 0.59720176f, 0.60382736f, 0.61049557f, 0.61720657f, 0.62396038f,
+    0.63075715f, 0.63759685f, 0.64447969f, 0.65140563f, 0.65837485f, 0.66538727f, 0.67244315f, 0.67954248f,
+    0.68668532f, 0.69387174f, 0.70110190f, 0.70837575f, 0.71569347f, 0.72305512f, 0.73046076f, 0.73791039f,
+    0.74540418f, 0.75294220f, 0.76052451f, 0.76815116f, 0.77582222f, 0.78353781f, 0.79129791f, 0.79910272f,
+    0.80695224f, 0.81484658f, 0.82278574f, 0.83076990f, 0.83879900f, 0.84687322f, 0.85499263f, 0.86315721f,
+    0.87136710f, 0.87962240f, 0.88792312f, 0.89626938f, 0.90466118f, 0.91309863f, 0.92158186f, 0.93011087f,
+    0.93868572f, 0.94730651f, 0.95597333f, 0.96468627f, 0.97344530f, 0.98225057f, 0.99110210f, 1.00000000f,
+};
+
+// NOTE: One segment per eighth of a power of two from 2^-13 up to 1. The high 16 bits are the
+// value at the start of the segment in units of 2^-7, the low 16 bits the slope per step of t.
+global u32 linear_to_srgb8_table[104] = {
+    0x00000000, 0x006f0024, 0x00800000, 0x00800000, 0x00800000, 0x00800000, 0x00800000, 0x00800000,
+    0x00800000, 0x00800000, 0x00800000, 0x00800000, 0x00800000, 0x00800000, 0x00f50018, 0x01000000,
+    0x01000000, 0x01000000, 0x01000000, 0x01000000, 0x01780025, 0x01800000, 0x01800000, 0x01800000,
+    0x01f20028, 0x02000027, 0x02000027, 0x027c002b, 0x02800027, 0x02e7004a, 0x03000027, 0x03000027,
+    0x037a0093, 0x03e9008e, 0x0458008e, 0x04c6008f, 0x0500008e, 0x057c0089, 0x05e80080, 0x06520079,
+    0x06aa0119, 0x074f0102, 0x07e900f1, 0x087a0121, 0x092600d3, 0x09ad00c9, 0x0a3000c0, 0x0ab100b2,
+    0x0b1f018b, 0x0bf301b1, 0x0ccc0191, 0x0da70141, 0x0e55016f, 0x0f22011e, 0x0fc90110, 0x10630143,
+    0x110a025b, 0x1239023d, 0x1358021a, 0x14650204, 0x156601ea, 0x165a01d3, 0x174501bc, 0x1832016f,
+    0x18fe0330, 0x1a9802f5, 0x1c1702cb, 0x1d7d02ad, 0x1ed4028d, 0x201b026d, 0x21520256, 0x227c0242,
+    0x23a0043e, 0x25c203fa, 0x27c003bf, 0x29a10392, 0x2b690368, 0x2d1f033a, 0x2ebe031d, 0x304d02ff,
+    0x31d205ab, 0x34ab054d, 0x3752050c, 0x39d504c0, 0x3c37048a, 0x3e7d0453, 0x40a90423, 0x42be03fc,
+    0x44c30797, 0x48920712, 0x4c1f06af, 0x4f76065e, 0x52a5060e, 0x55ac05ca, 0x58940588, 0x5b5a0552,
+    0x5e110a15, 0x631c097f, 0x67dc08f0, 0x6c55087e, 0x70970811, 0x74a307b5, 0x787c076e, 0x7c35071f,
+};
+
+#define SRGB8_MIN_LINEAR_BITS ((127 - 13) << 23)
+#define SRGB8_ALMOST_ONE_BITS 0x3F7FFFFF
+
+function
+f32 srgb8_to_linear(u8 value) {
+    f32 result = srgb8_to_linear_table[value];
+    return result;
+}
+
+function
+u8 linear_to_srgb8(f32 value) {
+    u32 min_bits        = SRGB8_MIN_LINEAR_BITS;
+    u32 almost_one_bits = SRGB8_ALMOST_ONE_BITS;
+    f32 min_value;
+    f32 almost_one;
+    memcpy(&min_value,  &min_bits,        sizeof(f32));
+    memcpy(&almost_one, &almost_one_bits, sizeof(f32));
+    
+    // NOTE: Written so NaN ends up at the bottom.
+    if (!(value > min_value)) {
+        value = min_value;
+    }
+    if (value > almost_one) {
+        value = almost_one;
+    }
+    
+    u32 bits;
+    memcpy(&bits, &value, sizeof(u32));
+    
+    u32 entry = linear_to_srgb8_table[(bits - SRGB8_MIN_LINEAR_BITS) >> 20];
+    u32 bias  = (entry >> 16) << 9;
+    u32 scale = entry & 0xFFFF;
+    u32 t     = (bits >> 12) & 0xFF;
+    u8 result = (u8)((bias + scale*t) >> 16);
+    return result;
+}
+
+// NOTE: linear_to_srgb8 for four lanes at once. The table lookups stay scalar, there's no
+// gather before AVX2.
+function
+__m128i linear_to_srgb8(__m128 value) {
+    __m128 min_value  = _mm_castsi128_ps(_mm_set1_epi32(SRGB8_MIN_LINEAR_BITS));
+    __m128 almost_one = _mm_castsi128_ps(_mm_set1_epi32(SRGB8_ALMOST_ONE_BITS));
+    
+    // NOTE: maxps returns its second operand when either is NaN.
+    __m128 clamped = _mm_min_ps(_mm_max_ps(value, min_value), almost_one);
+    __m128i bits   = _mm_castps_si128(clamped);
+    
+    u32 indices[4];
+    _mm_storeu_si128((__m128i*)indices, _mm_srli_epi32(_mm_sub_epi32(bits, _mm_set1_epi32(SRGB8_MIN_LINEAR_BITS)), 20));
+    __m128i entry = _mm_setr_epi32((s32)linear_to_srgb8_table[indices[0]], (s32)linear_to_srgb8_table[indices[1]],
+                                   (s32)linear_to_srgb8_table[indices[2]], (s32)linear_to_srgb8_table[indices[3]]);
+    
+    __m128i bias  = _mm_slli_epi32(_mm_srli_epi32(entry, 16), 9);
+    __m128i scale = _mm_and_si128(entry, _mm_set1_epi32(0xFFFF));
+    __m128i t     = _mm_and_si128(_mm_srli_epi32(bits, 12), _mm_set1_epi32(0xFF));
+    
+    // NOTE: The slopes all fit in 15 bits and the top half of t is zero, so one madd does the multiply.
+    __m128i result = _mm_srli_epi32(_mm_add_epi32(bias, _mm_madd_epi16(scale, t)), 16);
+    return result;
+}
+
+// NOTE: From a straight alpha sRGB color, like the ones rgb and rgba make, to premultiplied linear.
+function
+V4 color_to_linear(Color_ARGB color) {
+    f32 alpha = (f32)color.a / 255.0f;
+    V4 result = v4(srgb8_to_linear(color.r)*alpha,
+                   srgb8_to_linear(color.g)*alpha,
+                   srgb8_to_linear(color.b)*alpha,
+                   alpha);
+    return result;
+}
+
+// NOTE: What the resolve does to one pixel. The result is still premultiplied.
+function
+Color_ARGB linear_to_color(V4 color) {
+    Color_ARGB result;
+    result.r = linear_to_srgb8(color.x);
+    result.g = linear_to_srgb8(color.y);
+    result.b = linear_to_srgb8(color.z);
+    result.a = (u8)(clamp01(color.w)*255.0f + 0.5f);
+    return result;
+}
+
+//
+// NOTE: Image_V4
+//
+
+// NOTE: Rows are rounded up to whole cache lines.
+function
+Image_V4 allocate_image_v4(u32 width, u32 height) {
+    u32 pixels_per_line = IMAGE_ALIGNMENT / sizeof(V4);
+    
+    Image_V4 image = {};
+    image.width  = width;
+    image.height = height;
+    image.pitch  = (width + pixels_per_line - 1) & ~(pixels_per_line - 1);
+    
+    umm pixel_size = sizeof(V4)*(umm)image.pitch*height;
+    image.pixels = (V4*)allocate_aligned(pixel_size, IMAGE_ALIGNMENT);
+    memset(image.pixels, 0, pixel_size);
+    
+    return image;
+}
+
+function
+void free_image(Image_V4* image) {
+    free_aligned(image->pixels);
+    memset(image, 0, sizeof(*image));
+}
+
+function
+V4* get_pixel_pointer(Image_V4* image, u32 x, u32 y) {
+    V4* result = image->pixels + (umm)y*image->pitch + x;
+    return result;
+}
+
+function
+V4 get_pixel(Image_V4* image, u32 x, u32 y) {
+    V4 result = image->pixels[(umm)y*image->pitch + x];
+    return result;
+}
+
+function
+void set_pixel(Image_V4* image, u32 x, u32 y, V4 color) {
+    image->pixels[(umm)y*image->pitch + x] = color;
+}
+
+// NOTE: Same rules as the Image_u32 version, a clipped view sharing image's pixels.
+function
+Image_V4 get_sub_image(Image_V4* image, u32 x, u32 y, u32 width, u32 height) {
+    Image_V4 result = {};
+    if ((x < image->width) && (y < image->height)) {
+        result.width  = Min(width,  image->width  - x);
+        result.height = Min(height, image->height - y);
+        result.pitch  = image->pitch;
+        result.pixels = get_pixel_pointer(image, x, y);
+    }
+    return result;
+}
+
+function
+void clear_image(Image_V4* image, V4 color) {
+    for (u32 y = 0; y < image->height; ++y) {
+        V4* row = get_pixel_pointer(image, 0, y);
+        for (u32 x = 0; x < image->width; ++x) {
+            row[x] = color;
+        }
+    }
+}
+
+// NOTE: The blend modes in float. Add doesn't saturate, the headroom is the point.
+function
+void blend_pixel(Image_V4* image, u32 x, u32 y, V4 color, BlendMode mode) {
+    V4* pixel = get_pixel_pointer(image, x, y);
+    V4 dst = *pixel;
+    switch (mode) {
+        case BlendMode_Replace:  { *pixel = color; } break;
+        case BlendMode_Over:     { *pixel = color + dst*(1.0f - color.w); } break;
+        case BlendMode_Add:      { *pixel = color + dst; } break;
+        case BlendMode_Multiply: { *pixel = color*dst + color*(1.0f - dst.w) + dst*(1.0f - color.w); } break;
+        InvalidDefaultCase;
+    }
+}
+
+//
+// NOTE: Resolve
+//
+
+// NOTE: Four pixels in, four Color_ARGBs out. V4s are only 4 byte aligned, and sub images
+// can start anywhere, so the loads are unaligned.
+internal __m128i resolve_pixels(V4* pixels) {
+    __m128 r = _mm_loadu_ps((f32*)&pixels[0]);
+    __m128 g = _mm_loadu_ps((f32*)&pixels[1]);
+    __m128 b = _mm_loadu_ps((f32*)&pixels[2]);
+    __m128 a = _mm_loadu_ps((f32*)&pixels[3]);
+    _MM_TRANSPOSE4_PS(r, g, b, a);
+    
+    __m128 alpha = _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    
+    __m128i result = linear_to_srgb8(b);
+    result = _mm_or_si128(result, _mm_slli_epi32(linear_to_srgb8(g), 8));
+    result = _mm_or_si128(result, _mm_slli_epi32(linear_to_srgb8(r), 16));
+    result = _mm_or_si128(result, _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(alpha, _mm_set1_ps(255.0f))), 24));
+    return result;
+}
+
+// NOTE: Clamps src to [0, 1] and encodes it to sRGB into dst, which has to be the same size.
+function
+void resolve_image(Image_V4* src, Image_u32* dst) {
+    Assert((src->width  == dst->width) &&
+           (src->height == dst->height));
+    
+    for (u32 y = 0; y < src->height; ++y) {
+        V4*  src_row = get_pixel_pointer(src, 0, y);
+        u32* dst_row = get_pixel_pointer(dst, 0, y);
+        
+        u32 x = 0;
+        for (; x + 4 <= src->width; x += 4) {
+            _mm_storeu_si128((__m128i*)(dst_row + x), resolve_pixels(src_row + x));
+        }
+        
+        if (x < src->width) {
+            V4 tail[4] = {};
+            u32 packed[4];
+            u32 count = src->width - x;
+            memcpy(tail, src_row + x, sizeof(V4)*count);
+            _mm_storeu_si128((__m128i*)packed, resolve_pixels(tail));
+            memcpy(dst_row + x, packed, sizeof(u32)*count);
+        }
+    }
+}
+
+typedef struct Resolve_Job_Data {
+    Image_V4*  src;
+    Image_u32* dst;
+    u32 tiles_x;
+} Resolve_Job_Data;
+
+internal void resolve_job(void* user_data, u32 job_index, u32 worker_index) {
+    Resolve_Job_Data* data = (Resolve_Job_Data*)user_data;
+    
+    u32 x = (job_index % data->tiles_x)*HDR_RESOLVE_TILE_SIZE;
+    u32 y = (job_index / data->tiles_x)*HDR_RESOLVE_TILE_SIZE;
+    
+    Image_V4  src = get_sub_image(data->src, x, y, HDR_RESOLVE_TILE_SIZE, HDR_RESOLVE_TILE_SIZE);
+    Image_u32 dst = get_sub_image(data->dst, x, y, HDR_RESOLVE_TILE_SIZE, HDR_RESOLVE_TILE_SIZE);
+    resolve_image(&src, &dst);
+}
+
+// NOTE: The same, with one job per tile.
+function
+void resolve_image(Job_Pool* pool, Image_V4* src, Image_u32* dst) {
+    Assert((src->width  == dst->width) &&
+           (src->height == dst->height));
+    
+    Resolve_Job_Data data = {};
+    data.src     = src;
+    data.dst     = dst;
+    data.tiles_x = (src->width  + HDR_RESOLVE_TILE_SIZE - 1) / HDR_RESOLVE_TILE_SIZE;
+    u32 tiles_y  = (src->height + HDR_RESOLVE_TILE_SIZE - 1) / HDR_RESOLVE_TILE_SIZE;
+    
+    parallel_for(pool, data.tiles_x*tiles_y, resolve_job, &data);
+}
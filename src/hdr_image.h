@@ -0,0 +1,28 @@
+/* date = October 19th 2026 7:05 pm */
+
+#ifndef HDR_IMAGE_H
+#define HDR_IMAGE_H
+
+//
+// NOTE: A framebuffer of linear light RGBA floats, x = r, y = g, z = b, w = a. Lighting adds up
+// correctly in here, and values above 1 are kept until the resolve, which clamps them and
+// encodes to 8 bit sRGB into an Image_u32. Colors are premultiplied like everywhere else.
+//
+// The resolve never calls pow. Each channel's float bits pick one of 104 linear segments
+// that approximate the sRGB curve from 2^-13 to 1, and the next 8 bits of mantissa
+// interpolate along it in fixed point. It's within 1 of the exactly rounded result, and
+// matches it for all but about 0.3% of the inputs.
+//
+
+// NOTE: Resolve jobs work on squares this size, so each one stays in L2.
+#define HDR_RESOLVE_TILE_SIZE 64
+
+typedef struct Image_V4 {
+    u32 width;
+    u32 height;
+    u32 pitch;
+    
+    V4* pixels;
+} Image_V4;
+
+#endif //HDR_IMAGE_H
@@ -18,37 +18,49 @@ Color_ARGB rgb(u8 r, u8 g, u8 b) {
     return result;
 }
 
+// NOTE: The size of the visible pixels, not counting any padding at the end of the rows.
 function
 u32 get_total_pixel_size(Image_u32* image) {
     u32 result = sizeof(u32)*image->width*image->height;
     return result;
 }
 
+// NOTE: True if the rows follow each other with no gap, so the pixels can be treated as one block.
+function
+b32 is_image_contiguous(Image_u32* image) {
+    b32 result = (image->pitch == image->width) || (image->height <= 1);
+    return result;
+}
+
 function
 u32* get_pixel_pointer(Image_u32* image, u32 x, u32 y) {
-    u32* result = image->pixels + y*image->width + x;
+    u32* result = image->pixels + (umm)y*image->pitch + x;
     return result;
 }
 
 function
 u32 get_pixel(Image_u32* image, u32 x, u32 y) {
-    u32 result = image->pixels[y*image->width + x];
+    u32 result = image->pixels[(umm)y*image->pitch + x];
     return result;
 }
 
 function
 void set_pixel(Image_u32* image, u32 x, u32 y, Color_ARGB color) {
-    image->pixels[y*image->width + x] = color.argb;
+    image->pixels[(umm)y*image->pitch + x] = color.argb;
 }
 
 function
 void write_image(char* file_name, Image_u32* image) {
     u32 pixel_size = get_total_pixel_size(image);
     
+    // NOTE: The pixels start on a 4 byte boundary, so read_image can use them straight out of the mapped file.
+    u8 padding[4] = {};
+    u32 padding_size = Align4(sizeof(Bitmap_Header)) - sizeof(Bitmap_Header);
+    
     Bitmap_Header header = {};
     header.file_type        = 0x4D42;
-    header.file_size        = sizeof(header) + pixel_size;
-    header.bitmap_offset    = sizeof(header);
+    header.file_size        = sizeof(header) + padding_size + pixel_size;
+    header.bitmap_offset    = sizeof(header) + padding_size;
     header.size             = sizeof(header) - 14;
     header.width            = image->width;
     header.height           = image->height;
@@ -64,37 +76,94 @@ void write_image(char* file_name, Image_u32* image) {
     FILE* out_file = fopen(file_name, "wb");
     if (out_file) {
         fwrite(&header, sizeof(header), 1, out_file);
-        fwrite(image->pixels, pixel_size, 1, out_file);
+        fwrite(padding, padding_size, 1, out_file);
+        if (is_image_contiguous(image)) {
+            fwrite(image->pixels, pixel_size, 1, out_file);
+        } else {
+            for (u32 y = 0; y < image->height; ++y) {
+                fwrite(get_pixel_pointer(image, 0, y), sizeof(u32)*image->width, 1, out_file);
+            }
+        }
         fclose(out_file);
     } else {
         fprintf(stderr, "error: Unable to write output file %s.\n", file_name);
     }
 }
 
+// NOTE: pitch is in pixels and at least width.
 function
-Image_u32 allocate_image(u32 width, u32 height) {
+Image_u32 allocate_image(u32 width, u32 height, u32 pitch) {
+    Assert(pitch >= width);
+    
     Image_u32 image = {};
-    image.width = width;
+    image.width  = width;
     image.height = height;
+    image.pitch  = pitch;
     
-    u32 pixel_size = get_total_pixel_size(&image);
-    image.pixels = (u32*)malloc(pixel_size);
+    // NOTE: Cache line aligned, so SIMD loops over the pixels can use aligned loads.
+    umm pixel_size = sizeof(u32)*(umm)pitch*height;
+    image.pixels = (u32*)allocate_aligned(pixel_size, IMAGE_ALIGNMENT);
     memset(image.pixels, 0, pixel_size);
     
     return image;
 }
 
+function
+Image_u32 allocate_image(u32 width, u32 height) {
+    Image_u32 image = allocate_image(width, height, width);
+    return image;
+}
+
+// NOTE: Rows are rounded up to whole cache lines, and moved off multiples of 1 KB so walking
+// down a column of a power of two wide image doesn't keep landing in the same few cache sets.
+function
+u32 get_padded_pitch(u32 width) {
+    u32 pixels_per_line = IMAGE_ALIGNMENT / sizeof(u32);
+    u32 result = (width + pixels_per_line - 1) & ~(pixels_per_line - 1);
+    if (((sizeof(u32)*result) % 1024) == 0) {
+        result += pixels_per_line;
+    }
+    return result;
+}
+
+function
+Image_u32 allocate_padded_image(u32 width, u32 height) {
+    Image_u32 image = allocate_image(width, height, get_padded_pitch(width));
+    return image;
+}
+
+// NOTE: A view of a rectangle of image, clipped to it. It shares the pixels and pitch of
+// image, so writes go straight to image, and it must not be freed.
+function
+Image_u32 get_sub_image(Image_u32* image, u32 x, u32 y, u32 width, u32 height) {
+    Image_u32 result = {};
+    if ((x < image->width) && (y < image->height)) {
+        result.width  = Min(width,  image->width  - x);
+        result.height = Min(height, image->height - y);
+        result.pitch  = image->pitch;
+        result.pixels = get_pixel_pointer(image, x, y);
+    }
+    return result;
+}
+
 function
 void free_image(Image_u32* image) {
-    free(image->pixels);
+    free_aligned(image->pixels);
     memset(image, 0, sizeof(*image));
 }
 
+// NOTE: Copies src into the bottom left of dst, which has to be at least as big.
 function
 void copy_image(Image_u32* src, Image_u32* dst) {
-    Assert((src->width == dst->width) &&
+    Assert((src->width  <= dst->width) &&
            (src->height <= dst->height));
-    memcpy(dst->pixels, src->pixels, get_total_pixel_size(src));
+    if (is_image_contiguous(src) && is_image_contiguous(dst) && (src->width == dst->width)) {
+        memcpy(dst->pixels, src->pixels, get_total_pixel_size(src));
+    } else {
+        for (u32 y = 0; y < src->height; ++y) {
+            memcpy(get_pixel_pointer(dst, 0, y), get_pixel_pointer(src, 0, y), sizeof(u32)*src->width);
+        }
+    }
 }
 
 function
@@ -104,11 +173,981 @@ Image_u32 clone_image(Image_u32* src) {
     return dst;
 }
 
+//
+// NOTE: Fills and blits. Big fills use non-temporal stores: a cleared framebuffer is bigger
+// than the cache and won't be read back until drawing touches it, so pulling it through the
+// cache would only evict things that are still useful.
+//
+
+#define STREAMING_FILL_THRESHOLD (1024*1024)
+
+internal void fill_u32(u32* dst, umm count, u32 value, b32 streaming) {
+    while (count && ((umm)dst & 15)) {
+        *dst++ = value;
+        --count;
+    }
+    
+    __m128i v = _mm_set1_epi32((s32)value);
+    if (streaming) {
+        for (; count >= 16; count -= 16, dst += 16) {
+            _mm_stream_si128((__m128i*)dst + 0, v);
+            _mm_stream_si128((__m128i*)dst + 1, v);
+            _mm_stream_si128((__m128i*)dst + 2, v);
+            _mm_stream_si128((__m128i*)dst + 3, v);
+        }
+    } else {
+        for (; count >= 16; count -= 16, dst += 16) {
+            _mm_store_si128((__m128i*)dst + 0, v);
+            _mm_store_si128((__m128i*)dst + 1, v);
+            _mm_store_si128((__m128i*)dst + 2, v);
+            _mm_store_si128((__m128i*)dst + 3, v);
+        }
+    }
+    for (; count >= 4; count -= 4, dst += 4) {
+        _mm_store_si128((__m128i*)dst, v);
+    }
+    
+    while (count--) {
+        *dst++ = value;
+    }
+}
+
+// NOTE: Clipped to the image. x and y can be negative.
+function
+void fill_rect(Image_u32* image, s32 x, s32 y, u32 width, u32 height, Color_ARGB color) {
+    s32 x0 = Max(x, 0);
+    s32 y0 = Max(y, 0);
+    s32 x1 = (s32)Min((s64)x + width,  (s64)image->width);
+    s32 y1 = (s32)Min((s64)y + height, (s64)image->height);
+    if ((x0 >= x1) || (y0 >= y1)) {
+        return;
+    }
+    
+    umm row_count = (umm)(x1 - x0);
+    b32 streaming = (sizeof(u32)*row_count*(umm)(y1 - y0) >= STREAMING_FILL_THRESHOLD);
+    if ((row_count == image->width) && is_image_contiguous(image)) {
+        fill_u32(get_pixel_pointer(image, 0, y0), row_count*(umm)(y1 - y0), color.argb, streaming);
+    } else {
+        for (s32 row = y0; row < y1; ++row) {
+            fill_u32(get_pixel_pointer(image, x0, row), row_count, color.argb, streaming);
+        }
+    }
+    if (streaming) {
+        _mm_sfence();
+    }
+}
+
 function
 void clear_image(Image_u32* image, Color_ARGB color) {
-    u32* at  = image->pixels;
-    u32* end = get_pixel_pointer(image, image->width, image->height);
-    while (at != end) {
-        *at++ = color.argb;
+    fill_rect(image, 0, 0, image->width, image->height, color);
+}
+
+// NOTE: Clips src against dst, so that (x, y) in dst is where the bottom left of src lands.
+// Returns false if nothing overlaps.
+internal b32 clip_blit(Image_u32* dst, s32 x, s32 y, Image_u32* src, Image_u32* out_dst, Image_u32* out_src) {
+    s32 src_x = Max(-x, 0);
+    s32 src_y = Max(-y, 0);
+    s32 dst_x = Max(x, 0);
+    s32 dst_y = Max(y, 0);
+    if ((src_x >= (s32)src->width) || (src_y >= (s32)src->height) ||
+        (dst_x >= (s32)dst->width) || (dst_y >= (s32)dst->height)) {
+        return false;
+    }
+    
+    u32 width  = Min(src->width  - src_x, dst->width  - dst_x);
+    u32 height = Min(src->height - src_y, dst->height - dst_y);
+    *out_src = get_sub_image(src, src_x, src_y, width, height);
+    *out_dst = get_sub_image(dst, dst_x, dst_y, width, height);
+    return true;
+}
+
+function
+void blit_image(Image_u32* dst, s32 x, s32 y, Image_u32* src) {
+    Image_u32 dst_rect, src_rect;
+    if (clip_blit(dst, x, y, src, &dst_rect, &src_rect)) {
+        copy_image(&src_rect, &dst_rect);
+    }
+}
+
+// NOTE: Straight (not premultiplied) alpha "over": dst = src*a + dst*(1 - a) per channel, with
+// the destination alpha accumulating as a + dst_a*(1 - a). Done in 16 bit lanes, two pixels
+// at a time. Division by 255 is exact: for t <= 255*255, (t + 128)*257 >> 16 rounds t / 255.
+function
+__m128i blend_over_straight(__m128i src, __m128i dst) {
+    __m128i alpha_lane = _mm_set_epi32(0x00FF0000, 0, 0x00FF0000, 0);
+    
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, 0xFF), 0xFF);
+    __m128i inverse_alpha = _mm_xor_si128(alpha, _mm_set1_epi16(0xFF));
+    
+    // NOTE: The alpha lane of src counts as 255, so its result is a*255 + dst_a*(255 - a).
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(_mm_or_si128(src, alpha_lane), alpha),
+                              _mm_mullo_epi16(dst, inverse_alpha));
+    t = _mm_mulhi_epu16(_mm_add_epi16(t, _mm_set1_epi16(128)), _mm_set1_epi16(257));
+    return t;
+}
+
+function
+u32 blend_over_straight(u32 src, u32 dst) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i s = _mm_unpacklo_epi8(_mm_cvtsi32_si128((s32)src), zero);
+    __m128i d = _mm_unpacklo_epi8(_mm_cvtsi32_si128((s32)dst), zero);
+    u32 result = (u32)_mm_cvtsi128_si32(_mm_packus_epi16(blend_over_straight(s, d), zero));
+    return result;
+}
+
+// NOTE: Like blit_image, but src is alpha blended over dst.
+function
+void blend_image(Image_u32* dst, s32 x, s32 y, Image_u32* src) {
+    Image_u32 dst_rect, src_rect;
+    if (!clip_blit(dst, x, y, src, &dst_rect, &src_rect)) {
+        return;
+    }
+    
+    __m128i zero = _mm_setzero_si128();
+    for (u32 row = 0; row < src_rect.height; ++row) {
+        u32* s = get_pixel_pointer(&src_rect, 0, row);
+        u32* d = get_pixel_pointer(&dst_rect, 0, row);
+        
+        u32 column = 0;
+        for (; column + 4 <= src_rect.width; column += 4) {
+            __m128i src_pixels = _mm_loadu_si128((__m128i*)(s + column));
+            __m128i dst_pixels = _mm_loadu_si128((__m128i*)(d + column));
+            __m128i lo = blend_over_straight(_mm_unpacklo_epi8(src_pixels, zero), _mm_unpacklo_epi8(dst_pixels, zero));
+            __m128i hi = blend_over_straight(_mm_unpackhi_epi8(src_pixels, zero), _mm_unpackhi_epi8(dst_pixels, zero));
+            _mm_storeu_si128((__m128i*)(d + column), _mm_packus_epi16(lo, hi));
+        }
+        for (; column < src_rect.width; ++column) {
+            d[column] = blend_over_straight(s[column], d[column]);
+        }
+    }
+}
+
+//
+// NOTE: Premultiplied blending, on packed 8 bit pixels. Instead of unpacking to 16 bits per
+// channel, each pixel is split into its b/r and g/a byte pairs with a mask, the same trick as
+// the bg/ra halves of Color_ARGB, so one 16 bit multiply handles two channels of four pixels.
+//
+
+function
+Color_ARGB premultiply(Color_ARGB color) {
+    u32 a = color.a;
+    u32 br = (color.argb & 0x00FF00FF)*a + 0x00800080;
+    u32 g  = ((color.argb >> 8) & 0xFF)*a + 0x80;
+    br = ((br + ((br >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+    g  = ((g + (g >> 8)) >> 8) & 0xFF;
+    Color_ARGB result = { .argb = br | (g << 8) | (a << 24) };
+    return result;
+}
+
+function
+void premultiply_image(Image_u32* image) {
+    for (u32 y = 0; y < image->height; ++y) {
+        u32* row = get_pixel_pointer(image, 0, y);
+        for (u32 x = 0; x < image->width; ++x) {
+            row[x] = premultiply((Color_ARGB) { .argb = row[x] }).argb;
+        }
+    }
+}
+
+// NOTE: Each 32 bit lane holds a pixel, the result has alpha in both 16 bit halves.
+internal __m128i broadcast_alpha(__m128i pixels) {
+    __m128i alpha = _mm_srli_epi32(pixels, 24);
+    return _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+}
+
+// NOTE: (a*b) / 255 per channel, with a and b packed pixels and the division rounded exactly.
+// b_pairs is b already split: its b/r (or g/a) value for each 16 bit lane.
+internal __m128i multiply_div255(__m128i a, __m128i b_low_pairs, __m128i b_high_pairs) {
+    __m128i pair_mask = _mm_set1_epi32(0x00FF00FF);
+    __m128i round     = _mm_set1_epi16(128);
+    __m128i div255    = _mm_set1_epi16(257);
+    
+    __m128i low  = _mm_mullo_epi16(_mm_and_si128(a, pair_mask), b_low_pairs);
+    __m128i high = _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(a, 8), pair_mask), b_high_pairs);
+    low  = _mm_mulhi_epu16(_mm_add_epi16(low,  round), div255);
+    high = _mm_mulhi_epu16(_mm_add_epi16(high, round), div255);
+    return _mm_or_si128(low, _mm_slli_epi16(high, 8));
+}
+
+internal __m128i blend_pixels(__m128i src, __m128i dst, BlendMode mode) {
+    __m128i pair_mask = _mm_set1_epi32(0x00FF00FF);
+    
+    __m128i result = src;
+    switch (mode) {
+        case BlendMode_Replace: {
+        } break;
+        
+        case BlendMode_Over: {
+            __m128i inverse_src_alpha = _mm_xor_si128(broadcast_alpha(src), pair_mask);
+            result = _mm_adds_epu8(src, multiply_div255(dst, inverse_src_alpha, inverse_src_alpha));
+        } break;
+        
+        case BlendMode_Add: {
+            result = _mm_adds_epu8(src, dst);
+        } break;
+        
+        case BlendMode_Multiply: {
+            __m128i inverse_src_alpha = _mm_xor_si128(broadcast_alpha(src), pair_mask);
+            __m128i inverse_dst_alpha = _mm_xor_si128(broadcast_alpha(dst), pair_mask);
+            __m128i dst_low  = _mm_and_si128(dst, pair_mask);
+            __m128i dst_high = _mm_and_si128(_mm_srli_epi16(dst, 8), pair_mask);
+            result = _mm_adds_epu8(multiply_div255(src, dst_low, dst_high),
+                                   _mm_adds_epu8(multiply_div255(src, inverse_dst_alpha, inverse_dst_alpha),
+                                                 multiply_div255(dst, inverse_src_alpha, inverse_src_alpha)));
+        } break;
+        
+        InvalidDefaultCase;
+    }
+    return result;
+}
+
+// NOTE: The blend stage: blends count premultiplied pixels from src onto dst, four at a time.
+function
+void blend_span(u32* dst, u32* src, u32 count, BlendMode mode) {
+    if (mode == BlendMode_Replace) {
+        memcpy(dst, src, sizeof(u32)*count);
+        return;
+    }
+    
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((__m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((__m128i*)(dst + i));
+        _mm_storeu_si128((__m128i*)(dst + i), blend_pixels(s, d, mode));
+    }
+    for (; i < count; ++i) {
+        __m128i s = _mm_cvtsi32_si128((s32)src[i]);
+        __m128i d = _mm_cvtsi32_si128((s32)dst[i]);
+        dst[i] = (u32)_mm_cvtsi128_si32(blend_pixels(s, d, mode));
+    }
+}
+
+// NOTE: Composites a premultiplied src onto dst with the given mode.
+function
+void blend_image(Image_u32* dst, s32 x, s32 y, Image_u32* src, BlendMode mode) {
+    Image_u32 dst_rect, src_rect;
+    if (clip_blit(dst, x, y, src, &dst_rect, &src_rect)) {
+        for (u32 row = 0; row < src_rect.height; ++row) {
+            blend_span(get_pixel_pointer(&dst_rect, 0, row), get_pixel_pointer(&src_rect, 0, row), src_rect.width, mode);
+        }
+    }
+}
+
+//
+// NOTE: Fast clears. A Tile_Clear_Mask remembers which 32x32 tiles of an image have been drawn
+// to since the last clear. Clearing again only refills those, the rest still hold the clear
+// color. Whoever draws has to mark what they touch; marking too much is fine, too little isn't.
+//
+
+function
+void create_tile_clear_mask(Tile_Clear_Mask* mask, u32 width, u32 height) {
+    memset(mask, 0, sizeof(*mask));
+    mask->width   = width;
+    mask->height  = height;
+    mask->tiles_x = (width  + CLEAR_TILE_SIZE - 1) >> CLEAR_TILE_SHIFT;
+    mask->tiles_y = (height + CLEAR_TILE_SIZE - 1) >> CLEAR_TILE_SHIFT;
+    mask->touched = (u8*)malloc((umm)mask->tiles_x*mask->tiles_y);
+    
+    // NOTE: Nothing is known about the contents yet, so the first clear does everything.
+    memset(mask->touched, 1, (umm)mask->tiles_x*mask->tiles_y);
+}
+
+function
+void free_tile_clear_mask(Tile_Clear_Mask* mask) {
+    free(mask->touched);
+    memset(mask, 0, sizeof(*mask));
+}
+
+function
+void mark_touched(Tile_Clear_Mask* mask, s32 x, s32 y, u32 width, u32 height) {
+    s32 x0 = Max(x, 0);
+    s32 y0 = Max(y, 0);
+    s32 x1 = (s32)Min((s64)x + width,  (s64)mask->width);
+    s32 y1 = (s32)Min((s64)y + height, (s64)mask->height);
+    if ((x0 >= x1) || (y0 >= y1)) {
+        return;
+    }
+    
+    for (s32 tile_y = y0 >> CLEAR_TILE_SHIFT; tile_y <= ((y1 - 1) >> CLEAR_TILE_SHIFT); ++tile_y) {
+        for (s32 tile_x = x0 >> CLEAR_TILE_SHIFT; tile_x <= ((x1 - 1) >> CLEAR_TILE_SHIFT); ++tile_x) {
+            mask->touched[tile_y*mask->tiles_x + tile_x] = 1;
+        }
+    }
+}
+
+function
+void fast_clear_image(Image_u32* image, Tile_Clear_Mask* mask, Color_ARGB color) {
+    Assert((image->width == mask->width) && (image->height == mask->height));
+    
+    umm tile_count = (umm)mask->tiles_x*mask->tiles_y;
+    if (color.argb != mask->clear_color.argb) {
+        memset(mask->touched, 1, tile_count);
+        mask->clear_color = color;
+    }
+    
+    // NOTE: Runs of touched tiles in a row are cleared together, so a fully touched image
+    // still clears with long rows.
+    for (u32 tile_y = 0; tile_y < mask->tiles_y; ++tile_y) {
+        u8* touched = mask->touched + tile_y*mask->tiles_x;
+        u32 tile_x = 0;
+        while (tile_x < mask->tiles_x) {
+            if (!touched[tile_x]) {
+                ++tile_x;
+                continue;
+            }
+            
+            u32 run_begin = tile_x;
+            while ((tile_x < mask->tiles_x) && touched[tile_x]) {
+                touched[tile_x] = 0;
+                ++tile_x;
+            }
+            fill_rect(image, run_begin << CLEAR_TILE_SHIFT, tile_y << CLEAR_TILE_SHIFT,
+                      (tile_x - run_begin) << CLEAR_TILE_SHIFT, CLEAR_TILE_SIZE, color);
+        }
+    }
+}
+
+//
+// NOTE: Single channel images
+//
+
+function
+u32 get_total_pixel_size(Image_u8* image) {
+    u32 result = sizeof(u8)*image->width*image->height;
+    return result;
+}
+
+function
+u32 get_total_pixel_size(Image_u16* image) {
+    u32 result = sizeof(u16)*image->width*image->height;
+    return result;
+}
+
+function
+u32 get_total_pixel_size(Image_f16* image) {
+    u32 result = sizeof(u16)*image->width*image->height;
+    return result;
+}
+
+function
+u8 get_pixel(Image_u8* image, u32 x, u32 y) {
+    u8 result = image->pixels[y*image->width + x];
+    return result;
+}
+
+function
+u16 get_pixel(Image_u16* image, u32 x, u32 y) {
+    u16 result = image->pixels[y*image->width + x];
+    return result;
+}
+
+function
+u16 get_pixel(Image_f16* image, u32 x, u32 y) {
+    u16 result = image->pixels[y*image->width + x];
+    return result;
+}
+
+function
+void set_pixel(Image_u8* image, u32 x, u32 y, u8 value) {
+    image->pixels[y*image->width + x] = value;
+}
+
+function
+void set_pixel(Image_u16* image, u32 x, u32 y, u16 value) {
+    image->pixels[y*image->width + x] = value;
+}
+
+function
+void set_pixel(Image_f16* image, u32 x, u32 y, u16 value) {
+    image->pixels[y*image->width + x] = value;
+}
+
+function
+Image_u8 allocate_image_u8(u32 width, u32 height) {
+    Image_u8 image = {};
+    image.width = width;
+    image.height = height;
+    
+    u32 pixel_size = get_total_pixel_size(&image);
+    image.pixels = (u8*)malloc(pixel_size);
+    memset(image.pixels, 0, pixel_size);
+    
+    return image;
+}
+
+function
+Image_u16 allocate_image_u16(u32 width, u32 height) {
+    Image_u16 image = {};
+    image.width = width;
+    image.height = height;
+    
+    u32 pixel_size = get_total_pixel_size(&image);
+    image.pixels = (u16*)malloc(pixel_size);
+    memset(image.pixels, 0, pixel_size);
+    
+    return image;
+}
+
+function
+Image_f16 allocate_image_f16(u32 width, u32 height) {
+    Image_f16 image = {};
+    image.width = width;
+    image.height = height;
+    
+    u32 pixel_size = get_total_pixel_size(&image);
+    image.pixels = (u16*)malloc(pixel_size);
+    memset(image.pixels, 0, pixel_size);
+    
+    return image;
+}
+
+function
+void free_image(Image_u8* image) {
+    free(image->pixels);
+    memset(image, 0, sizeof(*image));
+}
+
+function
+void free_image(Image_u16* image) {
+    free(image->pixels);
+    memset(image, 0, sizeof(*image));
+}
+
+function
+void free_image(Image_f16* image) {
+    free(image->pixels);
+    memset(image, 0, sizeof(*image));
+}
+
+function
+Image_f32 allocate_image_f32(u32 width, u32 height) {
+    Image_f32 image = {};
+    image.width  = width;
+    image.height = height;
+    image.pitch  = width;
+    
+    umm pixel_size = sizeof(f32)*(umm)width*height;
+    image.pixels = (f32*)allocate_aligned(pixel_size, IMAGE_ALIGNMENT);
+    memset(image.pixels, 0, pixel_size);
+    
+    return image;
+}
+
+function
+void free_image(Image_f32* image) {
+    free_aligned(image->pixels);
+    memset(image, 0, sizeof(*image));
+}
+
+function
+f32* get_pixel_pointer(Image_f32* image, u32 x, u32 y) {
+    f32* result = image->pixels + (umm)y*image->pitch + x;
+    return result;
+}
+
+function
+f32 get_pixel(Image_f32* image, u32 x, u32 y) {
+    f32 result = image->pixels[(umm)y*image->pitch + x];
+    return result;
+}
+
+function
+void set_pixel(Image_f32* image, u32 x, u32 y, f32 value) {
+    image->pixels[(umm)y*image->pitch + x] = value;
+}
+
+function
+Image_f32 get_sub_image(Image_f32* image, u32 x, u32 y, u32 width, u32 height) {
+    Image_f32 result = {};
+    if ((x < image->width) && (y < image->height)) {
+        result.width  = Min(width,  image->width  - x);
+        result.height = Min(height, image->height - y);
+        result.pitch  = image->pitch;
+        result.pixels = get_pixel_pointer(image, x, y);
+    }
+    return result;
+}
+
+function
+void clear_image(Image_f32* image, f32 value) {
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    for (u32 y = 0; y < image->height; ++y) {
+        fill_u32((u32*)get_pixel_pointer(image, 0, y), image->width, bits, false);
+    }
+}
+
+function
+u16 f32_to_f16(f32 f) {
+    union { f32 f; u32 u; } bits = { .f = f };
+    
+    u32 sign     = (bits.u >> 16) & 0x8000;
+    u32 f32_exp  = (bits.u >> 23) & 0xFF;
+    u32 mantissa = bits.u & 0x7FFFFF;
+    s32 exponent = (s32)f32_exp - 127 + 15;
+    
+    u32 result;
+    if (f32_exp == 0xFF) {
+        // NOTE: Inf stays inf, NaN stays NaN
+        result = sign | 0x7C00 | (mantissa ? 0x200 : 0);
+    } else if (exponent >= 31) {
+        result = sign | 0x7C00;
+    } else if (exponent <= 0) {
+        if (exponent < -10) {
+            result = sign;
+        } else {
+            // NOTE: Denormal half, round to nearest even
+            mantissa |= 0x800000;
+            u32 shift     = (u32)(14 - exponent);
+            u32 round_bit = 1u << (shift - 1);
+            result = sign | (mantissa >> shift);
+            if ((mantissa & round_bit) && (mantissa & (3*round_bit - 1))) {
+                result += 1;
+            }
+        }
+    } else {
+        // NOTE: Round to nearest even, a carry out of the mantissa correctly bumps the exponent
+        result = sign | ((u32)exponent << 10) | (mantissa >> 13);
+        if ((mantissa & 0x1000) && (mantissa & 0x2FFF)) {
+            result += 1;
+        }
+    }
+    
+    return (u16)result;
+}
+
+function
+f32 f16_to_f32(u16 h) {
+    u32 sign     = (u32)(h & 0x8000) << 16;
+    u32 exponent = (h >> 10) & 0x1F;
+    u32 mantissa = h & 0x3FF;
+    
+    u32 bits;
+    if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    } else if (exponent == 0) {
+        if (mantissa) {
+            exponent = 127 - 15 + 1;
+            while (!(mantissa & 0x400)) {
+                mantissa <<= 1;
+                exponent -= 1;
+            }
+            bits = sign | (exponent << 23) | ((mantissa & 0x3FF) << 13);
+        } else {
+            bits = sign;
+        }
+    } else {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+    
+    union { u32 u; f32 f; } result = { .u = bits };
+    return result.f;
+}
+
+// NOTE: 8 bit paletted grayscale BMP. Rows are padded to 4 bytes as the format requires.
+function
+void write_image(char* file_name, Image_u8* image) {
+    u32 row_size   = Align4(image->width);
+    u32 pixel_size = row_size*image->height;
+    
+    u32 palette[256];
+    for (u32 i = 0; i < 256; ++i) {
+        palette[i] = (i << 16) | (i << 8) | i;
+    }
+    
+    Bitmap_Header header = {};
+    header.file_type        = 0x4D42;
+    header.file_size        = sizeof(header) + sizeof(palette) + pixel_size;
+    header.bitmap_offset    = sizeof(header) + sizeof(palette);
+    header.size             = sizeof(header) - 14;
+    header.width            = image->width;
+    header.height           = image->height;
+    header.planes           = 1;
+    header.bits_per_pixel   = 8;
+    header.compression      = 0;
+    header.size_of_bitmap   = pixel_size;
+    header.horz_resolution  = 4096;
+    header.vert_resolution  = 4096;
+    header.colors_used      = 256;
+    header.colors_important = 0;
+    
+    FILE* out_file = fopen(file_name, "wb");
+    if (out_file) {
+        fwrite(&header, sizeof(header), 1, out_file);
+        fwrite(palette, sizeof(palette), 1, out_file);
+        if (row_size == image->width) {
+            fwrite(image->pixels, pixel_size, 1, out_file);
+        } else {
+            u8 padding[4] = {};
+            for (u32 y = 0; y < image->height; ++y) {
+                fwrite(image->pixels + y*image->width, image->width, 1, out_file);
+                fwrite(padding, row_size - image->width, 1, out_file);
+            }
+        }
+        fclose(out_file);
+    } else {
+        fprintf(stderr, "error: Unable to write output file %s.\n", file_name);
+    }
+}
+
+// NOTE: 16 bit binary PGM. PGM is big endian and top-down, so rows get swapped and flipped on the way out.
+function
+void write_image(char* file_name, Image_u16* image) {
+    FILE* out_file = fopen(file_name, "wb");
+    if (out_file) {
+        fprintf(out_file, "P5\n%u %u\n65535\n", image->width, image->height);
+        
+        u8* row = (u8*)malloc(2*image->width);
+        for (u32 y = image->height; y > 0; --y) {
+            u16* src = image->pixels + (y - 1)*image->width;
+            for (u32 x = 0; x < image->width; ++x) {
+                row[2*x + 0] = (u8)(src[x] >> 8);
+                row[2*x + 1] = (u8)(src[x] & 0xFF);
+            }
+            fwrite(row, 2*image->width, 1, out_file);
+        }
+        free(row);
+        
+        fclose(out_file);
+    } else {
+        fprintf(stderr, "error: Unable to write output file %s.\n", file_name);
+    }
+}
+
+// NOTE: Grayscale PFM. PFM rows are bottom-up like ours, and a negative scale marks little endian data.
+function
+void write_image(char* file_name, Image_f16* image) {
+    FILE* out_file = fopen(file_name, "wb");
+    if (out_file) {
+        fprintf(out_file, "Pf\n%u %u\n-1.0\n", image->width, image->height);
+        
+        f32* row = (f32*)malloc(sizeof(f32)*image->width);
+        for (u32 y = 0; y < image->height; ++y) {
+            u16* src = image->pixels + y*image->width;
+            for (u32 x = 0; x < image->width; ++x) {
+                row[x] = f16_to_f32(src[x]);
+            }
+            fwrite(row, sizeof(f32)*image->width, 1, out_file);
+        }
+        free(row);
+        
+        fclose(out_file);
+    } else {
+        fprintf(stderr, "error: Unable to write output file %s.\n", file_name);
+    }
+}
+
+//
+// NOTE: Reading images. Everything comes back as an Image_u32. When the file already holds a
+// bottom-up, 32 bit BGRA image at a 4 byte aligned offset (as write_image produces, or an
+// uncompressed bottom-left TGA with a suitable id field) the pixels are used in place from the
+// mapped file. Anything else, top-down files included, is converted into a freshly allocated
+// image, since rows can't be stepped backwards.
+//
+// Formats with no alpha get an opaque alpha channel. That includes 8 bit BMPs, which index a
+// palette of colors. Grayscale formats (PGM and grayscale TGA) put the gray value in every
+// channel, alpha included, so a grayscale mask can be fed straight to the distance field code.
+//
+
+internal Color_ARGB decode_pixel(u8* at, u32 bytes_per_pixel) {
+    Color_ARGB result = {};
+    switch (bytes_per_pixel) {
+        case 1: { result = rgba(at[0], at[0], at[0], at[0]); } break;
+        case 3: { result = rgba(at[2], at[1], at[0], 255);   } break;
+        case 4: { result = rgba(at[2], at[1], at[0], at[3]); } break;
+        InvalidDefaultCase;
+    }
+    return result;
+}
+
+internal b32 use_mapped_pixels(File_Mapping* file, umm offset, u32 width, u32 height, Loaded_Image* out) {
+    b32 result = false;
+    if ((offset & 3) == 0) {
+        out->image.width  = width;
+        out->image.height = height;
+        out->image.pitch  = width;
+        out->image.pixels = (u32*)(file->data + offset);
+        out->mapping      = *file;
+        result = true;
+    }
+    return result;
+}
+
+internal b32 read_image_bmp(File_Mapping* file, Loaded_Image* out) {
+    Bitmap_Header header;
+    if (file->size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, file->data, sizeof(header));
+    
+    // NOTE: Negated in 64 bits, since a height of INT_MIN has no positive s32.
+    b32 top_down = (header.height < 0);
+    u32 width    = (u32)header.width;
+    u32 height   = (u32)(top_down ? -(s64)header.height : (s64)header.height);
+    u32 bpp      = header.bits_per_pixel;
+    if ((header.width <= 0) || (height == 0) || (header.compression != 0) ||
+        ((bpp != 8) && (bpp != 24) && (bpp != 32))) {
+        return false;
+    }
+    
+    u32 bytes_per_pixel = bpp / 8;
+    umm row_size = Align4((umm)width*bytes_per_pixel);
+    if ((umm)header.bitmap_offset + row_size*height > file->size) {
+        return false;
+    }
+    
+    if ((bpp == 32) && !top_down && use_mapped_pixels(file, header.bitmap_offset, width, height, out)) {
+        return true;
+    }
+    
+    // NOTE: 8 bit images are paletted. The palette follows the info header, and its fourth byte
+    // is reserved rather than alpha.
+    u32 palette[256] = {};
+    if (bpp == 8) {
+        umm palette_offset = 14 + (umm)header.size;
+        umm palette_count  = header.colors_used ? Min(header.colors_used, 256) : 256;
+        if (palette_offset + 4*palette_count > header.bitmap_offset) {
+            return false;
+        }
+        memcpy(palette, file->data + palette_offset, 4*palette_count);
+        for (u32 i = 0; i < 256; ++i) {
+            palette[i] |= 0xFF000000;
+        }
+    }
+    
+    Image_u32 image = allocate_image(width, height);
+    for (u32 y = 0; y < height; ++y) {
+        u8* row = file->data + header.bitmap_offset + row_size*(top_down ? height - 1 - y : y);
+        u32* dst = get_pixel_pointer(&image, 0, y);
+        for (u32 x = 0; x < width; ++x) {
+            if (bpp == 8) {
+                dst[x] = palette[row[x]];
+            } else {
+                dst[x] = decode_pixel(row + x*bytes_per_pixel, bytes_per_pixel).argb;
+            }
+        }
+    }
+    
+    out->image = image;
+    return true;
+}
+
+// NOTE: Skips whitespace and # comments between PNM header fields.
+internal u8* skip_pnm_space(u8* at, u8* end) {
+    while (at < end) {
+        if (*at == '#') {
+            while ((at < end) && (*at != '\n')) {
+                ++at;
+            }
+        } else if ((*at == ' ') || (*at == '\t') || (*at == '\r') || (*at == '\n')) {
+            ++at;
+        } else {
+            break;
+        }
+    }
+    return at;
+}
+
+internal u8* parse_pnm_u32(u8* at, u8* end, u32* out_value) {
+    at = skip_pnm_space(at, end);
+    u32 value = 0;
+    u8* start = at;
+    while ((at < end) && (*at >= '0') && (*at <= '9') && (value < 0x10000000)) {
+        value = 10*value + (*at - '0');
+        ++at;
+    }
+    *out_value = value;
+    return (at == start) ? 0 : at;
+}
+
+// NOTE: Binary PGM (P5) and PPM (P6), 8 or 16 bits per sample. PNM is top-down and 16 bit
+// samples are big endian.
+internal b32 read_image_pnm(File_Mapping* file, Loaded_Image* out) {
+    u8* at  = file->data;
+    u8* end = file->data + file->size;
+    
+    u32 channel_count = (at[1] == '5') ? 1 : 3;
+    at += 2;
+    
+    u32 width, height, max_value;
+    if (!(at = parse_pnm_u32(at, end, &width))  ||
+        !(at = parse_pnm_u32(at, end, &height)) ||
+        !(at = parse_pnm_u32(at, end, &max_value))) {
+        return false;
+    }
+    // NOTE: Exactly one whitespace character separates the header from the samples.
+    at += 1;
+    
+    if ((width == 0) || (height == 0) || (max_value == 0) || (max_value > 65535)) {
+        return false;
+    }
+    
+    u32 bytes_per_sample = (max_value < 256) ? 1 : 2;
+    umm row_size = (umm)width*channel_count*bytes_per_sample;
+    if ((at > end) || (row_size*height > (umm)(end - at))) {
+        return false;
+    }
+    
+    Image_u32 image = allocate_image(width, height);
+    for (u32 y = 0; y < height; ++y) {
+        u8* row = at + row_size*(height - 1 - y);
+        u32* dst = get_pixel_pointer(&image, 0, y);
+        for (u32 x = 0; x < width; ++x) {
+            u8 samples[3];
+            for (u32 c = 0; c < channel_count; ++c) {
+                u8* sample = row + (x*channel_count + c)*bytes_per_sample;
+                u32 value = (bytes_per_sample == 1) ? sample[0] : ((u32)sample[0] << 8) | sample[1];
+                samples[c] = (u8)((value*255 + max_value / 2) / max_value);
+            }
+            if (channel_count == 1) {
+                dst[x] = rgba(samples[0], samples[0], samples[0], samples[0]).argb;
+            } else {
+                dst[x] = rgb(samples[0], samples[1], samples[2]).argb;
+            }
+        }
+    }
+    
+    out->image = image;
+    return true;
+}
+
+// NOTE: Uncompressed and RLE true color (types 2 and 10) and grayscale (types 3 and 11) TGA.
+internal b32 read_image_tga(File_Mapping* file, Loaded_Image* out) {
+    Targa_Header header;
+    if (file->size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, file->data, sizeof(header));
+    
+    b32 rle  = (header.image_type == 10) || (header.image_type == 11);
+    b32 gray = (header.image_type == 3)  || (header.image_type == 11);
+    u32 bytes_per_pixel = header.bits_per_pixel / 8;
+    
+    if ((header.color_map_type != 0) ||
+        ((header.image_type != 2) && (header.image_type != 3) && !rle) ||
+        (gray && (header.bits_per_pixel != 8)) ||
+        (!gray && (header.bits_per_pixel != 24) && (header.bits_per_pixel != 32)) ||
+        (header.width == 0) || (header.height == 0)) {
+        return false;
+    }
+    
+    u32 width  = header.width;
+    u32 height = header.height;
+    b32 top_down      = (header.descriptor & 0x20) != 0;
+    b32 right_to_left = (header.descriptor & 0x10) != 0;
+    
+    umm offset = sizeof(header) + header.id_length;
+    u8* at  = file->data + offset;
+    u8* end = file->data + file->size;
+    if (offset > file->size) {
+        return false;
+    }
+    
+    if (!rle) {
+        if ((umm)width*height*bytes_per_pixel > (umm)(end - at)) {
+            return false;
+        }
+        if ((bytes_per_pixel == 4) && !top_down && !right_to_left &&
+            use_mapped_pixels(file, offset, width, height, out)) {
+            return true;
+        }
+    }
+    
+    Image_u32 image = allocate_image(width, height);
+    
+    u32 pixel_count  = width*height;
+    u32 packet_count = 0;
+    b32 packet_is_run = false;
+    Color_ARGB pixel = {};
+    u32 i = 0;
+    for (; i < pixel_count; ++i) {
+        if (rle && (packet_count == 0)) {
+            if (at >= end) {
+                break;
+            }
+            packet_is_run = (*at & 0x80) != 0;
+            packet_count  = (*at & 0x7F) + 1;
+            ++at;
+            if (packet_is_run) {
+                if (bytes_per_pixel > (umm)(end - at)) {
+                    break;
+                }
+                pixel = decode_pixel(at, bytes_per_pixel);
+                at += bytes_per_pixel;
+            }
+        }
+        
+        if (!rle || !packet_is_run) {
+            if (bytes_per_pixel > (umm)(end - at)) {
+                break;
+            }
+            pixel = decode_pixel(at, bytes_per_pixel);
+            at += bytes_per_pixel;
+        }
+        if (rle) {
+            --packet_count;
+        }
+        
+        u32 x = i % width;
+        u32 y = i / width;
+        if (right_to_left) {
+            x = width - 1 - x;
+        }
+        if (top_down) {
+            y = height - 1 - y;
+        }
+        set_pixel(&image, x, y, pixel);
+    }
+    
+    // NOTE: The packets ran out before the pixels did.
+    if (i < pixel_count) {
+        free_image(&image);
+        return false;
+    }
+    
+    out->image = image;
+    return true;
+}
+
+// NOTE: Reads a BMP, binary PGM/PPM or TGA file. Free the result with free_loaded_image, since
+// the pixels may belong to a file mapping rather than the heap.
+function
+b32 read_image(char* file_name, Loaded_Image* out) {
+    memset(out, 0, sizeof(*out));
+    
+    File_Mapping file;
+    if (!map_file(file_name, &file)) {
+        fprintf(stderr, "error: Unable to open input file %s.\n", file_name);
+        return false;
+    }
+    
+    b32 result = false;
+    u8* data = file.data;
+    if ((file.size >= 2) && (data[0] == 'B') && (data[1] == 'M')) {
+        result = read_image_bmp(&file, out);
+    } else if ((file.size >= 2) && (data[0] == 'P') && ((data[1] == '5') || (data[1] == '6'))) {
+        result = read_image_pnm(&file, out);
+    } else {
+        // NOTE: TGA has no magic number, so it's whatever is left.
+        result = read_image_tga(&file, out);
+    }
+    
+    if (!result) {
+        fprintf(stderr, "error: Unsupported or corrupt image file %s.\n", file_name);
+    }
+    if (!out->mapping.data) {
+        unmap_file(&file);
+    }
+    
+    return result;
+}
+
+function
+void free_loaded_image(Loaded_Image* loaded) {
+    if (loaded->mapping.data) {
+        unmap_file(&loaded->mapping);
+    } else {
+        free_image(&loaded->image);
     }
+    memset(loaded, 0, sizeof(*loaded));
 }
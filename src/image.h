@@ -33,13 +33,95 @@ typedef struct Bitmap_Header {
     u32 colors_used;
     u32 colors_important;
 } Bitmap_Header;
+
+typedef struct Targa_Header {
+    u8  id_length;
+    u8  color_map_type;
+    u8  image_type;
+    u16 color_map_first;
+    u16 color_map_length;
+    u8  color_map_entry_size;
+    u16 x_origin;
+    u16 y_origin;
+    u16 width;
+    u16 height;
+    u8  bits_per_pixel;
+    u8  descriptor;
+} Targa_Header;
 #pragma pack(pop)
 
+#define IMAGE_ALIGNMENT 64
+
+// NOTE: Rows are pitch pixels apart, which can be more than width: for padded rows, or when
+// the image is a view into part of a bigger one (see get_sub_image).
 typedef struct Image_u32 {
     u32 width;
     u32 height;
+    u32 pitch;
     
     u32* pixels;
 } Image_u32;
 
+// NOTE: All modes but Replace expect premultiplied colors on both sides.
+typedef enum BlendMode {
+    BlendMode_Replace,  // NOTE: dst = src
+    BlendMode_Over,     // NOTE: dst = src + dst*(1 - src_a)
+    BlendMode_Add,      // NOTE: dst = src + dst, saturating
+    BlendMode_Multiply, // NOTE: dst = src*dst + src*(1 - dst_a) + dst*(1 - src_a)
+} BlendMode;
+
+#define CLEAR_TILE_SHIFT 5
+#define CLEAR_TILE_SIZE (1 << CLEAR_TILE_SHIFT)
+
+typedef struct Tile_Clear_Mask {
+    u32 width;
+    u32 height;
+    u32 tiles_x;
+    u32 tiles_y;
+    
+    Color_ARGB clear_color;
+    u8* touched; // NOTE: One flag per tile, set if it may differ from clear_color
+} Tile_Clear_Mask;
+
+// NOTE: Single channel images, used for compact distance field output.
+// Image_u16 is unorm16, Image_f16 holds the bits of IEEE half floats.
+
+typedef struct Image_u8 {
+    u32 width;
+    u32 height;
+    
+    u8* pixels;
+} Image_u8;
+
+typedef struct Image_u16 {
+    u32 width;
+    u32 height;
+    
+    u16* pixels;
+} Image_u16;
+
+typedef struct Image_f16 {
+    u32 width;
+    u32 height;
+    
+    u16* pixels;
+} Image_f16;
+
+// NOTE: Depth buffers. Unlike the single channel images above it has a pitch, so it can be
+// cut into views the same way as the Image_u32 it goes with.
+typedef struct Image_f32 {
+    u32 width;
+    u32 height;
+    u32 pitch;
+    
+    f32* pixels;
+} Image_f32;
+
+// NOTE: An image from read_image. If mapping.data is set the pixels point into the mapped file,
+// otherwise they were allocated with allocate_image.
+typedef struct Loaded_Image {
+    Image_u32 image;
+    File_Mapping mapping;
+} Loaded_Image;
+
 #endif //IMAGE_H
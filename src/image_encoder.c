@@ -0,0 +1,530 @@
+//
+// NOTE: QOI. See https://qoiformat.org/qoi-specification.pdf. QOI is top-down RGBA, so rows
+// are walked from the top of the image and channels are read out of Color_ARGB by name.
+//
+
+internal u8* put_u32_be(u8* at, u32 value) {
+    at[0] = (u8)(value >> 24);
+    at[1] = (u8)(value >> 16);
+    at[2] = (u8)(value >>  8);
+    at[3] = (u8)(value >>  0);
+    return at + 4;
+}
+
+function
+String_u8 encode_image_qoi(Image_u32* image) {
+    umm pixel_count = (umm)image->width*image->height;
+    
+    String_u8 result = {};
+    result.data = (u8*)malloc(14 + 5*pixel_count + 8);
+    
+    u8* at = result.data;
+    *at++ = 'q'; *at++ = 'o'; *at++ = 'i'; *at++ = 'f';
+    at = put_u32_be(at, image->width);
+    at = put_u32_be(at, image->height);
+    *at++ = 4; // NOTE: RGBA
+    *at++ = 0; // NOTE: sRGB with linear alpha
+    
+    Color_ARGB index[64] = {};
+    Color_ARGB prev = rgba(0, 0, 0, 255);
+    u32 run = 0;
+    
+    for (u32 row = 0; row < image->height; ++row) {
+        u32* src = get_pixel_pointer(image, 0, image->height - 1 - row);
+        for (u32 x = 0; x < image->width; ++x) {
+            Color_ARGB pixel = { .argb = src[x] };
+            
+            if (pixel.argb == prev.argb) {
+                ++run;
+                if (run == 62) {
+                    *at++ = 0xC0 | (u8)(run - 1);
+                    run = 0;
+                }
+                continue;
+            }
+            
+            if (run > 0) {
+                *at++ = 0xC0 | (u8)(run - 1);
+                run = 0;
+            }
+            
+            u32 hash = (pixel.r*3 + pixel.g*5 + pixel.b*7 + pixel.a*11) % 64;
+            if (index[hash].argb == pixel.argb) {
+                *at++ = (u8)hash;
+            } else {
+                index[hash] = pixel;
+                
+                if (pixel.a == prev.a) {
+                    s8 dr = (s8)(pixel.r - prev.r);
+                    s8 dg = (s8)(pixel.g - prev.g);
+                    s8 db = (s8)(pixel.b - prev.b);
+                    s8 dr_dg = (s8)(dr - dg);
+                    s8 db_dg = (s8)(db - dg);
+                    
+                    if ((dr >= -2) && (dr <= 1) && (dg >= -2) && (dg <= 1) && (db >= -2) && (db <= 1)) {
+                        *at++ = 0x40 | (u8)((dr + 2) << 4) | (u8)((dg + 2) << 2) | (u8)(db + 2);
+                    } else if ((dg >= -32) && (dg <= 31) && (dr_dg >= -8) && (dr_dg <= 7) && (db_dg >= -8) && (db_dg <= 7)) {
+                        *at++ = 0x80 | (u8)(dg + 32);
+                        *at++ = (u8)((dr_dg + 8) << 4) | (u8)(db_dg + 8);
+                    } else {
+                        *at++ = 0xFE;
+                        *at++ = pixel.r;
+                        *at++ = pixel.g;
+                        *at++ = pixel.b;
+                    }
+                } else {
+                    *at++ = 0xFF;
+                    *at++ = pixel.r;
+                    *at++ = pixel.g;
+                    *at++ = pixel.b;
+                    *at++ = pixel.a;
+                }
+            }
+            
+            prev = pixel;
+        }
+    }
+    
+    if (run > 0) {
+        *at++ = 0xC0 | (u8)(run - 1);
+    }
+    
+    for (u32 i = 0; i < 7; ++i) {
+        *at++ = 0;
+    }
+    *at++ = 1;
+    
+    result.len = at - result.data;
+    return result;
+}
+
+//
+// NOTE: Deflate, tuned for speed over ratio: one block with the fixed Huffman code, and an
+// LZ77 matcher that checks a single candidate per position from a hash of the next 4 bytes.
+// Filtered image rows are mostly small values and repeats, which that handles well enough.
+//
+
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_WINDOW_SIZE 32768
+#define DEFLATE_MIN_MATCH 4
+#define DEFLATE_MAX_MATCH 258
+
+internal void put_bits(Bit_Writer* writer, u32 value, u32 count) {
+    writer->bits |= (u64)value << writer->bit_count;
+    writer->bit_count += count;
+    if (writer->bit_count >= 32) {
+        writer->at[0] = (u8)(writer->bits >>  0);
+        writer->at[1] = (u8)(writer->bits >>  8);
+        writer->at[2] = (u8)(writer->bits >> 16);
+        writer->at[3] = (u8)(writer->bits >> 24);
+        writer->at += 4;
+        writer->bits >>= 32;
+        writer->bit_count -= 32;
+    }
+}
+
+internal void flush_bits(Bit_Writer* writer) {
+    while (writer->bit_count > 0) {
+        *writer->at++ = (u8)writer->bits;
+        writer->bits >>= 8;
+        writer->bit_count = (writer->bit_count > 8) ? writer->bit_count - 8 : 0;
+    }
+}
+
+internal u32 reverse_bits(u32 value, u32 count) {
+    u32 result = 0;
+    for (u32 i = 0; i < count; ++i) {
+        result = (result << 1) | ((value >> i) & 1);
+    }
+    return result;
+}
+
+internal void put_code(Bit_Writer* writer, Deflate_Code code) {
+    put_bits(writer, code.bits, code.length);
+}
+
+// NOTE: The fixed literal / length code from RFC 1951 3.2.6. Distance codes are all 5 bits.
+internal void build_fixed_deflate_codes(Deflate_Code* literal_codes, Deflate_Code* distance_codes) {
+    for (u32 symbol = 0; symbol < 288; ++symbol) {
+        u32 code, length;
+        if (symbol < 144) {
+            code = 0x30 + symbol;
+            length = 8;
+        } else if (symbol < 256) {
+            code = 0x190 + (symbol - 144);
+            length = 9;
+        } else if (symbol < 280) {
+            code = symbol - 256;
+            length = 7;
+        } else {
+            code = 0xC0 + (symbol - 280);
+            length = 8;
+        }
+        literal_codes[symbol].bits   = (u16)reverse_bits(code, length);
+        literal_codes[symbol].length = (u16)length;
+    }
+    
+    for (u32 symbol = 0; symbol < 30; ++symbol) {
+        distance_codes[symbol].bits   = (u16)reverse_bits(symbol, 5);
+        distance_codes[symbol].length = 5;
+    }
+}
+
+// NOTE: Length codes 257..285 and distance codes 0..29 come in groups of 4 and 2 that share
+// a number of extra bits, so the symbol falls out of the position of the top bit.
+internal void put_match(Bit_Writer* writer, Deflate_Code* literal_codes, Deflate_Code* distance_codes, u32 length, u32 distance) {
+    u32 v = length - 3;
+    if (length == 258) {
+        put_code(writer, literal_codes[285]);
+    } else if (v < 8) {
+        put_code(writer, literal_codes[257 + v]);
+    } else {
+        u32 top = 31 - __builtin_clz(v);
+        u32 extra_bits = top - 2;
+        put_code(writer, literal_codes[257 + 4*(top - 1) + ((v >> extra_bits) & 3)]);
+        put_bits(writer, v & ((1 << extra_bits) - 1), extra_bits);
+    }
+    
+    u32 d = distance - 1;
+    if (d < 4) {
+        put_code(writer, distance_codes[d]);
+    } else {
+        u32 top = 31 - __builtin_clz(d);
+        u32 extra_bits = top - 1;
+        put_code(writer, distance_codes[2*top + ((d >> extra_bits) & 1)]);
+        put_bits(writer, d & ((1 << extra_bits) - 1), extra_bits);
+    }
+}
+
+internal u32 read_u32(u8* at) {
+    u32 result;
+    memcpy(&result, at, sizeof(result));
+    return result;
+}
+
+// NOTE: Writes a raw deflate stream for data to out, and returns the end of it. out needs
+// room for size + size / 8 + 16 bytes, since no code is longer than 9 bits per input byte.
+internal u8* deflate_fast(u8* data, umm size, u8* out) {
+    Deflate_Code literal_codes[288];
+    Deflate_Code distance_codes[30];
+    build_fixed_deflate_codes(literal_codes, distance_codes);
+    
+    // NOTE: Positions are stored + 1, so zero means empty.
+    u32* table = (u32*)calloc(1 << DEFLATE_HASH_BITS, sizeof(u32));
+    
+    Bit_Writer writer = {};
+    writer.at = out;
+    put_bits(&writer, 1, 1); // NOTE: BFINAL
+    put_bits(&writer, 1, 2); // NOTE: BTYPE = fixed Huffman
+    
+    umm i = 0;
+    while (i + DEFLATE_MIN_MATCH <= size) {
+        u32 next = read_u32(data + i);
+        u32 hash = (next*2654435761u) >> (32 - DEFLATE_HASH_BITS);
+        umm candidate = table[hash];
+        table[hash] = (u32)(i + 1);
+        
+        if (candidate && (i - (candidate - 1) <= DEFLATE_WINDOW_SIZE) && (read_u32(data + candidate - 1) == next)) {
+            u8* match = data + candidate - 1;
+            umm max_length = Min(DEFLATE_MAX_MATCH, size - i);
+            umm length = DEFLATE_MIN_MATCH;
+            while ((length < max_length) && (match[length] == data[i + length])) {
+                ++length;
+            }
+            
+            put_match(&writer, literal_codes, distance_codes, (u32)length, (u32)(data + i - match));
+            i += length;
+        } else {
+            put_code(&writer, literal_codes[data[i]]);
+            ++i;
+        }
+    }
+    
+    while (i < size) {
+        put_code(&writer, literal_codes[data[i]]);
+        ++i;
+    }
+    
+    put_code(&writer, literal_codes[256]);
+    flush_bits(&writer);
+    
+    free(table);
+    return writer.at;
+}
+
+internal u32 adler32(u8* data, umm size) {
+    u32 a = 1;
+    u32 b = 0;
+    while (size > 0) {
+        // NOTE: The most bytes that can be summed before b could overflow 32 bits.
+        umm count = Min(size, 5552);
+        for (umm i = 0; i < count; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += count;
+        size -= count;
+    }
+    return (b << 16) | a;
+}
+
+internal void build_crc32_table(u32* table) {
+    for (u32 n = 0; n < 256; ++n) {
+        u32 c = n;
+        for (u32 k = 0; k < 8; ++k) {
+            c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        }
+        table[n] = c;
+    }
+}
+
+internal u32 crc32(u32* table, u8* data, umm size) {
+    u32 c = 0xFFFFFFFF;
+    for (umm i = 0; i < size; ++i) {
+        c = table[(c ^ data[i]) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFF;
+}
+
+//
+// NOTE: PNG. Rows are converted to RGBA and every filter is tried on each one, keeping the one
+// with the smallest sum of absolute (signed) filtered bytes, the usual libpng heuristic. All
+// five filters only depend on unfiltered bytes, so they're computed 16 bytes at a time.
+//
+
+typedef enum PngFilter {
+    PngFilter_None,
+    PngFilter_Sub,
+    PngFilter_Up,
+    PngFilter_Average,
+    PngFilter_Paeth,
+    
+    PngFilter_Count,
+} PngFilter;
+
+function
+u8 paeth_predictor(u8 a, u8 b, u8 c) {
+    s32 pa = abs((s32)b - (s32)c);
+    s32 pb = abs((s32)a - (s32)c);
+    s32 pc = abs((s32)a + (s32)b - 2*(s32)c);
+    u8 result = ((pa <= pb) && (pa <= pc)) ? a : ((pb <= pc) ? b : c);
+    return result;
+}
+
+internal __m128i paeth_predictor_half(__m128i a, __m128i b, __m128i c) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i b_c = _mm_sub_epi16(b, c);
+    __m128i a_c = _mm_sub_epi16(a, c);
+    __m128i pa = _mm_max_epi16(b_c, _mm_sub_epi16(zero, b_c));
+    __m128i pb = _mm_max_epi16(a_c, _mm_sub_epi16(zero, a_c));
+    __m128i pc = _mm_add_epi16(b_c, a_c);
+    pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+    
+    __m128i not_a = _mm_or_si128(_mm_cmpgt_epi16(pa, pb), _mm_cmpgt_epi16(pa, pc));
+    __m128i use_b = _mm_andnot_si128(_mm_cmpgt_epi16(pb, pc), not_a);
+    __m128i use_c = _mm_andnot_si128(use_b, not_a);
+    
+    __m128i result = _mm_or_si128(_mm_andnot_si128(not_a, a),
+                                  _mm_or_si128(_mm_and_si128(use_b, b), _mm_and_si128(use_c, c)));
+    return result;
+}
+
+function
+__m128i paeth_predictor(__m128i a, __m128i b, __m128i c) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = paeth_predictor_half(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero));
+    __m128i hi = paeth_predictor_half(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero));
+    return _mm_packus_epi16(lo, hi);
+}
+
+// NOTE: row and prior both have 4 zero bytes in front of them, and prior is all zero for the
+// first row, so the left / upper-left neighbours need no special cases.
+internal PngFilter filter_png_row(u8* row, u8* prior, u32 size, u8** candidates) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i one  = _mm_set1_epi8(1);
+    __m128i sums[PngFilter_Count];
+    for (u32 filter = 0; filter < PngFilter_Count; ++filter) {
+        sums[filter] = zero;
+    }
+    
+    u32 i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i x = _mm_loadu_si128((__m128i*)(row + i));
+        __m128i a = _mm_loadu_si128((__m128i*)(row + i - 4));
+        __m128i b = _mm_loadu_si128((__m128i*)(prior + i));
+        __m128i c = _mm_loadu_si128((__m128i*)(prior + i - 4));
+        
+        // NOTE: _mm_avg_epu8 rounds up, the Average filter wants floor((a + b) / 2).
+        __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+        
+        __m128i filtered[PngFilter_Count];
+        filtered[PngFilter_None]    = x;
+        filtered[PngFilter_Sub]     = _mm_sub_epi8(x, a);
+        filtered[PngFilter_Up]      = _mm_sub_epi8(x, b);
+        filtered[PngFilter_Average] = _mm_sub_epi8(x, average);
+        filtered[PngFilter_Paeth]   = _mm_sub_epi8(x, paeth_predictor(a, b, c));
+        
+        for (u32 filter = 0; filter < PngFilter_Count; ++filter) {
+            _mm_storeu_si128((__m128i*)(candidates[filter] + i), filtered[filter]);
+            __m128i magnitude = _mm_min_epu8(filtered[filter], _mm_sub_epi8(zero, filtered[filter]));
+            sums[filter] = _mm_add_epi32(sums[filter], _mm_sad_epu8(magnitude, zero));
+        }
+    }
+    
+    u32 costs[PngFilter_Count];
+    for (u32 filter = 0; filter < PngFilter_Count; ++filter) {
+        costs[filter] = (u32)_mm_cvtsi128_si32(sums[filter]) + (u32)_mm_cvtsi128_si32(_mm_srli_si128(sums[filter], 8));
+    }
+    
+    for (; i < size; ++i) {
+        u8 x = row[i];
+        u8 a = row[i - 4];
+        u8 b = prior[i];
+        u8 c = prior[i - 4];
+        
+        u8 filtered[PngFilter_Count];
+        filtered[PngFilter_None]    = x;
+        filtered[PngFilter_Sub]     = (u8)(x - a);
+        filtered[PngFilter_Up]      = (u8)(x - b);
+        filtered[PngFilter_Average] = (u8)(x - ((a + b) >> 1));
+        filtered[PngFilter_Paeth]   = (u8)(x - paeth_predictor(a, b, c));
+        
+        for (u32 filter = 0; filter < PngFilter_Count; ++filter) {
+            candidates[filter][i] = filtered[filter];
+            costs[filter] += (filtered[filter] < 128) ? filtered[filter] : 256 - filtered[filter];
+        }
+    }
+    
+    PngFilter result = PngFilter_None;
+    for (u32 filter = 1; filter < PngFilter_Count; ++filter) {
+        if (costs[filter] < costs[result]) {
+            result = (PngFilter)filter;
+        }
+    }
+    return result;
+}
+
+// NOTE: Swaps our BGRA into RGBA: the green and alpha bytes stay put, red and blue trade places.
+internal void convert_row_to_rgba(u32* src, u32 width, u8* dst) {
+    __m128i green_alpha = _mm_set1_epi32(0xFF00FF00);
+    __m128i low_byte    = _mm_set1_epi32(0x000000FF);
+    
+    u32 x = 0;
+    for (; x + 4 <= width; x += 4) {
+        __m128i p = _mm_loadu_si128((__m128i*)(src + x));
+        __m128i swapped = _mm_or_si128(_mm_and_si128(p, green_alpha),
+                                       _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 16), low_byte),
+                                                    _mm_slli_epi32(_mm_and_si128(p, low_byte), 16)));
+        _mm_storeu_si128((__m128i*)(dst + 4*x), swapped);
+    }
+    for (; x < width; ++x) {
+        Color_ARGB pixel = { .argb = src[x] };
+        dst[4*x + 0] = pixel.r;
+        dst[4*x + 1] = pixel.g;
+        dst[4*x + 2] = pixel.b;
+        dst[4*x + 3] = pixel.a;
+    }
+}
+
+internal u8* begin_png_chunk(u8* at, char* type) {
+    at += 4; // NOTE: Length, filled in by end_png_chunk
+    memcpy(at, type, 4);
+    return at + 4;
+}
+
+internal u8* end_png_chunk(u32* crc_table, u8* chunk_data, u8* at) {
+    put_u32_be(chunk_data - 8, (u32)(at - chunk_data));
+    return put_u32_be(at, crc32(crc_table, chunk_data - 4, (at - chunk_data) + 4));
+}
+
+function
+String_u8 encode_image_png(Image_u32* image) {
+    u32 row_size = 4*image->width;
+    umm filtered_size = (umm)(1 + row_size)*image->height;
+    u8* filtered = (u8*)malloc(filtered_size);
+    
+    u8* row_memory = (u8*)calloc(2*(4 + row_size) + PngFilter_Count*row_size, 1);
+    u8* row   = row_memory + 4;
+    u8* prior = row_memory + 4 + (4 + row_size);
+    u8* candidates[PngFilter_Count];
+    for (u32 filter = 0; filter < PngFilter_Count; ++filter) {
+        candidates[filter] = row_memory + 2*(4 + row_size) + filter*row_size;
+    }
+    
+    u8* filtered_at = filtered;
+    for (u32 y = image->height; y > 0; --y) {
+        convert_row_to_rgba(get_pixel_pointer(image, 0, y - 1), image->width, row);
+        
+        PngFilter filter = filter_png_row(row, prior, row_size, candidates);
+        *filtered_at++ = (u8)filter;
+        memcpy(filtered_at, candidates[filter], row_size);
+        filtered_at += row_size;
+        
+        Swap(row, prior);
+    }
+    free(row_memory);
+    
+    u32 crc_table[256];
+    build_crc32_table(crc_table);
+    
+    String_u8 result = {};
+    result.data = (u8*)malloc(filtered_size + filtered_size / 8 + 128);
+    
+    u8* at = result.data;
+    u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    memcpy(at, signature, sizeof(signature));
+    at += sizeof(signature);
+    
+    u8* chunk = begin_png_chunk(at, "IHDR");
+    at = put_u32_be(chunk, image->width);
+    at = put_u32_be(at, image->height);
+    *at++ = 8; // NOTE: Bit depth
+    *at++ = 6; // NOTE: Color type, RGBA
+    *at++ = 0; // NOTE: Compression method
+    *at++ = 0; // NOTE: Filter method
+    *at++ = 0; // NOTE: No interlacing
+    at = end_png_chunk(crc_table, chunk, at);
+    
+    chunk = begin_png_chunk(at, "IDAT");
+    at = chunk;
+    *at++ = 0x78; // NOTE: zlib header, deflate with a 32K window, fastest compression level
+    *at++ = 0x01;
+    at = deflate_fast(filtered, filtered_size, at);
+    at = put_u32_be(at, adler32(filtered, filtered_size));
+    at = end_png_chunk(crc_table, chunk, at);
+    
+    chunk = begin_png_chunk(at, "IEND");
+    at = end_png_chunk(crc_table, chunk, chunk);
+    
+    free(filtered);
+    
+    result.len = at - result.data;
+    return result;
+}
+
+function
+void write_image(char* file_name, Image_u32* image, ImageFormat format) {
+    if (format == ImageFormat_BMP) {
+        write_image(file_name, image);
+        return;
+    }
+    
+    String_u8 encoded = {};
+    switch (format) {
+        case ImageFormat_QOI: { encoded = encode_image_qoi(image); } break;
+        case ImageFormat_PNG: { encoded = encode_image_png(image); } break;
+        InvalidDefaultCase;
+    }
+    
+    FILE* out_file = fopen(file_name, "wb");
+    if (out_file) {
+        fwrite(encoded.data, encoded.len, 1, out_file);
+        fclose(out_file);
+    } else {
+        fprintf(stderr, "error: Unable to write output file %s.\n", file_name);
+    }
+    
+    free(encoded.data);
+}
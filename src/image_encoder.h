@@ -0,0 +1,23 @@
+/* date = October 19th 2026 3:20 pm */
+
+#ifndef IMAGE_ENCODER_H
+#define IMAGE_ENCODER_H
+
+typedef enum ImageFormat {
+    ImageFormat_BMP, // NOTE: Uncompressed 32 bit, no encoding cost but large
+    ImageFormat_QOI, // NOTE: Lossless, very fast to encode, usually a few times smaller than BMP
+    ImageFormat_PNG, // NOTE: Lossless, fixed Huffman deflate with a single-probe LZ77 matcher
+} ImageFormat;
+
+typedef struct Deflate_Code {
+    u16 bits;   // NOTE: Bit reversed, ready to be written LSB first
+    u16 length;
+} Deflate_Code;
+
+typedef struct Bit_Writer {
+    u8* at;
+    u64 bits;
+    u32 bit_count;
+} Bit_Writer;
+
+#endif //IMAGE_ENCODER_H
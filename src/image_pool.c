@@ -0,0 +1,116 @@
+// NOTE: Buffers at least this big go through allocate_pages when huge pages are on. Below
+// that a huge page would mostly be wasted.
+#define IMAGE_POOL_PAGE_THRESHOLD (1024*1024)
+
+function
+void create_image_pool(Image_Pool* pool, b32 use_huge_pages) {
+    memset(pool, 0, sizeof(*pool));
+    pool->use_huge_pages = use_huge_pages;
+}
+
+internal void free_pooled_image(Pooled_Image* image) {
+    if (image->page_backed) {
+        free_pages(image->pixels, image->size);
+    } else {
+        free_aligned(image->pixels);
+    }
+}
+
+// NOTE: The contents are undefined. With a null pool this is allocate_image.
+function
+Image_u32 acquire_image(Image_Pool* pool, u32 width, u32 height) {
+    if (!pool) {
+        return allocate_image(width, height);
+    }
+    
+    Pooled_Image pooled = {};
+    
+    u32 free_count = buf_len(pool->free_images);
+    for (u32 i = 0; i < free_count; ++i) {
+        Pooled_Image* candidate = pool->free_images + i;
+        if ((candidate->width == width) && (candidate->height == height)) {
+            pooled = *candidate;
+            pool->free_images[i] = pool->free_images[free_count - 1];
+            buf__hdr(pool->free_images)->len -= 1;
+            pool->reuse_count += 1;
+            break;
+        }
+    }
+    
+    if (!pooled.pixels) {
+        pooled.width  = width;
+        pooled.height = height;
+        pooled.size   = sizeof(u32)*(umm)width*height;
+        if (pool->use_huge_pages && (pooled.size >= IMAGE_POOL_PAGE_THRESHOLD)) {
+            pooled.pixels = (u32*)allocate_pages(&pooled.size, true);
+            pooled.page_backed = true;
+        } else {
+            pooled.pixels = (u32*)allocate_aligned(pooled.size, IMAGE_ALIGNMENT);
+        }
+        pool->allocation_count += 1;
+    }
+    
+    buf_push(pool->live_images, pooled);
+    
+    Image_u32 result = {};
+    result.width  = width;
+    result.height = height;
+    result.pitch  = width;
+    result.pixels = pooled.pixels;
+    return result;
+}
+
+function
+Image_u32 acquire_cleared_image(Image_Pool* pool, u32 width, u32 height, Color_ARGB color) {
+    Image_u32 result = acquire_image(pool, width, height);
+    clear_image(&result, color);
+    return result;
+}
+
+// NOTE: Hands an image from acquire_image back. With a null pool this is free_image.
+function
+void release_image(Image_Pool* pool, Image_u32* image) {
+    if (!pool) {
+        free_image(image);
+        return;
+    }
+    
+    u32 live_count = buf_len(pool->live_images);
+    u32 i = 0;
+    while ((i < live_count) && (pool->live_images[i].pixels != image->pixels)) {
+        ++i;
+    }
+    
+    // NOTE: Not from this pool, or already released.
+    Assert(i < live_count);
+    if (i < live_count) {
+        buf_push(pool->free_images, pool->live_images[i]);
+        pool->live_images[i] = pool->live_images[live_count - 1];
+        buf__hdr(pool->live_images)->len -= 1;
+    }
+    
+    memset(image, 0, sizeof(*image));
+}
+
+// NOTE: Gives every image that isn't in use back to the OS.
+function
+void trim_image_pool(Image_Pool* pool) {
+    for (u32 i = 0; i < buf_len(pool->free_images); ++i) {
+        free_pooled_image(pool->free_images + i);
+    }
+    if (pool->free_images) {
+        buf__hdr(pool->free_images)->len = 0;
+    }
+}
+
+function
+void destroy_image_pool(Image_Pool* pool) {
+    Assert(buf_len(pool->live_images) == 0);
+    trim_image_pool(pool);
+    for (u32 i = 0; i < buf_len(pool->live_images); ++i) {
+        free_pooled_image(pool->live_images + i);
+    }
+    buf_free(pool->free_images);
+    buf_free(pool->live_images);
+    memset(pool, 0, sizeof(*pool));
+}
@@ -0,0 +1,31 @@
+/* date = October 19th 2026 4:55 pm */
+
+#ifndef IMAGE_POOL_H
+#define IMAGE_POOL_H
+
+//
+// NOTE: Recycles Image_u32 buffers by size, so code that needs a few full-size temporaries per
+// call (or per frame) stops paying for malloc, page faults and a memset every time. Images come
+// out of the pool with whatever the last user left in them; ask for a clear if you need one.
+// A pool isn't thread safe, give each thread its own.
+//
+
+typedef struct Pooled_Image {
+    u32 width;
+    u32 height;
+    u32* pixels;
+    umm size;        // NOTE: Allocation size, which can be bigger than the pixels with huge pages
+    b32 page_backed; // NOTE: From allocate_pages rather than allocate_aligned
+} Pooled_Image;
+
+typedef struct Image_Pool {
+    b32 use_huge_pages;
+    
+    Pooled_Image* free_images; // NOTE: Stretchy buffer
+    Pooled_Image* live_images; // NOTE: Stretchy buffer
+    
+    u64 reuse_count;
+    u64 allocation_count;
+} Image_Pool;
+
+#endif //IMAGE_POOL_H
@@ -0,0 +1,160 @@
+function
+b32 pop_job(Job_Worker* worker, u32* out_index) {
+    b32 result = false;
+    
+    u64 range = atomic_load(&worker->range);
+    for (;;) {
+        u32 begin = (u32)(range & 0xFFFFFFFF);
+        u32 end   = (u32)(range >> 32);
+        if (begin >= end) {
+            break;
+        }
+        
+        u64 new_range = (u64)(begin + 1) | ((u64)end << 32);
+        if (atomic_compare_exchange(&worker->range, &range, new_range)) {
+            *out_index = begin;
+            result = true;
+            break;
+        }
+    }
+    
+    return result;
+}
+
+// NOTE: Takes the back half of some other worker's range. The stolen range is returned rather
+// than installed so the caller can deal with the case where its own range changed meanwhile.
+function
+b32 steal_jobs(Job_Pool* pool, Job_Worker* thief, u64* out_range) {
+    b32 result = false;
+    
+    for (u32 offset = 1; !result && (offset < pool->worker_count); ++offset) {
+        Job_Worker* victim = pool->workers + (thief->worker_index + offset) % pool->worker_count;
+        
+        u64 range = atomic_load(&victim->range);
+        for (;;) {
+            u32 begin = (u32)(range & 0xFFFFFFFF);
+            u32 end   = (u32)(range >> 32);
+            if (begin >= end) {
+                break;
+            }
+            
+            u32 take      = (end - begin + 1) / 2;
+            u32 new_end   = end - take;
+            u64 new_range = (u64)begin | ((u64)new_end << 32);
+            if (atomic_compare_exchange(&victim->range, &range, new_range)) {
+                *out_range = (u64)new_end | ((u64)end << 32);
+                result = true;
+                break;
+            }
+        }
+    }
+    
+    return result;
+}
+
+function
+void run_jobs(Job_Worker* worker) {
+    Job_Pool* pool = worker->pool;
+    for (;;) {
+        u32 job_index;
+        u64 own_range = atomic_load(&worker->range);
+        u64 stolen_range;
+        if (pop_job(worker, &job_index)) {
+            pool->proc(pool->user_data, job_index, worker->worker_index);
+            atomic_sub(&pool->pending, 1);
+        } else if (steal_jobs(pool, worker, &stolen_range)) {
+            // NOTE: Normally our range is still the empty one we just saw and the stolen jobs
+            // become ours, open to thieves again. If a worker woke up late for the previous
+            // batch, parallel_for may have handed it a fresh range in the meantime, and that
+            // must not be overwritten, so the stolen jobs are just run right here instead.
+            if (!atomic_compare_exchange(&worker->range, &own_range, stolen_range)) {
+                u32 begin = (u32)(stolen_range & 0xFFFFFFFF);
+                u32 end   = (u32)(stolen_range >> 32);
+                for (u32 index = begin; index < end; ++index) {
+                    pool->proc(pool->user_data, index, worker->worker_index);
+                    atomic_sub(&pool->pending, 1);
+                }
+            }
+        } else {
+            break;
+        }
+    }
+}
+
+internal void job_worker_thread(void* user_data) {
+    Job_Worker* worker = (Job_Worker*)user_data;
+    Job_Pool* pool = worker->pool;
+    for (;;) {
+        wait_semaphore(&pool->wake);
+        if (atomic_load(&pool->quit)) {
+            break;
+        }
+        run_jobs(worker);
+    }
+}
+
+// NOTE: Pass 0 for worker_count to use one worker per processor.
+function
+void create_job_pool(Job_Pool* pool, u32 worker_count) {
+    memset(pool, 0, sizeof(*pool));
+    
+    if (!worker_count) {
+        worker_count = get_processor_count();
+    }
+    
+    pool->worker_count = worker_count;
+    pool->workers = (Job_Worker*)allocate_aligned(sizeof(Job_Worker)*worker_count, 64);
+    pool->threads = (Thread*)malloc(sizeof(Thread)*worker_count);
+    memset(pool->workers, 0, sizeof(Job_Worker)*worker_count);
+    memset(pool->threads, 0, sizeof(Thread)*worker_count);
+    create_semaphore(&pool->wake, 0);
+    
+    for (u32 worker_index = 0; worker_index < worker_count; ++worker_index) {
+        Job_Worker* worker = pool->workers + worker_index;
+        worker->pool         = pool;
+        worker->worker_index = worker_index;
+        if (worker_index > 0) {
+            pool->threads[worker_index] = create_thread(job_worker_thread, worker);
+        }
+    }
+}
+
+function
+void destroy_job_pool(Job_Pool* pool) {
+    atomic_store(&pool->quit, 1);
+    signal_semaphore(&pool->wake, pool->worker_count - 1);
+    for (u32 worker_index = 1; worker_index < pool->worker_count; ++worker_index) {
+        join_thread(&pool->threads[worker_index]);
+    }
+    destroy_semaphore(&pool->wake);
+    free_aligned(pool->workers);
+    free(pool->threads);
+    memset(pool, 0, sizeof(*pool));
+}
+
+// NOTE: Calls proc once for every index in [0, job_count) and returns when all of them are
+// done. The calling thread works on the batch too. worker_index is stable for the duration
+// of a job, so it can be used to pick per-worker scratch memory.
+function
+void parallel_for(Job_Pool* pool, u32 job_count, Job_Proc* proc, void* user_data) {
+    if (job_count) {
+        pool->proc      = proc;
+        pool->user_data = user_data;
+        atomic_store(&pool->pending, job_count);
+        
+        for (u32 worker_index = 0; worker_index < pool->worker_count; ++worker_index) {
+            u32 begin = (u32)(((u64)job_count*worker_index) / pool->worker_count);
+            u32 end   = (u32)(((u64)job_count*(worker_index + 1)) / pool->worker_count);
+            atomic_store(&pool->workers[worker_index].range, (u64)begin | ((u64)end << 32));
+        }
+        
+        signal_semaphore(&pool->wake, pool->worker_count - 1);
+        
+        run_jobs(&pool->workers[0]);
+        
+        // NOTE: Everything has been handed out at this point, just wait for the stragglers.
+        while (atomic_load(&pool->pending)) {
+            yield_thread();
+        }
+    }
+}
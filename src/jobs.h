@@ -0,0 +1,35 @@
+/* date = October 19th 2026 11:20 am */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+//
+// NOTE: A small fork-join pool for lots of little jobs. A batch of N jobs is split into one
+// contiguous range of indices per worker. Workers pop from the front of their own range and,
+// once it runs dry, steal the back half of someone else's, so uneven jobs still balance out
+// without a shared queue everyone contends on.
+//
+
+typedef void Job_Proc(void* user_data, u32 job_index, u32 worker_index);
+
+typedef struct Job_Worker {
+    // NOTE: [begin, end) packed as begin | (end << 32) so it can be updated with one CAS
+    u64 range;
+    
+    struct Job_Pool* pool;
+    u32 worker_index;
+} __attribute__((aligned(64))) Job_Worker;
+
+typedef struct Job_Pool {
+    u32 worker_count; // NOTE: Including the thread that calls parallel_for, which is worker 0
+    Job_Worker* workers;
+    Thread* threads;
+    Semaphore wake;
+    
+    Job_Proc* proc;
+    void* user_data;
+    u32 pending;
+    u32 quit;
+} Job_Pool;
+
+#endif //JOBS_H
@@ -0,0 +1,356 @@
+//
+// NOTE: Clipping
+//
+
+// NOTE: Liang-Barsky. Cuts the segment down to the part inside [min, max], and returns false
+// if there's nothing left.
+internal b32 clip_line(V2* p0, V2* p1, V2 min, V2 max) {
+    V2 d = *p1 - *p0;
+    f32 p[4] = { -d.x, d.x, -d.y, d.y };
+    f32 q[4] = { p0->x - min.x, max.x - p0->x, p0->y - min.y, max.y - p0->y };
+    
+    f32 t0 = 0.0f;
+    f32 t1 = 1.0f;
+    for (u32 i = 0; i < 4; ++i) {
+        if (p[i] == 0.0f) {
+            if (q[i] < 0.0f) {
+                return false;
+            }
+        } else {
+            f32 t = q[i] / p[i];
+            if (p[i] < 0.0f) {
+                t0 = Max(t0, t);
+            } else {
+                t1 = Min(t1, t);
+            }
+        }
+    }
+    
+    // NOTE: Also false for NaN.
+    if (!(t0 <= t1)) {
+        return false;
+    }
+    
+    V2 start = *p0 + d*t0;
+    *p1 = *p0 + d*t1;
+    *p0 = start;
+    return true;
+}
+
+//
+// NOTE: Thin lines
+//
+
+// NOTE: color*coverage / 256, coverage from 0 to 256.
+internal u32 scale_color(u32 color, u32 coverage) {
+    u32 br = (((color & 0x00FF00FF)*coverage) >> 8) & 0x00FF00FF;
+    u32 ga = (((color >> 8) & 0x00FF00FF)*coverage) & 0xFF00FF00;
+    u32 result = br | ga;
+    return result;
+}
+
+internal void blend_line_pixel(u32* pixel, u32 color) {
+    *pixel = (u32)_mm_cvtsi128_si32(blend_pixels(_mm_cvtsi32_si128((s32)color), _mm_cvtsi32_si128((s32)*pixel), BlendMode_Over));
+}
+
+// NOTE: One pixel per column (or row, if the line is steep), the one the line passes through
+// at the column's center. Both ends are included.
+internal void draw_aliased_line(Image_u32* image, V2 p0, V2 p1, Color_ARGB color) {
+    if (!clip_line(&p0, &p1, v2(0.0f, 0.0f), v2((f32)image->width, (f32)image->height))) {
+        return;
+    }
+    
+    b32 opaque = (color.a == 255);
+    V2 d = p1 - p0;
+    if (Abs(d.x) >= Abs(d.y)) {
+        if (p1.x < p0.x) {
+            Swap(p0, p1);
+        }
+        f32 slope = (d.x != 0.0f) ? (d.y / d.x) : 0.0f;
+        s32 first = Max((s32)ceilf (p0.x - 0.5f), 0);
+        s32 last  = Min((s32)floorf(p1.x - 0.5f), (s32)image->width - 1);
+        f32 y_at_first = p0.y + ((f32)first + 0.5f - p0.x)*slope;
+        
+        for (s32 x = first; x <= last; ++x) {
+            s32 y = (s32)floorf(y_at_first + (f32)(x - first)*slope);
+            y = Clamp(y, 0, (s32)image->height - 1);
+            u32* pixel = get_pixel_pointer(image, x, y);
+            if (opaque) {
+                *pixel = color.argb;
+            } else {
+                blend_line_pixel(pixel, color.argb);
+            }
+        }
+    } else {
+        if (p1.y < p0.y) {
+            Swap(p0, p1);
+        }
+        f32 slope = d.x / d.y;
+        s32 first = Max((s32)ceilf (p0.y - 0.5f), 0);
+        s32 last  = Min((s32)floorf(p1.y - 0.5f), (s32)image->height - 1);
+        f32 x_at_first = p0.x + ((f32)first + 0.5f - p0.y)*slope;
+        
+        u32* row = get_pixel_pointer(image, 0, first);
+        for (s32 y = first; y <= last; ++y, row += image->pitch) {
+            s32 x = (s32)floorf(x_at_first + (f32)(y - first)*slope);
+            x = Clamp(x, 0, (s32)image->width - 1);
+            if (opaque) {
+                row[x] = color.argb;
+            } else {
+                blend_line_pixel(row + x, color.argb);
+            }
+        }
+    }
+}
+
+// NOTE: Xiaolin Wu's lines. Each column is split between the two pixels nearest the line by
+// how close their centers are, and the end columns are weighted by how much of them the
+// line covers, so lines that meet at an endpoint join up without a bright spot. strength
+// scales the whole line, for widths below 1.
+internal void draw_anti_aliased_line(Image_u32* image, V2 p0, V2 p1, Color_ARGB color, f32 strength) {
+    // NOTE: A pixel of margin, for the half covered pixels just outside the image.
+    if (!clip_line(&p0, &p1, v2(-1.0f, -1.0f), v2((f32)image->width + 1.0f, (f32)image->height + 1.0f))) {
+        return;
+    }
+    
+    // NOTE: Steep lines are done with x and y swapped, so the loop always steps along x.
+    b32 steep = Abs(p1.y - p0.y) > Abs(p1.x - p0.x);
+    if (steep) {
+        p0 = v2(p0.y, p0.x);
+        p1 = v2(p1.y, p1.x);
+    }
+    if (p1.x < p0.x) {
+        Swap(p0, p1);
+    }
+    s32 major_size = steep ? (s32)image->height : (s32)image->width;
+    s32 minor_size = steep ? (s32)image->width  : (s32)image->height;
+    
+    f32 dx = p1.x - p0.x;
+    f32 slope = (dx != 0.0f) ? ((p1.y - p0.y) / dx) : 0.0f;
+    s32 first = Max((s32)floorf(p0.x), 0);
+    s32 last  = Min((s32)ceilf (p1.x) - 1, major_size - 1);
+    
+    for (s32 major = first; major <= last; ++major) {
+        f32 along = clamp01(Min((f32)major + 1.0f, p1.x) - Max((f32)major, p0.x))*strength;
+        
+        f32 minor_center = p0.y + ((f32)major + 0.5f - p0.x)*slope - 0.5f;
+        f32 minor_floor = floorf(minor_center);
+        f32 fraction = minor_center - minor_floor;
+        s32 minor = (s32)minor_floor;
+        
+        u32 coverages[2] = { (u32)((1.0f - fraction)*along*256.0f + 0.5f), (u32)(fraction*along*256.0f + 0.5f) };
+        for (u32 i = 0; i < 2; ++i) {
+            s32 m = minor + (s32)i;
+            if ((m >= 0) && (m < minor_size) && coverages[i]) {
+                u32* pixel = steep ? get_pixel_pointer(image, m, major) : get_pixel_pointer(image, major, m);
+                blend_line_pixel(pixel, scale_color(color.argb, coverages[i]));
+            }
+        }
+    }
+}
+
+//
+// NOTE: Wide lines
+//
+
+// NOTE: The x range where |a*x + b| <= radius, intersected with [*lo, *hi].
+internal void clip_slab(f32 a, f32 b, f32 radius, f32* lo, f32* hi) {
+    if (a != 0.0f) {
+        f32 x0 = (-radius - b) / a;
+        f32 x1 = ( radius - b) / a;
+        *lo = Max(*lo, Min(x0, x1));
+        *hi = Min(*hi, Max(x0, x1));
+    } else if (!(Abs(b) <= radius)) {
+        *hi = *lo - 1.0f;
+    }
+}
+
+internal void draw_wide_line(Image_u32* image, V2 p0, V2 p1, f32 width, Color_ARGB color, LineStyle style) {
+    f32 half_width = 0.5f*width;
+    f32 fringe = (style == LineStyle_AntiAliased) ? 0.5f : 0.0f;
+    
+    // NOTE: Far enough out that the cut ends can't be seen.
+    f32 margin = half_width + 1.0f;
+    if (!clip_line(&p0, &p1, v2(-margin, -margin), v2((f32)image->width + margin, (f32)image->height + margin))) {
+        return;
+    }
+    
+    V2 d = p1 - p0;
+    f32 line_length = length(d);
+    V2 direction = (line_length > 0.0f) ? (d / line_length) : v2(1.0f, 0.0f);
+    V2 normal = v2(-direction.y, direction.x);
+    V2 middle = 0.5f*(p0 + p1);
+    f32 half_length = 0.5f*line_length;
+    
+    // NOTE: Pixels whose centers are within these of the middle line and of the middle of
+    // the line get some coverage.
+    f32 across_radius = half_width + fringe;
+    f32 along_radius  = half_length + fringe;
+    
+    f32 extent_y = Abs(direction.y)*along_radius + Abs(normal.y)*across_radius;
+    s32 min_y = Max((s32)ceilf (middle.y - extent_y - 0.5f), 0);
+    s32 max_y = Min((s32)floorf(middle.y + extent_y - 0.5f), (s32)image->height - 1);
+    
+    __m128 lane_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    __m128 across_step  = _mm_set1_ps(normal.x);
+    __m128 along_step   = _mm_set1_ps(direction.x);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one  = _mm_set1_ps(1.0f);
+    __m128i color_pixels = _mm_set1_epi32((s32)color.argb);
+    __m128i pair_mask = _mm_set1_epi32(0x00FF00FF);
+    
+    for (s32 y = min_y; y <= max_y; ++y) {
+        f32 center_y = (f32)y + 0.5f - middle.y;
+        f32 across_b = normal.y*center_y - normal.x*middle.x;
+        f32 along_b  = direction.y*center_y - direction.x*middle.x;
+        
+        // NOTE: x here is a pixel center.
+        f32 lo = 0.5f;
+        f32 hi = (f32)image->width - 0.5f;
+        clip_slab(normal.x, across_b, across_radius, &lo, &hi);
+        clip_slab(direction.x, along_b, along_radius, &lo, &hi);
+        if (!(lo <= hi)) {
+            continue;
+        }
+        
+        s32 begin = (s32)ceilf(lo - 0.5f);
+        s32 end   = (s32)floorf(hi - 0.5f) + 1;
+        u32* row = get_pixel_pointer(image, 0, y);
+        
+        for (s32 x = begin; x < end; x += 4) {
+            __m128 center_x = _mm_add_ps(_mm_set1_ps((f32)x), lane_offsets);
+            __m128 across = abs_ps(_mm_add_ps(_mm_mul_ps(across_step, center_x), _mm_set1_ps(across_b)));
+            __m128 along  = abs_ps(_mm_add_ps(_mm_mul_ps(along_step,  center_x), _mm_set1_ps(along_b)));
+            
+            __m128i coverage;
+            if (style == LineStyle_AntiAliased) {
+                __m128 across_coverage = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(across_radius), across), zero), one);
+                __m128 along_coverage  = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(along_radius),  along),  zero), one);
+                coverage = _mm_cvtps_epi32(_mm_mul_ps(_mm_mul_ps(across_coverage, along_coverage), _mm_set1_ps(256.0f)));
+            } else {
+                __m128 inside = _mm_and_ps(_mm_cmple_ps(across, _mm_set1_ps(across_radius)),
+                                           _mm_cmple_ps(along,  _mm_set1_ps(along_radius)));
+                coverage = _mm_and_si128(_mm_castps_si128(inside), _mm_set1_epi32(256));
+            }
+            coverage = _mm_or_si128(coverage, _mm_slli_epi32(coverage, 16));
+            
+            // NOTE: color*coverage / 256 for both byte pairs, the same as scale_color.
+            __m128i br = _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(color_pixels, pair_mask), coverage), 8);
+            __m128i ga = _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(color_pixels, 8), pair_mask), coverage), 8);
+            __m128i src = _mm_or_si128(br, _mm_slli_epi16(ga, 8));
+            
+            u32 count = Min(end - x, 4);
+            if (count == 4) {
+                __m128i dst = _mm_loadu_si128((__m128i*)(row + x));
+                _mm_storeu_si128((__m128i*)(row + x), blend_pixels(src, dst, BlendMode_Over));
+            } else {
+                u32 src_pixels[4];
+                _mm_storeu_si128((__m128i*)src_pixels, src);
+                blend_span(row + x, src_pixels, count, BlendMode_Over);
+            }
+        }
+    }
+}
+
+//
+// NOTE: Drawing
+//
+
+function
+void draw_line(Image_u32* image, V2 p0, V2 p1, f32 width, Color_ARGB color, LineStyle style) {
+    if (width > 1.0f) {
+        draw_wide_line(image, p0, p1, width, color, style);
+    } else if (style == LineStyle_AntiAliased) {
+        draw_anti_aliased_line(image, p0, p1, color, Max(width, 0.0f));
+    } else {
+        draw_aliased_line(image, p0, p1, color);
+    }
+}
+
+// NOTE: line_count lines, from points[indices[2*i]] to points[indices[2*i + 1]].
+function
+void draw_lines(Image_u32* image, V2* points, u32* indices, u32 line_count, f32 width, Color_ARGB color, LineStyle style) {
+    for (u32 line_index = 0; line_index < line_count; ++line_index) {
+        draw_line(image, points[indices[2*line_index]], points[indices[2*line_index + 1]], width, color, style);
+    }
+}
+
+//
+// NOTE: Wireframes
+//
+
+internal int compare_edge_keys(const void* a, const void* b) {
+    u64 key_a = *(u64*)a;
+    u64 key_b = *(u64*)b;
+    int result = (key_a > key_b) - (key_a < key_b);
+    return result;
+}
+
+// NOTE: Each edge is keyed by its two vertices, smaller index first, so the copies from
+// neighbouring triangles sort next to each other and only the first is kept.
+function
+Mesh_Edges build_mesh_edges(Mesh* mesh) {
+    u64* keys = (u64*)malloc(sizeof(u64)*3*(umm)mesh->triangle_count);
+    u32 key_count = 0;
+    for (u32 triangle_index = 0; triangle_index < mesh->triangle_count; ++triangle_index) {
+        Triangle* triangle = mesh->triangles + triangle_index;
+        for (u32 i = 0; i < 3; ++i) {
+            u32 a = triangle->e[i];
+            u32 b = triangle->e[(i + 1) % 3];
+            if (a != b) {
+                keys[key_count++] = ((u64)Min(a, b) << 32) | Max(a, b);
+            }
+        }
+    }
+    qsort(keys, key_count, sizeof(u64), compare_edge_keys);
+    
+    Mesh_Edges result = {};
+    result.indices = (u32*)malloc(sizeof(u32)*2*(umm)Max(key_count, 1));
+    for (u32 key_index = 0; key_index < key_count; ++key_index) {
+        if ((key_index == 0) || (keys[key_index] != keys[key_index - 1])) {
+            result.indices[2*result.edge_count]     = (u32)(keys[key_index] >> 32);
+            result.indices[2*result.edge_count + 1] = (u32)keys[key_index];
+            ++result.edge_count;
+        }
+    }
+    
+    free(keys);
+    return result;
+}
+
+function
+void free_mesh_edges(Mesh_Edges* edges) {
+    free(edges->indices);
+    memset(edges, 0, sizeof(*edges));
+}
+
+// NOTE: Every vertex is transformed once, then every edge drawn once, clipped to the near plane
+// first like triangles are. There's no depth test, it's for drawing over the shaded mesh.
+function
+void draw_mesh_wireframe(Image_u32* image, Mesh* mesh, Mesh_Edges* edges, M4x4 model_view_projection, f32 width, Color_ARGB color, LineStyle style) {
+    V4* clip_positions = (V4*)malloc(sizeof(V4)*(umm)Max(mesh->vertex_count, 1));
+    for (u32 vertex_index = 0; vertex_index < mesh->vertex_count; ++vertex_index) {
+        V3 p = mesh->vertices[vertex_index];
+        clip_positions[vertex_index] = m4x4_transform_v4(model_view_projection, v4(p.x, p.y, p.z, 1.0f));
+    }
+    
+    V2 size = v2((f32)image->width, (f32)image->height);
+    for (u32 edge_index = 0; edge_index < edges->edge_count; ++edge_index) {
+        V4 a = clip_positions[edges->indices[2*edge_index]];
+        V4 b = clip_positions[edges->indices[2*edge_index + 1]];
+        if ((a.z < 0.0f) && (b.z < 0.0f)) {
+            continue;
+        }
+        if (a.z < 0.0f) {
+            a = a + (b - a)*(a.z / (a.z - b.z));
+        } else if (b.z < 0.0f) {
+            b = b + (a - b)*(b.z / (b.z - a.z));
+        }
+        
+        V2 p0 = (0.5f*a.xy / a.w + 0.5f)*size;
+        V2 p1 = (0.5f*b.xy / b.w + 0.5f)*size;
+        draw_line(image, p0, p1, width, color, style);
+    }
+    
+    free(clip_positions);
+}
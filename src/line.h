@@ -0,0 +1,28 @@
+/* date = October 19th 2026 10:15 pm */
+
+#ifndef LINE_H
+#define LINE_H
+
+//
+// NOTE: Lines, for wireframes and overlays. Positions are in pixels with pixel centers at +0.5,
+// same as the rasterizer, and lines are clipped to the image before anything else, so the
+// endpoints can be anywhere. Colors are premultiplied and go on with BlendMode_Over.
+//
+// Lines up to a pixel wide step along their major axis. Aliased ones set one pixel per step,
+// anti-aliased ones split it between the two nearest pixels (Xiaolin Wu). Wider lines are
+// rotated rectangles, scanned a row at a time like triangles, four pixels per step, with
+// coverage from the distance to their edges. Their ends are cut square at the endpoints.
+//
+
+typedef enum LineStyle {
+    LineStyle_Aliased,
+    LineStyle_AntiAliased,
+} LineStyle;
+
+// NOTE: Every edge of a mesh once, however many triangles share it.
+typedef struct Mesh_Edges {
+    u32 edge_count;
+    u32* indices; // NOTE: Two vertex indices per edge
+} Mesh_Edges;
+
+#endif //LINE_H
@@ -0,0 +1,432 @@
+//
+// NOTE: Building shapes
+//
+
+function
+void begin_contour(Shape* shape) {
+    Shape_Contour contour = {};
+    contour.first_edge = (u32)buf_len(shape->edges);
+    buf_push(shape->contours, contour);
+}
+
+function
+void add_edge(Shape* shape, V2 p0, V2 p1) {
+    Assert(buf_len(shape->contours));
+    Shape_Edge edge = {};
+    edge.p0    = p0;
+    edge.p1    = p1;
+    edge.color = EdgeColor_White;
+    buf_push(shape->edges, edge);
+    shape->contours[buf_len(shape->contours) - 1].edge_count += 1;
+}
+
+function
+void add_polygon(Shape* shape, V2* points, u32 point_count) {
+    begin_contour(shape);
+    for (u32 point_index = 0; point_index < point_count; ++point_index) {
+        add_edge(shape, points[point_index], points[(point_index + 1) % point_count]);
+    }
+}
+
+function
+void free_shape(Shape* shape) {
+    buf_free(shape->edges);
+    buf_free(shape->contours);
+}
+
+//
+// NOTE: Traces the pixel boundaries of a mask into a shape. Boundaries run along the pixel
+// grid, one lattice vertex per pixel corner, and straight runs get merged into single edges.
+// Where two inside pixels only touch at a corner the trace turns left, keeping them apart.
+// This is fine for blocky masks. Stair-stepped diagonals come out as lots of tiny corners, so
+// real glyphs should be added from their outlines with add_polygon instead.
+//
+
+enum {
+    TraceDir_PosX = 0x1,
+    TraceDir_PosY = 0x2,
+    TraceDir_NegX = 0x4,
+    TraceDir_NegY = 0x8,
+};
+
+function
+b32 is_mask_inside(Image_u32* src, s32 x, s32 y) {
+    b32 result = false;
+    if ((x >= 0) && (y >= 0) && (x < (s32)src->width) && (y < (s32)src->height)) {
+        result = ((Color_ARGB) { .argb = get_pixel(src, x, y) }.a > 127);
+    }
+    return result;
+}
+
+function
+u32 choose_trace_direction(u32 available, u32 incoming_index) {
+    // NOTE: Directions are in counter-clockwise order, so + 1 is a left turn.
+    u32 result = 0;
+    u32 preference[] = { (incoming_index + 1) % 4, incoming_index, (incoming_index + 3) % 4 };
+    for (u32 i = 0; i < ArrayCount(preference); ++i) {
+        if (available & (1 << preference[i])) {
+            result = preference[i];
+            break;
+        }
+    }
+    return result;
+}
+
+function
+Shape shape_from_mask(Image_u32* src) {
+    Shape shape = {};
+    
+    V2i steps[] = { { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 } };
+    
+    u32 lattice_width  = src->width  + 1;
+    u32 lattice_height = src->height + 1;
+    u8* outgoing = (u8*)malloc(lattice_width*lattice_height);
+    memset(outgoing, 0, lattice_width*lattice_height);
+    
+    // NOTE: Every boundary of an inside pixel, directed so that the pixel is on its left.
+    for (s32 y = 0; y < (s32)src->height; ++y) {
+        for (s32 x = 0; x < (s32)src->width; ++x) {
+            if (is_mask_inside(src, x, y)) {
+                if (!is_mask_inside(src, x - 1, y)) { outgoing[(y + 1)*lattice_width + x    ] |= TraceDir_NegY; }
+                if (!is_mask_inside(src, x + 1, y)) { outgoing[(y    )*lattice_width + x + 1] |= TraceDir_PosY; }
+                if (!is_mask_inside(src, x, y - 1)) { outgoing[(y    )*lattice_width + x    ] |= TraceDir_PosX; }
+                if (!is_mask_inside(src, x, y + 1)) { outgoing[(y + 1)*lattice_width + x + 1] |= TraceDir_NegX; }
+            }
+        }
+    }
+    
+    V2i* corners = 0;
+    for (u32 start_y = 0; start_y < lattice_height; ++start_y) {
+        for (u32 start_x = 0; start_x < lattice_width; ++start_x) {
+            while (outgoing[start_y*lattice_width + start_x]) {
+                u8* start_bits = outgoing + start_y*lattice_width + start_x;
+                u32 start_dir = __builtin_ctz(*start_bits);
+                *start_bits &= ~(1 << start_dir);
+                
+                if (corners) {
+                    buf__hdr(corners)->len = 0;
+                }
+                buf_push(corners, v2i(start_x, start_y));
+                
+                V2i at  = v2i(start_x, start_y) + steps[start_dir];
+                u32 dir = start_dir;
+                for (;;) {
+                    u8* bits = outgoing + at.y*lattice_width + at.x;
+                    b32 at_start = ((u32)at.x == start_x) && ((u32)at.y == start_y);
+                    
+                    u32 available = *bits;
+                    if (at_start) {
+                        available |= (1 << start_dir);
+                    }
+                    u32 next_dir = choose_trace_direction(available, dir);
+                    
+                    if (at_start && (next_dir == start_dir)) {
+                        if (dir == start_dir) {
+                            // NOTE: Went straight through the start, so it isn't a corner after all.
+                            memmove(corners, corners + 1, sizeof(V2i)*(buf_len(corners) - 1));
+                            buf__hdr(corners)->len -= 1;
+                        }
+                        break;
+                    }
+                    
+                    *bits &= ~(1 << next_dir);
+                    if (next_dir != dir) {
+                        buf_push(corners, at);
+                    }
+                    
+                    dir = next_dir;
+                    at += steps[dir];
+                }
+                
+                begin_contour(&shape);
+                u32 corner_count = (u32)buf_len(corners);
+                for (u32 corner_index = 0; corner_index < corner_count; ++corner_index) {
+                    V2i p0 = corners[corner_index];
+                    V2i p1 = corners[(corner_index + 1) % corner_count];
+                    add_edge(&shape, vector_convert(V2, p0), vector_convert(V2, p1));
+                }
+            }
+        }
+    }
+    
+    buf_free(corners);
+    free(outgoing);
+    
+    return shape;
+}
+
+//
+// NOTE: Edge coloring, after Chlumsky's "simple" strategy. Corners are split between channels so
+// that every corner is formed by two edges that share no more than one colour, which is what lets
+// the median of the three channels reconstruct it sharply.
+//
+
+function
+Edge_Color switch_edge_color(Edge_Color color, Edge_Color banned) {
+    Edge_Color result;
+    
+    u32 combined = color & banned;
+    if ((combined == EdgeColor_Red) || (combined == EdgeColor_Green) || (combined == EdgeColor_Blue)) {
+        result = (Edge_Color)(combined ^ EdgeColor_White);
+    } else if ((color == EdgeColor_Black) || (color == EdgeColor_White)) {
+        result = EdgeColor_Cyan;
+    } else {
+        u32 shifted = (u32)color << 1;
+        result = (Edge_Color)((shifted | (shifted >> 3)) & EdgeColor_White);
+    }
+    
+    return result;
+}
+
+function
+s32 symmetrical_trichotomy(u32 position, u32 count) {
+    s32 result = 0;
+    if (count > 1) {
+        result = (s32)(3.0f + 2.875f*(f32)position / (f32)(count - 1) - 1.4375f + 0.5f) - 3;
+    }
+    return result;
+}
+
+function
+void color_shape_edges(Shape* shape, f32 angle_threshold) {
+    f32 cross_threshold = sinf(angle_threshold);
+    
+    u32* corners = 0;
+    for (u32 contour_index = 0; contour_index < buf_len(shape->contours); ++contour_index) {
+        Shape_Contour* contour = shape->contours + contour_index;
+        Shape_Edge* edges = shape->edges + contour->first_edge;
+        u32 edge_count = contour->edge_count;
+        if (!edge_count) {
+            continue;
+        }
+        
+        if (corners) {
+            buf__hdr(corners)->len = 0;
+        }
+        
+        V2 prev_dir = noz(edges[edge_count - 1].p1 - edges[edge_count - 1].p0);
+        for (u32 edge_index = 0; edge_index < edge_count; ++edge_index) {
+            V2 dir = noz(edges[edge_index].p1 - edges[edge_index].p0);
+            if ((dot(prev_dir, dir) <= 0.0f) || (abs(cross(prev_dir, dir)) > cross_threshold)) {
+                buf_push(corners, edge_index);
+            }
+            prev_dir = dir;
+        }
+        
+        u32 corner_count = (u32)buf_len(corners);
+        if (corner_count == 0) {
+            // NOTE: Smooth contour, every channel agrees.
+            for (u32 edge_index = 0; edge_index < edge_count; ++edge_index) {
+                edges[edge_index].color = EdgeColor_White;
+            }
+        } else if (corner_count == 1) {
+            // NOTE: Teardrop, split the contour into thirds around its only corner.
+            Edge_Color colors[3];
+            colors[0] = switch_edge_color(EdgeColor_White, EdgeColor_Black);
+            colors[1] = EdgeColor_White;
+            colors[2] = switch_edge_color(colors[0], EdgeColor_Black);
+            
+            u32 corner = corners[0];
+            for (u32 i = 0; i < edge_count; ++i) {
+                edges[(corner + i) % edge_count].color = colors[1 + symmetrical_trichotomy(i, edge_count)];
+            }
+        } else {
+            // NOTE: Cycle colors at every corner. The last run must not match the first, since
+            // they meet at the first corner.
+            u32 start   = corners[0];
+            u32 spline  = 0;
+            Edge_Color color   = switch_edge_color(EdgeColor_White, EdgeColor_Black);
+            Edge_Color initial = color;
+            for (u32 i = 0; i < edge_count; ++i) {
+                u32 edge_index = (start + i) % edge_count;
+                if ((spline + 1 < corner_count) && (corners[spline + 1] == edge_index)) {
+                    spline += 1;
+                    color = switch_edge_color(color, (spline == corner_count - 1) ? initial : EdgeColor_Black);
+                }
+                edges[edge_index].color = color;
+            }
+        }
+    }
+    
+    buf_free(corners);
+}
+
+//
+// NOTE: Distances. Positive outside, negative inside, matching the single channel fields.
+// Candidates are compared by absolute distance first and then by how orthogonal the edge is
+// to the query point, which settles ties at corners in favour of the edge that actually faces it.
+//
+
+typedef struct Edge_Distance {
+    f32 distance;
+    f32 orthogonality;
+} Edge_Distance;
+
+function
+b32 edge_distance_less(Edge_Distance a, Edge_Distance b) {
+    f32 abs_a = abs(a.distance);
+    f32 abs_b = abs(b.distance);
+    b32 result = (abs_a < abs_b) || ((abs_a == abs_b) && (a.orthogonality < b.orthogonality));
+    return result;
+}
+
+function
+Edge_Distance get_edge_distance(Shape_Edge* edge, V2 p, f32* out_t) {
+    Edge_Distance result;
+    
+    V2 aq = p - edge->p0;
+    V2 ab = edge->p1 - edge->p0;
+    f32 t = dot(aq, ab) / dot(ab, ab);
+    *out_t = t;
+    
+    V2 eq = ((t > 0.5f) ? edge->p1 : edge->p0) - p;
+    f32 endpoint_distance = length(eq);
+    
+    f32 ortho_distance = cross(aq, ab) / length(ab);
+    if ((t > 0.0f) && (t < 1.0f) && (abs(ortho_distance) < endpoint_distance)) {
+        result.distance      = ortho_distance;
+        result.orthogonality = 0.0f;
+    } else {
+        f32 sign = (cross(aq, ab) >= 0.0f) ? 1.0f : -1.0f;
+        result.distance      = sign*endpoint_distance;
+        result.orthogonality = abs(dot(noz(ab), noz(eq)));
+    }
+    
+    return result;
+}
+
+// NOTE: Past the ends of an edge, the distance to its extended line instead. That's what keeps
+// the channels straight right up to a corner instead of rounding it off.
+function
+f32 get_edge_pseudo_distance(Shape_Edge* edge, V2 p, Edge_Distance distance, f32 t) {
+    f32 result = distance.distance;
+    
+    V2 dir = noz(edge->p1 - edge->p0);
+    if (t < 0.0f) {
+        V2 aq = p - edge->p0;
+        if (dot(aq, dir) < 0.0f) {
+            f32 pseudo_distance = cross(aq, dir);
+            if (abs(pseudo_distance) <= abs(result)) {
+                result = pseudo_distance;
+            }
+        }
+    } else if (t > 1.0f) {
+        V2 bq = p - edge->p1;
+        if (dot(bq, dir) > 0.0f) {
+            f32 pseudo_distance = cross(bq, dir);
+            if (abs(pseudo_distance) <= abs(result)) {
+                result = pseudo_distance;
+            }
+        }
+    }
+    
+    return result;
+}
+
+// NOTE: Output pixel (x, y) samples the shape at ((x + 0.5, y + 0.5) - translate) / scale, and
+// spread is in output pixels. r, g and b hold the three channels and a holds the true distance,
+// all encoded like the single channel fields: inside bright, edge at 0.5.
+function
+Image_u32 produce_multi_channel_distance_field(Shape* shape, u32 width, u32 height, f32 scale, V2 translate, f32 spread) {
+    Image_u32 result = allocate_image(width, height);
+    
+    u32 edge_count = (u32)buf_len(shape->edges);
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            V2 p = (v2((f32)x + 0.5f, (f32)y + 0.5f) - translate) / scale;
+            
+            Edge_Distance best[3];
+            Shape_Edge* best_edge[3] = {};
+            f32 best_t[3] = {};
+            Edge_Distance best_true = { F32_MAX, 0.0f };
+            for (u32 channel = 0; channel < 3; ++channel) {
+                best[channel] = best_true;
+            }
+            
+            for (u32 edge_index = 0; edge_index < edge_count; ++edge_index) {
+                Shape_Edge* edge = shape->edges + edge_index;
+                
+                f32 t;
+                Edge_Distance distance = get_edge_distance(edge, p, &t);
+                if (edge_distance_less(distance, best_true)) {
+                    best_true = distance;
+                }
+                for (u32 channel = 0; channel < 3; ++channel) {
+                    if ((edge->color & (1 << channel)) && edge_distance_less(distance, best[channel])) {
+                        best[channel]      = distance;
+                        best_edge[channel] = edge;
+                        best_t[channel]    = t;
+                    }
+                }
+            }
+            
+            u8 encoded[3];
+            for (u32 channel = 0; channel < 3; ++channel) {
+                f32 distance = F32_MAX;
+                if (best_edge[channel]) {
+                    distance = get_edge_pseudo_distance(best_edge[channel], p, best[channel], best_t[channel]);
+                }
+                encoded[channel] = (u8)(255.0f*encode_signed_distance_unorm(scale*distance, spread) + 0.5f);
+            }
+            u8 encoded_true = (u8)(255.0f*encode_signed_distance_unorm(scale*best_true.distance, spread) + 0.5f);
+            
+            set_pixel(&result, x, y, rgba(encoded[0], encoded[1], encoded[2], encoded_true));
+        }
+    }
+    
+    return result;
+}
+
+//
+// NOTE: Reconstruction, for comparing fields the way a shader would see them: bilinear
+// upsampling, the median of the channels for multi-channel fields, and a one output pixel
+// wide anti-aliased edge.
+//
+
+function
+f32 median(f32 a, f32 b, f32 c) {
+    f32 result = max(min(a, b), min(max(a, b), c));
+    return result;
+}
+
+function
+V4 sample_bilinear_unorm(Image_u32* image, f32 u, f32 v) {
+    f32 x = u*(f32)image->width  - 0.5f;
+    f32 y = v*(f32)image->height - 0.5f;
+    s32 x0 = (s32)floorf(x);
+    s32 y0 = (s32)floorf(y);
+    f32 tx = x - (f32)x0;
+    f32 ty = y - (f32)y0;
+    
+    V4 texels[4];
+    for (u32 i = 0; i < 4; ++i) {
+        s32 sx = Clamp(x0 + (s32)(i & 1), 0, (s32)image->width  - 1);
+        s32 sy = Clamp(y0 + (s32)(i >> 1), 0, (s32)image->height - 1);
+        Color_ARGB texel = { .argb = get_pixel(image, sx, sy) };
+        texels[i] = v4(texel.r, texel.g, texel.b, texel.a) / 255.0f;
+    }
+    
+    V4 result = lerp(lerp(texels[0], texels[1], tx), lerp(texels[2], texels[3], tx), ty);
+    return result;
+}
+
+function
+Image_u32 render_distance_field_preview(Image_u32* field, b32 multi_channel, f32 spread, u32 width, u32 height) {
+    Image_u32 result = allocate_image(width, height);
+    
+    // NOTE: Field values to output pixels: [0, 1] spans 2*spread field pixels.
+    f32 output_per_field = (f32)width / (f32)field->width;
+    f32 distance_scale   = 2.0f*spread*output_per_field;
+    
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            V4 sample = sample_bilinear_unorm(field, ((f32)x + 0.5f) / (f32)width, ((f32)y + 0.5f) / (f32)height);
+            f32 value = multi_channel ? median(sample.x, sample.y, sample.z) : sample.x;
+            f32 distance = (0.5f - value)*distance_scale;
+            u8 coverage = (u8)(255.0f*clamp(0.5f - distance, 0.0f, 1.0f) + 0.5f);
+            set_pixel(&result, x, y, rgb(coverage, coverage, coverage));
+        }
+    }
+    
+    return result;
+}
@@ -0,0 +1,39 @@
+/* date = October 19th 2026 1:15 pm */
+
+#ifndef MSDF_H
+#define MSDF_H
+
+//
+// NOTE: Shapes for multi-channel distance fields. A shape is a set of closed contours made of
+// straight edges, with the inside on the left of each edge, so outer contours run
+// counter-clockwise and holes clockwise (y up, like our images).
+//
+
+typedef enum Edge_Color {
+    EdgeColor_Black   = 0,
+    EdgeColor_Red     = 1,
+    EdgeColor_Green   = 2,
+    EdgeColor_Yellow  = 3,
+    EdgeColor_Blue    = 4,
+    EdgeColor_Magenta = 5,
+    EdgeColor_Cyan    = 6,
+    EdgeColor_White   = 7,
+} Edge_Color;
+
+typedef struct Shape_Edge {
+    V2 p0;
+    V2 p1;
+    Edge_Color color;
+} Shape_Edge;
+
+typedef struct Shape_Contour {
+    u32 first_edge;
+    u32 edge_count;
+} Shape_Contour;
+
+typedef struct Shape {
+    Shape_Edge* edges;       // NOTE: Stretchy buffer
+    Shape_Contour* contours; // NOTE: Stretchy buffer
+} Shape;
+
+#endif //MSDF_H
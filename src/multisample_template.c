@@ -0,0 +1,144 @@
+//
+// NOTE: Stamps out a multisampled pipeline, a function
+//     void PIPELINE_NAME(Multisample_Target* target, PIPELINE_UNIFORMS* uniforms, u32 triangle_count);
+// It takes the same parameters as pipeline_template.c, and #undef's them the same way at the
+// end. Coverage and depth are per sample, the shaders are per pixel.
+//
+
+#if !defined(PIPELINE_NAME) || !defined(PIPELINE_UNIFORMS) || !defined(PIPELINE_VERTEX_SHADER) || !defined(PIPELINE_FRAGMENT_SHADER) || \
+    !defined(PIPELINE_VARYING_COUNT) || !defined(PIPELINE_DEPTH_TEST) || !defined(PIPELINE_BLEND_MODE)
+#error "A pipeline needs all its parameters defined before including multisample_template.c"
+#endif
+
+function
+void PIPELINE_NAME(Multisample_Target* target, PIPELINE_UNIFORMS* uniforms, u32 triangle_count) {
+    __m128i lane_indices = _mm_setr_epi32(0, 1, 2, 3);
+    
+    for (u32 triangle_index = 0; triangle_index < triangle_count; ++triangle_index) {
+        Raster_Vertex vertices[3];
+        for (u32 corner = 0; corner < 3; ++corner) {
+            PIPELINE_VERTEX_SHADER(uniforms, triangle_index, corner, &vertices[corner]);
+        }
+        
+        Raster_Vertex clipped[4];
+        u32 clipped_count = clip_to_near_plane(&vertices[0], &vertices[1], &vertices[2], PIPELINE_VARYING_COUNT, clipped);
+        for (u32 fan_index = 2; fan_index < clipped_count; ++fan_index) {
+            Triangle_Setup setup;
+            if (!setup_triangle(&setup, &clipped[0], &clipped[fan_index - 1], &clipped[fan_index],
+                                PIPELINE_VARYING_COUNT, target->width, target->height, MSAA_SAMPLE_RADIUS)) {
+                continue;
+            }
+            
+            // NOTE: Depth is a plane, so each sample's depth is the pixel center's plus a
+            // constant per sample.
+            f32 depth_offsets[MSAA_SAMPLE_COUNT];
+            for (u32 sample_index = 0; sample_index < MSAA_SAMPLE_COUNT; ++sample_index) {
+                V2 offset = msaa_sample_offsets[sample_index];
+                depth_offsets[sample_index] = setup.plane_dx[PLANE_DEPTH]*offset.x + setup.plane_dy[PLANE_DEPTH]*offset.y;
+            }
+            __m128 sample_depth_offsets = _mm_loadu_ps(depth_offsets);
+            
+            for (s32 y = setup.bounds.min.y; y < setup.bounds.max.y; ++y) {
+                // NOTE: Each sample gets its own span, and the row covers all of them.
+                s32 sample_begin[MSAA_SAMPLE_COUNT];
+                s32 sample_end[MSAA_SAMPLE_COUNT];
+                s32 row_begin = setup.bounds.max.x;
+                s32 row_end   = setup.bounds.min.x;
+                for (u32 sample_index = 0; sample_index < MSAA_SAMPLE_COUNT; ++sample_index) {
+                    if (get_span(&setup, y, msaa_sample_offsets[sample_index], &sample_begin[sample_index], &sample_end[sample_index])) {
+                        row_begin = Min(row_begin, sample_begin[sample_index]);
+                        row_end   = Max(row_end,   sample_end[sample_index]);
+                    } else {
+                        sample_begin[sample_index] = 0;
+                        sample_end[sample_index]   = 0;
+                    }
+                }
+                if (row_begin >= row_end) {
+                    continue;
+                }
+                
+                Varying_Stepper stepper;
+                begin_varyings(&stepper, &setup, row_begin, y);
+                
+                for (s32 x = row_begin; x < row_end; x += 4) {
+                    Fragment_Batch batch;
+                    batch.x              = x;
+                    batch.y              = y;
+                    batch.count          = Min(row_end - x, 4);
+                    batch.triangle_index = triangle_index;
+                    batch.setup          = &setup;
+                    batch.stepper        = &stepper;
+                    get_varyings(&stepper, &setup, batch.count, &batch.depth, batch.varyings);
+                    
+                    // NOTE: One lane per pixel for each sample, then transposed to one lane per
+                    // sample for each pixel, to line up with the samples in memory. Pixels past
+                    // the row are past every sample's span, so they come out uncovered.
+                    __m128i pixel_x = _mm_add_epi32(_mm_set1_epi32(x), lane_indices);
+                    __m128 coverage[4];
+                    for (u32 sample_index = 0; sample_index < MSAA_SAMPLE_COUNT; ++sample_index) {
+                        __m128i after_begin = _mm_cmpgt_epi32(pixel_x, _mm_set1_epi32(sample_begin[sample_index] - 1));
+                        __m128i before_end  = _mm_cmplt_epi32(pixel_x, _mm_set1_epi32(sample_end[sample_index]));
+                        coverage[sample_index] = _mm_castsi128_ps(_mm_and_si128(after_begin, before_end));
+                    }
+                    _MM_TRANSPOSE4_PS(coverage[0], coverage[1], coverage[2], coverage[3]);
+                    
+                    f32 center_depths[4];
+                    _mm_storeu_ps(center_depths, batch.depth);
+                    
+                    __m128 sample_depths[4];
+                    __m128 write_masks[4];
+                    b32 any_written = false;
+                    for (u32 lane = 0; lane < batch.count; ++lane) {
+                        sample_depths[lane] = _mm_add_ps(_mm_set1_ps(center_depths[lane]), sample_depth_offsets);
+                        write_masks[lane] = coverage[lane];
+                        if (PIPELINE_DEPTH_TEST != DepthTest_None) {
+                            __m128 old_depths = _mm_loadu_ps(get_sample_depths(target, x + lane, y));
+                            __m128 passed = (PIPELINE_DEPTH_TEST == DepthTest_LessEqual) ? _mm_cmple_ps(sample_depths[lane], old_depths) : _mm_cmplt_ps(sample_depths[lane], old_depths);
+                            write_masks[lane] = _mm_and_ps(write_masks[lane], passed);
+                        }
+                        any_written |= (_mm_movemask_ps(write_masks[lane]) != 0);
+                    }
+                    
+                    if (any_written) {
+                        u32 colors[4];
+                        _mm_storeu_si128((__m128i*)colors, PIPELINE_FRAGMENT_SHADER(uniforms, &batch));
+                        
+                        for (u32 lane = 0; lane < batch.count; ++lane) {
+                            if (!_mm_movemask_ps(write_masks[lane])) {
+                                continue;
+                            }
+                            
+                            __m128i write_mask = _mm_castps_si128(write_masks[lane]);
+                            u32* sample_colors = get_sample_colors(target, x + lane, y);
+                            __m128i old_color = _mm_loadu_si128((__m128i*)sample_colors);
+                            __m128i new_color = _mm_set1_epi32((s32)colors[lane]);
+                            if (PIPELINE_BLEND_MODE != BlendMode_Replace) {
+                                new_color = blend_pixels(new_color, old_color, PIPELINE_BLEND_MODE);
+                            }
+                            new_color = _mm_or_si128(_mm_and_si128(write_mask, new_color), _mm_andnot_si128(write_mask, old_color));
+                            _mm_storeu_si128((__m128i*)sample_colors, new_color);
+                            
+                            if (PIPELINE_DEPTH_TEST != DepthTest_None) {
+                                f32* depths = get_sample_depths(target, x + lane, y);
+                                __m128 old_depths = _mm_loadu_ps(depths);
+                                __m128 new_depths = _mm_or_ps(_mm_and_ps(write_masks[lane], sample_depths[lane]),
+                                                              _mm_andnot_ps(write_masks[lane], old_depths));
+                                _mm_storeu_ps(depths, new_depths);
+                            }
+                        }
+                    }
+                    
+                    step_varyings(&stepper, &setup, 4);
+                }
+            }
+        }
+    }
+}
+
+#undef PIPELINE_NAME
+#undef PIPELINE_UNIFORMS
+#undef PIPELINE_VERTEX_SHADER
+#undef PIPELINE_FRAGMENT_SHADER
+#undef PIPELINE_VARYING_COUNT
+#undef PIPELINE_DEPTH_TEST
+#undef PIPELINE_BLEND_MODE
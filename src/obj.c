@@ -20,6 +20,29 @@ internal b32 obj_parse_vertex(String_u8* line, V3* out_vertex) {
     return result;
 }
 
+// NOTE: vt can have a third coordinate, which is ignored.
+internal b32 obj_parse_texcoord(String_u8* line, V2* out_texcoord) {
+    b32 result = true;
+    
+    V2 texcoord;
+    for (u32 e = 0; e < 2; ++e) {
+        String_u8 element = string_split_word(line);
+        f64 scalar;
+        if (string_parse_f64(&element, &scalar)) {
+            texcoord[e] = (f32)scalar;
+        } else {
+            result = false;
+            break;
+        }
+    }
+    
+    if (result) {
+        *out_texcoord = texcoord;
+    }
+    
+    return result;
+}
+
 internal s32 obj_get_abs_index(u32 vertex_count, s32 index) {
     s32 abs_index = 0;
     if (index > 0) {
@@ -30,11 +53,33 @@ internal s32 obj_get_abs_index(u32 vertex_count, s32 index) {
     return abs_index;
 }
 
+// NOTE: Centered on the vertices' bounding box, which is within about 15% of the smallest
+// sphere for most meshes and a lot cheaper to find.
+internal void compute_mesh_bounds(Mesh* mesh) {
+    V3 box_min = mesh->vertices[0];
+    V3 box_max = mesh->vertices[0];
+    for (u32 i = 1; i < mesh->vertex_count; ++i) {
+        box_min = min(box_min, mesh->vertices[i]);
+        box_max = max(box_max, mesh->vertices[i]);
+    }
+    
+    V3 center = 0.5f*(box_min + box_max);
+    f32 radius_sq = 0.0f;
+    for (u32 i = 0; i < mesh->vertex_count; ++i) {
+        radius_sq = Max(radius_sq, length_sq(mesh->vertices[i] - center));
+    }
+    
+    mesh->bounds_center = center;
+    mesh->bounds_radius = sqrtf(radius_sq);
+}
+
 internal b32 parse_obj(String_u8 obj, Mesh* out_mesh) {
     b32 result = false;
     
     V3* vertices = 0;
     Triangle* triangles = 0;
+    V2* texcoords = 0;
+    Triangle* texcoord_triangles = 0;
     
     while (obj.len) {
         String_u8 line = string_split_line(&obj);
@@ -47,14 +92,27 @@ internal b32 parse_obj(String_u8 obj, Mesh* out_mesh) {
                 fprintf(stderr, "[Obj Parser]: Failed to parse vertex element.\n");
             }
             buf_push(vertices, vertex);
+        } else if (string_compare(command, Str("vt"))) {
+            V2 texcoord = {};
+            if (!obj_parse_texcoord(&line, &texcoord)) {
+                fprintf(stderr, "[Obj Parser]: Failed to parse texcoord element.\n");
+            }
+            buf_push(texcoords, texcoord);
         } else if (string_compare(command, Str("f"))) {
             u32 vert_index_count = 0;
             u32 vert_indices[32] = {};
+            u32 texcoord_indices[32] = {};
             
             while (line.len && (vert_index_count < ArrayCount(vert_indices))) {
+                // NOTE: An element is v, v/vt, v//vn or v/vt/vn. The normal is skipped.
                 String_u8 element = string_split_word(&line);
                 s32 index = 0;
                 if (string_parse_s32(&element, &index, 10)) {
+                    s32 texcoord_index = 0;
+                    if (string_eat_char(&element, '/') && string_parse_s32(&element, &texcoord_index, 10)) {
+                        texcoord_index = obj_get_abs_index((u32)buf_len(texcoords), texcoord_index);
+                    }
+                    texcoord_indices[vert_index_count] = texcoord_index;
                     vert_indices[vert_index_count++] = obj_get_abs_index((u32)buf_len(vertices), index);
                 } else {
                     fprintf(stderr, "[Obj Parser]: Failed to read face index.\n");
@@ -68,6 +126,12 @@ internal b32 parse_obj(String_u8 obj, Mesh* out_mesh) {
                     t.b = vert_indices[i];
                     t.c = vert_indices[i + 1];
                     buf_push(triangles, t);
+                    
+                    Triangle tt;
+                    tt.a = texcoord_indices[0];
+                    tt.b = texcoord_indices[i];
+                    tt.c = texcoord_indices[i + 1];
+                    buf_push(texcoord_triangles, tt);
                 }
             } else {
                 fprintf(stderr, "[Obj Parser]: A face needs at least 3 indices.\n");
@@ -81,6 +145,19 @@ internal b32 parse_obj(String_u8 obj, Mesh* out_mesh) {
         out_mesh->vertices       = vertices;
         out_mesh->triangle_count = (u32)buf_len(triangles);
         out_mesh->triangles      = triangles;
+        
+        out_mesh->texcoord_count     = 0;
+        out_mesh->texcoords          = 0;
+        out_mesh->texcoord_triangles = 0;
+        if (texcoords) {
+            out_mesh->texcoord_count     = (u32)buf_len(texcoords);
+            out_mesh->texcoords          = texcoords;
+            out_mesh->texcoord_triangles = texcoord_triangles;
+        } else {
+            buf_free(texcoord_triangles);
+        }
+        
+        compute_mesh_bounds(out_mesh);
     }
     
     return result;
@@ -16,6 +16,16 @@ typedef struct Mesh {
     
     u32 triangle_count;
     Triangle* triangles;
+    
+    // NOTE: Only set if the obj has vt lines. texcoord_triangles has one entry per triangle,
+    // indexing texcoords.
+    u32 texcoord_count;
+    V2* texcoords;
+    Triangle* texcoord_triangles;
+    
+    // NOTE: A sphere around every vertex, from compute_mesh_bounds, which parse_obj calls.
+    V3 bounds_center;
+    f32 bounds_radius;
 } Mesh;
 
 #endif //OBJ_H
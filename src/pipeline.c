@@ -0,0 +1,225 @@
+//
+// NOTE: Visibility buffers
+//
+
+function
+Visibility_Buffer allocate_visibility_buffer(u32 width, u32 height) {
+    Visibility_Buffer result = {};
+    result.ids   = allocate_image(width, height);
+    result.depth = allocate_image_f32(width, height);
+    return result;
+}
+
+function
+void free_visibility_buffer(Visibility_Buffer* buffer) {
+    free_image(&buffer->ids);
+    free_image(&buffer->depth);
+}
+
+// NOTE: Has to be done before each frame's first pass.
+function
+void clear_visibility_buffer(Visibility_Buffer* buffer) {
+    Color_ARGB nothing = {};
+    clear_image(&buffer->ids, nothing);
+    clear_image(&buffer->depth, 1.0f);
+}
+
+//
+// NOTE: Multisampling
+//
+
+// NOTE: The usual rotated grid, no two samples share a row or a column, so near horizontal and
+// near vertical edges both get all four levels.
+global V2 msaa_sample_offsets[MSAA_SAMPLE_COUNT] = {
+    { -0.125f, -0.375f },
+    {  0.375f, -0.125f },
+    { -0.375f,  0.125f },
+    {  0.125f,  0.375f },
+};
+
+function
+Multisample_Target allocate_multisample_target(u32 width, u32 height) {
+    Multisample_Target result = {};
+    result.width  = width;
+    result.height = height;
+    result.pitch  = width;
+    
+    umm sample_count = (umm)width*height*MSAA_SAMPLE_COUNT;
+    result.colors = (u32*)allocate_aligned(sizeof(u32)*sample_count, IMAGE_ALIGNMENT);
+    result.depths = (f32*)allocate_aligned(sizeof(f32)*sample_count, IMAGE_ALIGNMENT);
+    memset(result.colors, 0, sizeof(u32)*sample_count);
+    memset(result.depths, 0, sizeof(f32)*sample_count);
+    
+    return result;
+}
+
+function
+void free_multisample_target(Multisample_Target* target) {
+    free_aligned(target->colors);
+    free_aligned(target->depths);
+    memset(target, 0, sizeof(*target));
+}
+
+function
+u32* get_sample_colors(Multisample_Target* target, u32 x, u32 y) {
+    u32* result = target->colors + ((umm)y*target->pitch + x)*MSAA_SAMPLE_COUNT;
+    return result;
+}
+
+function
+f32* get_sample_depths(Multisample_Target* target, u32 x, u32 y) {
+    f32* result = target->depths + ((umm)y*target->pitch + x)*MSAA_SAMPLE_COUNT;
+    return result;
+}
+
+function
+void clear_multisample_target(Multisample_Target* target, Color_ARGB color, f32 depth) {
+    u32 depth_bits;
+    memcpy(&depth_bits, &depth, sizeof(depth_bits));
+    for (u32 y = 0; y < target->height; ++y) {
+        fill_u32(get_sample_colors(target, 0, y), (umm)target->width*MSAA_SAMPLE_COUNT, color.argb, false);
+        fill_u32((u32*)get_sample_depths(target, 0, y), (umm)target->width*MSAA_SAMPLE_COUNT, depth_bits, false);
+    }
+}
+
+// NOTE: The rounded average of each pixel's four samples, for four pixels. Colors are
+// premultiplied, so a plain average is right for alpha too.
+internal __m128i resolve_samples(u32* samples) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i sums[4];
+    for (u32 i = 0; i < 4; ++i) {
+        __m128i pixel = _mm_loadu_si128((__m128i*)(samples + i*MSAA_SAMPLE_COUNT));
+        sums[i] = _mm_add_epi16(_mm_unpacklo_epi8(pixel, zero), _mm_unpackhi_epi8(pixel, zero));
+    }
+    
+    __m128i round = _mm_set1_epi16(2);
+    __m128i low  = _mm_add_epi16(_mm_unpacklo_epi64(sums[0], sums[1]), _mm_unpackhi_epi64(sums[0], sums[1]));
+    __m128i high = _mm_add_epi16(_mm_unpacklo_epi64(sums[2], sums[3]), _mm_unpackhi_epi64(sums[2], sums[3]));
+    low  = _mm_srli_epi16(_mm_add_epi16(low,  round), 2);
+    high = _mm_srli_epi16(_mm_add_epi16(high, round), 2);
+    
+    __m128i result = _mm_packus_epi16(low, high);
+    return result;
+}
+
+// NOTE: Resolves the rectangle at (x, y) of target into the same place in dst.
+internal void resolve_multisample_rect(Multisample_Target* target, Image_u32* dst, u32 x, u32 y, u32 width, u32 height) {
+    for (u32 row = y; row < y + height; ++row) {
+        u32* samples = get_sample_colors(target, x, row);
+        u32* dst_row = get_pixel_pointer(dst, x, row);
+        
+        u32 i = 0;
+        for (; i + 4 <= width; i += 4) {
+            _mm_storeu_si128((__m128i*)(dst_row + i), resolve_samples(samples + i*MSAA_SAMPLE_COUNT));
+        }
+        
+        if (i < width) {
+            u32 tail[4*MSAA_SAMPLE_COUNT] = {};
+            u32 packed[4];
+            u32 count = width - i;
+            memcpy(tail, samples + i*MSAA_SAMPLE_COUNT, sizeof(u32)*MSAA_SAMPLE_COUNT*count);
+            _mm_storeu_si128((__m128i*)packed, resolve_samples(tail));
+            memcpy(dst_row + i, packed, sizeof(u32)*count);
+        }
+    }
+}
+
+function
+void resolve_multisample_target(Multisample_Target* target, Image_u32* dst) {
+    Assert((target->width  == dst->width) &&
+           (target->height == dst->height));
+    resolve_multisample_rect(target, dst, 0, 0, target->width, target->height);
+}
+
+typedef struct Multisample_Resolve_Job_Data {
+    Multisample_Target* target;
+    Image_u32* dst;
+    u32 tiles_x;
+} Multisample_Resolve_Job_Data;
+
+internal void multisample_resolve_job(void* user_data, u32 job_index, u32 worker_index) {
+    Multisample_Resolve_Job_Data* data = (Multisample_Resolve_Job_Data*)user_data;
+    
+    u32 x = (job_index % data->tiles_x)*MSAA_RESOLVE_TILE_SIZE;
+    u32 y = (job_index / data->tiles_x)*MSAA_RESOLVE_TILE_SIZE;
+    u32 width  = Min(MSAA_RESOLVE_TILE_SIZE, data->dst->width  - x);
+    u32 height = Min(MSAA_RESOLVE_TILE_SIZE, data->dst->height - y);
+    resolve_multisample_rect(data->target, data->dst, x, y, width, height);
+}
+
+// NOTE: The same, with one job per tile.
+function
+void resolve_multisample_target(Job_Pool* pool, Multisample_Target* target, Image_u32* dst) {
+    Assert((target->width  == dst->width) &&
+           (target->height == dst->height));
+    
+    Multisample_Resolve_Job_Data data = {};
+    data.target  = target;
+    data.dst     = dst;
+    data.tiles_x = (dst->width  + MSAA_RESOLVE_TILE_SIZE - 1) / MSAA_RESOLVE_TILE_SIZE;
+    u32 tiles_y  = (dst->height + MSAA_RESOLVE_TILE_SIZE - 1) / MSAA_RESOLVE_TILE_SIZE;
+    
+    parallel_for(pool, data.tiles_x*tiles_y, multisample_resolve_job, &data);
+}
+
+//
+// NOTE: Culling
+//
+
+// NOTE: The planes of clip space, -w <= x <= w, -w <= y <= w and 0 <= z <= w, pulled back
+// through the matrix, then normalized so distances to them are in world units.
+function
+Frustum make_frustum(M4x4 view_projection) {
+    V4 rows[4];
+    for (u32 i = 0; i < 4; ++i) {
+        rows[i] = v4(view_projection.e[i][0], view_projection.e[i][1], view_projection.e[i][2], view_projection.e[i][3]);
+    }
+    
+    Frustum result;
+    result.planes[0] = rows[3] + rows[0];
+    result.planes[1] = rows[3] - rows[0];
+    result.planes[2] = rows[3] + rows[1];
+    result.planes[3] = rows[3] - rows[1];
+    result.planes[4] = rows[2];
+    result.planes[5] = rows[3] - rows[2];
+    for (u32 i = 0; i < ArrayCount(result.planes); ++i) {
+        result.planes[i] = result.planes[i]*(1.0f / length(result.planes[i].xyz));
+    }
+    return result;
+}
+
+// NOTE: Conservative, a sphere just outside two planes near a corner can still pass.
+function
+b32 sphere_in_frustum(Frustum* frustum, V3 center, f32 radius) {
+    for (u32 i = 0; i < ArrayCount(frustum->planes); ++i) {
+        V4 plane = frustum->planes[i];
+        if (dot(plane.xyz, center) + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// NOTE: The rows of a height pixel tall target a sphere can cover, from the corners of the
+// box around it. Anything reaching behind the eye could cover any row.
+function
+void get_sphere_rows(M4x4 view_projection, V3 center, f32 radius, u32 height, s32* min_y, s32* max_y) {
+    f32 low  =  F32_MAX;
+    f32 high =  F32_MIN;
+    for (u32 corner = 0; corner < 8; ++corner) {
+        V3 p = center + v3((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius);
+        V4 clip = m4x4_transform_v4(view_projection, v4(p.x, p.y, p.z, 1.0f));
+        if (clip.w <= 0.0f) {
+            low  = 0.0f;
+            high = (f32)height;
+            break;
+        }
+        f32 y = (0.5f*clip.y / clip.w + 0.5f)*(f32)height;
+        low  = Min(low,  y);
+        high = Max(high, y);
+    }
+    
+    // NOTE: A pixel is covered by its center, a pixel's worth of slack covers the rounding.
+    *min_y = (s32)Clamp(low  - 1.0f, 0.0f, (f32)height);
+    *max_y = (s32)Clamp(high + 1.0f, 0.0f, (f32)height);
+}
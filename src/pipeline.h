@@ -0,0 +1,116 @@
+/* date = October 19th 2026 9:10 pm */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+//
+// NOTE: Shaders and pipelines. A pipeline is the rasterizer loop stamped out for one pair of
+// shaders and one set of state, by including pipeline_template.c with them #defined (see the
+// top of that file). The shaders are called directly so they get inlined, and the state is a
+// constant, so the depth test and blend mode fold away instead of being checked per pixel.
+//
+// A vertex shader fills in the Raster_Vertex for one corner of a triangle:
+//     void shader(Uniforms* uniforms, u32 triangle_index, u32 corner, Raster_Vertex* out);
+//
+// A fragment shader shades a Fragment_Batch and returns four premultiplied Color_ARGBs:
+//     __m128i shader(Uniforms* uniforms, Fragment_Batch* batch);
+//
+
+// NOTE: For PIPELINE_DEPTH_TEST. Passing fragments write their depth either way. LessEqual is
+// for a pass after a depth only pass of the same triangles, which leaves exactly their depths
+// in the buffer, so only the fragments that end up visible get shaded.
+typedef enum DepthTest {
+    DepthTest_None,
+    DepthTest_Less,
+    DepthTest_LessEqual,
+} DepthTest;
+
+typedef struct Render_Target {
+    Image_u32* color;
+    Image_f32* depth;  // NOTE: Only for pipelines that test depth. 0 is near, 1 is far.
+    Rect2i* scissor;   // NOTE: Only pixels inside get drawn, 0 for the whole target.
+} Render_Target;
+
+// NOTE: Up to four pixels in a row, one per lane. Lanes from count on repeat the last pixel,
+// and whatever the shader returns for them is thrown away.
+typedef struct Fragment_Batch {
+    s32 x;
+    s32 y;
+    u32 count;
+    u32 triangle_index;
+    
+    __m128 depth;
+    __m128 varyings[MAX_VARYINGS];
+    
+    // NOTE: At the first pixel, for get_varying_gradient.
+    Triangle_Setup* setup;
+    Varying_Stepper* stepper;
+} Fragment_Batch;
+
+//
+// NOTE: Visibility buffers, for shading each pixel once however much overdraw there is. The
+// first pass rasterizes only depth and which triangle is in front, the second goes over the
+// pixels and shades them, rebuilding the varyings from the triangle. Stamped out by including
+// visibility_template.c, see the top of that file.
+//
+
+// NOTE: Shading jobs work on squares this size.
+#define VISIBILITY_TILE_SIZE 64
+
+// NOTE: ids holds triangle_index + 1 for each pixel, 0 where nothing was drawn.
+typedef struct Visibility_Buffer {
+    Image_u32 ids;
+    Image_f32 depth;
+} Visibility_Buffer;
+
+//
+// NOTE: Multisampling. Each pixel has MSAA_SAMPLE_COUNT color and depth samples, next to
+// each other so a pixel's samples are one SSE register. Coverage and depth are tested per
+// sample, but the fragment shader still runs once per pixel, at its center, and its color is
+// written to every sample that passes. Edges get MSAA_SAMPLE_COUNT + 1 levels of coverage for
+// about the shading cost of no anti-aliasing. Stamped out by including multisample_template.c,
+// which takes the same parameters as pipeline_template.c.
+//
+
+#define MSAA_SAMPLE_COUNT 4
+
+// NOTE: How far the samples are from the pixel center, at most, for setup_triangle.
+#define MSAA_SAMPLE_RADIUS 0.375f
+
+// NOTE: Resolve jobs work on squares this size.
+#define MSAA_RESOLVE_TILE_SIZE 64
+
+typedef struct Multisample_Target {
+    u32 width;
+    u32 height;
+    u32 pitch; // NOTE: In pixels, not samples
+    
+    u32* colors;
+    f32* depths; // NOTE: 0 is near, 1 is far.
+} Multisample_Target;
+
+//
+// NOTE: Culling and instancing. Instanced draws cull each instance's bounding sphere against
+// the frustum, then set up the triangles of the visible ones, one job per instance, in batches
+// that fit INSTANCE_SETUP_BATCH triangles. Each batch is then drawn in bands of rows, one job
+// each, that rasterize the triangles overlapping them in order through the scissor. Each pixel
+// sees the same triangles in the same order as drawing the instances one after the other, so
+// the result is the same.
+//
+
+// NOTE: Instanced draws cull this many instances per job, set up at most this many triangles
+// before drawing them, and draw bands of rows this tall.
+#define INSTANCE_CULL_BATCH  64
+#define INSTANCE_SETUP_BATCH (1 << 16)
+#define INSTANCE_BAND_HEIGHT 32
+
+// NOTE: xyz is the normal, pointing in, and w the offset. Points p inside have
+// dot(plane.xyz, p) + plane.w >= 0 for all six.
+typedef struct Frustum {
+    V4 planes[6];
+} Frustum;
+
+#define Glue_(a, b) a##b
+#define Glue(a, b) Glue_(a, b)
+
+#endif //PIPELINE_H
@@ -0,0 +1,152 @@
+//
+// NOTE: Stamps out a pipeline, a function
+//     void PIPELINE_NAME(Render_Target* target, PIPELINE_UNIFORMS* uniforms, u32 triangle_count);
+// and the two halves of it, for callers that set triangles up once and rasterize them later:
+//     u32  PIPELINE_NAME_setup(PIPELINE_UNIFORMS* uniforms, u32 triangle_index, u32 width, u32 height, Triangle_Setup* setups);
+//     void PIPELINE_NAME_rasterize(Render_Target* target, PIPELINE_UNIFORMS* uniforms, u32 triangle_index, Triangle_Setup* setup);
+// Define these and include this file:
+//     PIPELINE_NAME
+//     PIPELINE_UNIFORMS         The type the shaders get a pointer to
+//     PIPELINE_VERTEX_SHADER
+//     PIPELINE_FRAGMENT_SHADER
+//     PIPELINE_VARYING_COUNT
+//     PIPELINE_DEPTH_TEST       A DepthTest, DepthTest_None leaves target->depth alone
+//     PIPELINE_BLEND_MODE       A BlendMode
+// They're all #undef'd at the end, ready for the next pipeline.
+//
+
+#if !defined(PIPELINE_NAME) || !defined(PIPELINE_UNIFORMS) || !defined(PIPELINE_VERTEX_SHADER) || !defined(PIPELINE_FRAGMENT_SHADER) || \
+    !defined(PIPELINE_VARYING_COUNT) || !defined(PIPELINE_DEPTH_TEST) || !defined(PIPELINE_BLEND_MODE)
+#error "A pipeline needs all its parameters defined before including pipeline_template.c"
+#endif
+
+// NOTE: Runs the vertex shader on each corner and clips against the near plane. What's left
+// is a fan of at most two triangles, and the ones that set up go into setups. Returns how many.
+internal u32 Glue(PIPELINE_NAME, _setup)(PIPELINE_UNIFORMS* uniforms, u32 triangle_index, u32 width, u32 height, Triangle_Setup* setups) {
+    Raster_Vertex vertices[3];
+    for (u32 corner = 0; corner < 3; ++corner) {
+        PIPELINE_VERTEX_SHADER(uniforms, triangle_index, corner, &vertices[corner]);
+    }
+    
+    u32 result = 0;
+    Raster_Vertex clipped[4];
+    u32 clipped_count = clip_to_near_plane(&vertices[0], &vertices[1], &vertices[2], PIPELINE_VARYING_COUNT, clipped);
+    for (u32 fan_index = 2; fan_index < clipped_count; ++fan_index) {
+        if (setup_triangle(setups + result, &clipped[0], &clipped[fan_index - 1], &clipped[fan_index],
+                           PIPELINE_VARYING_COUNT, width, height)) {
+            ++result;
+        }
+    }
+    return result;
+}
+
+// NOTE: Draws the pixels of a triangle from PIPELINE_NAME_setup that are inside the scissor.
+internal void Glue(PIPELINE_NAME, _rasterize)(Render_Target* target, PIPELINE_UNIFORMS* uniforms, u32 triangle_index, Triangle_Setup* setup) {
+    Image_u32* color = target->color;
+    Image_f32* depth = target->depth;
+    __m128i lane_indices = _mm_setr_epi32(0, 1, 2, 3);
+    
+    Rect2i bounds = setup->bounds;
+    if (target->scissor) {
+        bounds = rect2i_intersect(bounds, *target->scissor);
+        if ((bounds.min.x >= bounds.max.x) ||
+            (bounds.min.y >= bounds.max.y)) {
+            return;
+        }
+    }
+    
+    for (s32 y = bounds.min.y; y < bounds.max.y; ++y) {
+        s32 span_begin, span_end;
+        if (!get_span(setup, y, &span_begin, &span_end)) {
+            continue;
+        }
+        
+        Varying_Stepper stepper;
+        begin_varyings(&stepper, setup, span_begin, y);
+        
+        for (s32 x = span_begin; x < span_end; x += 4) {
+            Fragment_Batch batch;
+            batch.x              = x;
+            batch.y              = y;
+            batch.count          = Min(span_end - x, 4);
+            batch.triangle_index = triangle_index;
+            batch.setup          = setup;
+            batch.stepper        = &stepper;
+            get_varyings(&stepper, setup, batch.count, &batch.depth, batch.varyings);
+            
+            // NOTE: A short batch at the end of a span works on a copy, so the loads and
+            // stores below never touch pixels past the span. The lanes past it are zeroed
+            // rather than left indeterminate, even though they're masked out.
+            u32 color_copy[4] = {};
+            f32 depth_copy[4] = {};
+            u32* color_pixels = get_pixel_pointer(color, x, y);
+            f32* depth_pixels = (PIPELINE_DEPTH_TEST != DepthTest_None) ? get_pixel_pointer(depth, x, y) : 0;
+            if (batch.count < 4) {
+                memcpy(color_copy, color_pixels, sizeof(u32)*batch.count);
+                color_pixels = color_copy;
+                if (PIPELINE_DEPTH_TEST != DepthTest_None) {
+                    memcpy(depth_copy, depth_pixels, sizeof(f32)*batch.count);
+                    depth_pixels = depth_copy;
+                }
+            }
+            
+            __m128i write_mask = _mm_cmplt_epi32(lane_indices, _mm_set1_epi32(batch.count));
+            __m128 old_depth = _mm_setzero_ps();
+            if (PIPELINE_DEPTH_TEST != DepthTest_None) {
+                old_depth = _mm_loadu_ps(depth_pixels);
+                __m128 passed = (PIPELINE_DEPTH_TEST == DepthTest_LessEqual) ? _mm_cmple_ps(batch.depth, old_depth) : _mm_cmplt_ps(batch.depth, old_depth);
+                write_mask = _mm_and_si128(write_mask, _mm_castps_si128(passed));
+            }
+            
+            if (_mm_movemask_epi8(write_mask)) {
+                __m128i old_color = _mm_loadu_si128((__m128i*)color_pixels);
+                __m128i new_color = PIPELINE_FRAGMENT_SHADER(uniforms, &batch);
+                if (PIPELINE_BLEND_MODE != BlendMode_Replace) {
+                    new_color = blend_pixels(new_color, old_color, PIPELINE_BLEND_MODE);
+                }
+                
+                new_color = _mm_or_si128(_mm_and_si128(write_mask, new_color), _mm_andnot_si128(write_mask, old_color));
+                _mm_storeu_si128((__m128i*)color_pixels, new_color);
+                
+                if (PIPELINE_DEPTH_TEST != DepthTest_None) {
+                    __m128 depth_mask = _mm_castsi128_ps(write_mask);
+                    __m128 new_depth = _mm_or_ps(_mm_and_ps(depth_mask, batch.depth), _mm_andnot_ps(depth_mask, old_depth));
+                    _mm_storeu_ps(depth_pixels, new_depth);
+                }
+                
+                if (batch.count < 4) {
+                    memcpy(get_pixel_pointer(color, x, y), color_copy, sizeof(u32)*batch.count);
+                    if (PIPELINE_DEPTH_TEST != DepthTest_None) {
+                        memcpy(get_pixel_pointer(depth, x, y), depth_copy, sizeof(f32)*batch.count);
+                    }
+                }
+            }
+            
+            step_varyings(&stepper, setup, 4);
+        }
+    }
+}
+
+function
+void PIPELINE_NAME(Render_Target* target, PIPELINE_UNIFORMS* uniforms, u32 triangle_count) {
+    Image_u32* color = target->color;
+    if (PIPELINE_DEPTH_TEST != DepthTest_None) {
+        Assert(target->depth && (target->depth->width == color->width) && (target->depth->height == color->height));
+    }
+    
+    for (u32 triangle_index = 0; triangle_index < triangle_count; ++triangle_index) {
+        Triangle_Setup setups[2];
+        u32 setup_count = Glue(PIPELINE_NAME, _setup)(uniforms, triangle_index, color->width, color->height, setups);
+        for (u32 setup_index = 0; setup_index < setup_count; ++setup_index) {
+            Glue(PIPELINE_NAME, _rasterize)(target, uniforms, triangle_index, setups + setup_index);
+        }
+    }
+}
+
+#undef PIPELINE_NAME
+#undef PIPELINE_UNIFORMS
+#undef PIPELINE_VERTEX_SHADER
+#undef PIPELINE_FRAGMENT_SHADER
+#undef PIPELINE_VARYING_COUNT
+#undef PIPELINE_DEPTH_TEST
+#undef PIPELINE_BLEND_MODE
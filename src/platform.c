@@ -0,0 +1,399 @@
+function
+u32 get_processor_count(void) {
+    u32 result = 1;
+#if _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    result = (u32)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count > 0) {
+        result = (u32)count;
+    }
+#endif
+    return result;
+}
+
+function
+f64 get_time_seconds(void) {
+    f64 result;
+#if _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    result = (f64)counter.QuadPart / (f64)frequency.QuadPart;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    result = (f64)time.tv_sec + 1e-9*(f64)time.tv_nsec;
+#endif
+    return result;
+}
+
+//
+// NOTE: Memory
+//
+
+function
+void* allocate_aligned(umm size, umm alignment) {
+    void* result = 0;
+#if _WIN32
+    result = _aligned_malloc(size, alignment);
+#else
+    if (posix_memalign(&result, alignment, size) != 0) {
+        result = 0;
+    }
+#endif
+    return result;
+}
+
+function
+void free_aligned(void* ptr) {
+#if _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+// NOTE: Whole pages straight from the OS, for big buffers that live a long time. size is
+// rounded up to the page size actually used and has to be passed back to free_pages.
+// Huge pages are a request, not a promise: without them (no privilege on Windows, no
+// reserved hugetlb pages on Linux) this falls back to normal pages, and on Linux asks for
+// transparent huge pages instead.
+function
+void* allocate_pages(umm* size, b32 huge_pages) {
+    void* result = 0;
+#if _WIN32
+    if (huge_pages) {
+        umm large_page_size = GetLargePageMinimum();
+        if (large_page_size) {
+            umm rounded_size = (*size + large_page_size - 1) & ~(large_page_size - 1);
+            result = VirtualAlloc(0, rounded_size, MEM_COMMIT|MEM_RESERVE|MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (result) {
+                *size = rounded_size;
+            }
+        }
+    }
+    if (!result) {
+        result = VirtualAlloc(0, *size, MEM_COMMIT|MEM_RESERVE, PAGE_READWRITE);
+    }
+#else
+#if __linux__
+    if (huge_pages) {
+        umm huge_page_size = 2*1024*1024;
+        umm rounded_size = (*size + huge_page_size - 1) & ~(huge_page_size - 1);
+        result = mmap(0, rounded_size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+        if (result == MAP_FAILED) {
+            result = 0;
+        } else {
+            *size = rounded_size;
+        }
+    }
+#endif
+    if (!result) {
+        result = mmap(0, *size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if (result == MAP_FAILED) {
+            result = 0;
+        }
+#if __linux__
+        if (result && huge_pages) {
+            madvise(result, *size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+#endif
+    return result;
+}
+
+function
+void free_pages(void* ptr, umm size) {
+    if (ptr) {
+#if _WIN32
+        VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+        munmap(ptr, size);
+#endif
+    }
+}
+
+//
+// NOTE: Files
+//
+
+function
+b32 map_file(char* file_name, File_Mapping* out_mapping) {
+    b32 result = false;
+    memset(out_mapping, 0, sizeof(*out_mapping));
+#if _WIN32
+    HANDLE file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && (size.QuadPart > 0)) {
+            HANDLE mapping = CreateFileMappingA(file, 0, PAGE_WRITECOPY, 0, 0, 0);
+            if (mapping) {
+                void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+                if (data) {
+                    out_mapping->data = (u8*)data;
+                    out_mapping->size = (umm)size.QuadPart;
+                    result = true;
+                }
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+    }
+#else
+    int file = open(file_name, O_RDONLY);
+    if (file >= 0) {
+        struct stat info;
+        if ((fstat(file, &info) == 0) && (info.st_size > 0)) {
+            void* data = mmap(0, (size_t)info.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, file, 0);
+            if (data != MAP_FAILED) {
+                out_mapping->data = (u8*)data;
+                out_mapping->size = (umm)info.st_size;
+                result = true;
+            }
+        }
+        close(file);
+    }
+#endif
+    return result;
+}
+
+function
+void unmap_file(File_Mapping* mapping) {
+    if (mapping->data) {
+#if _WIN32
+        UnmapViewOfFile(mapping->data);
+#else
+        munmap(mapping->data, mapping->size);
+#endif
+    }
+    memset(mapping, 0, sizeof(*mapping));
+}
+
+// NOTE: A null path or "-" means stdout. Named pipes are opened like files: a FIFO on POSIX,
+// \\.\pipe\name on Windows, which has to exist already.
+function
+b32 open_output_stream(Output_Stream* stream, char* path) {
+    memset(stream, 0, sizeof(*stream));
+    
+    b32 use_stdout = !path || (strcmp(path, "-") == 0);
+#if _WIN32
+    if (use_stdout) {
+        stream->handle = GetStdHandle(STD_OUTPUT_HANDLE);
+    } else {
+        b32 is_pipe = (strncmp(path, "\\\\.\\pipe\\", 9) == 0);
+        stream->handle = CreateFileA(path, GENERIC_WRITE, 0, 0, is_pipe ? OPEN_EXISTING : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+        stream->owns_handle = true;
+    }
+    b32 result = (stream->handle != INVALID_HANDLE_VALUE) && (stream->handle != 0);
+#else
+    if (use_stdout) {
+        fflush(stdout);
+        stream->handle = STDOUT_FILENO;
+    } else {
+        // NOTE: Opening a FIFO blocks until something opens the other end for reading.
+        stream->handle = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+        stream->owns_handle = true;
+    }
+    b32 result = (stream->handle >= 0);
+    
+    // NOTE: Otherwise the encoder going away kills us on the next write, instead of the write
+    // failing with EPIPE.
+    if (result) {
+        signal(SIGPIPE, SIG_IGN);
+    }
+    
+#if __linux__
+    struct stat info;
+    if (result && (fstat(stream->handle, &info) == 0) && S_ISFIFO(info.st_mode)) {
+        // NOTE: A bigger pipe means fewer wakeups of the reader. This is allowed to fail,
+        // the default size still works.
+        fcntl(stream->handle, F_SETPIPE_SZ, 1 << 20);
+        int pipe_size = fcntl(stream->handle, F_GETPIPE_SZ);
+        stream->pipe_size = (pipe_size > 0) ? (umm)pipe_size : 0;
+    }
+#endif
+#endif
+    
+    if (!result) {
+        fprintf(stderr, "error: Unable to open output stream %s.\n", use_stdout ? "stdout" : path);
+        memset(stream, 0, sizeof(*stream));
+    }
+    return result;
+}
+
+function
+b32 write_output_stream(Output_Stream* stream, void* data, umm size) {
+    u8* at = (u8*)data;
+    while (size > 0) {
+#if _WIN32
+        DWORD chunk = (DWORD)Min(size, 1u << 30);
+        DWORD written = 0;
+        if (!WriteFile(stream->handle, at, chunk, &written, 0) || (written == 0)) {
+            return false;
+        }
+#else
+        ssize_t written = write(stream->handle, at, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+#endif
+        at   += written;
+        size -= written;
+    }
+    return true;
+}
+
+// NOTE: Hands the pages of data to the pipe instead of copying them. The pipe keeps referring
+// to the memory until the reader has consumed it, so the caller must leave data alone until at
+// least pipe_size more bytes have gone into the stream after it. Falls back to a plain write
+// where vmsplice isn't available.
+function
+b32 splice_output_stream(Output_Stream* stream, void* data, umm size) {
+#if __linux__
+    if (stream->pipe_size) {
+        struct iovec io = { data, size };
+        while (io.iov_len > 0) {
+            ssize_t written = vmsplice(stream->handle, &io, 1, 0);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            io.iov_base  = (u8*)io.iov_base + written;
+            io.iov_len  -= written;
+        }
+        if (io.iov_len == 0) {
+            return true;
+        }
+        data = io.iov_base;
+        size = io.iov_len;
+    }
+#endif
+    return write_output_stream(stream, data, size);
+}
+
+function
+void close_output_stream(Output_Stream* stream) {
+    if (stream->owns_handle) {
+#if _WIN32
+        CloseHandle(stream->handle);
+#else
+        close(stream->handle);
+#endif
+    }
+    memset(stream, 0, sizeof(*stream));
+}
+
+//
+// NOTE: Threads
+//
+
+typedef struct Thread_Start {
+    Thread_Proc* proc;
+    void* user_data;
+} Thread_Start;
+
+#if _WIN32
+internal DWORD WINAPI win32_thread_entry(void* param) {
+    Thread_Start start = *(Thread_Start*)param;
+    free(param);
+    start.proc(start.user_data);
+    return 0;
+}
+#else
+internal void* posix_thread_entry(void* param) {
+    Thread_Start start = *(Thread_Start*)param;
+    free(param);
+    start.proc(start.user_data);
+    return 0;
+}
+#endif
+
+function
+Thread create_thread(Thread_Proc* proc, void* user_data) {
+    Thread result = {};
+    
+    Thread_Start* start = (Thread_Start*)malloc(sizeof(Thread_Start));
+    start->proc      = proc;
+    start->user_data = user_data;
+
+#if _WIN32
+    result.handle = CreateThread(0, 0, win32_thread_entry, start, 0, 0);
+#else
+    pthread_create(&result.handle, 0, posix_thread_entry, start);
+#endif
+    
+    return result;
+}
+
+function
+void join_thread(Thread* thread) {
+#if _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, 0);
+#endif
+    memset(thread, 0, sizeof(*thread));
+}
+
+function
+void yield_thread(void) {
+#if _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+//
+// NOTE: Semaphores
+//
+
+function
+void create_semaphore(Semaphore* semaphore, u32 initial_count) {
+#if _WIN32
+    semaphore->handle = CreateSemaphoreA(0, initial_count, INT32_MAX, 0);
+#else
+    sem_init(&semaphore->handle, 0, initial_count);
+#endif
+}
+
+function
+void destroy_semaphore(Semaphore* semaphore) {
+#if _WIN32
+    CloseHandle(semaphore->handle);
+#else
+    sem_destroy(&semaphore->handle);
+#endif
+}
+
+function
+void wait_semaphore(Semaphore* semaphore) {
+#if _WIN32
+    WaitForSingleObject(semaphore->handle, INFINITE);
+#else
+    while (sem_wait(&semaphore->handle) != 0) {
+        // NOTE: Interrupted by a signal, just try again.
+    }
+#endif
+}
+
+function
+void signal_semaphore(Semaphore* semaphore, u32 count) {
+#if _WIN32
+    ReleaseSemaphore(semaphore->handle, count, 0);
+#else
+    for (u32 i = 0; i < count; ++i) {
+        sem_post(&semaphore->handle);
+    }
+#endif
+}
@@ -0,0 +1,55 @@
+/* date = October 19th 2026 11:02 am */
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+//
+// NOTE: The little bit of OS we need: threads, a semaphore to park them on, and atomics.
+// The atomics are straight clang builtins, so they work the same on every target.
+//
+
+#if _WIN32
+typedef struct Thread {
+    HANDLE handle;
+} Thread;
+
+typedef struct Semaphore {
+    HANDLE handle;
+} Semaphore;
+#else
+typedef struct Thread {
+    pthread_t handle;
+} Thread;
+
+typedef struct Semaphore {
+    sem_t handle;
+} Semaphore;
+#endif
+
+typedef void Thread_Proc(void* user_data);
+
+// NOTE: A private, copy-on-write view of a whole file. Writes through data never reach the file.
+typedef struct File_Mapping {
+    u8* data;
+    umm size;
+} File_Mapping;
+
+// NOTE: A sequential output: stdout, a named pipe, or a plain file.
+typedef struct Output_Stream {
+#if _WIN32
+    HANDLE handle;
+#else
+    int handle;
+#endif
+    b32 owns_handle;
+    umm pipe_size; // NOTE: Non-zero if pages can be vmsplice'd into the stream, Linux pipes only
+} Output_Stream;
+
+#define atomic_load(ptr)                 __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define atomic_store(ptr, value)         __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+#define atomic_add(ptr, value)           __atomic_add_fetch(ptr, value, __ATOMIC_ACQ_REL)
+#define atomic_sub(ptr, value)           __atomic_sub_fetch(ptr, value, __ATOMIC_ACQ_REL)
+#define atomic_compare_exchange(ptr, expected, desired) \
+__atomic_compare_exchange_n(ptr, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+
+#endif //PLATFORM_H
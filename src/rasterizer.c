@@ -0,0 +1,262 @@
+//
+// NOTE: Clipping
+//
+
+// NOTE: Clips against the near plane, z >= 0 in clip space, which also gets rid of
+// everything behind the eye so the divide in setup_triangle is safe. The other planes are
+// left to the bounds in setup. Writes a fan of 0, 3 or 4 vertices to out and returns the count.
+function
+u32 clip_to_near_plane(Raster_Vertex* v0, Raster_Vertex* v1, Raster_Vertex* v2, u32 varying_count, Raster_Vertex* out) {
+    Assert(varying_count <= MAX_VARYINGS);
+    Raster_Vertex* in[3] = { v0, v1, v2 };
+    
+    u32 out_count = 0;
+    for (u32 i = 0; i < 3; ++i) {
+        Raster_Vertex* a = in[i];
+        Raster_Vertex* b = in[(i + 1) % 3];
+        b32 a_inside = (a->position.z >= 0.0f);
+        b32 b_inside = (b->position.z >= 0.0f);
+        
+        if (a_inside) {
+            out[out_count++] = *a;
+        }
+        
+        if (a_inside != b_inside) {
+            f32 t = a->position.z / (a->position.z - b->position.z);
+            Raster_Vertex* v = out + out_count++;
+            v->position = a->position + (b->position - a->position)*t;
+            for (u32 varying_index = 0; varying_index < varying_count; ++varying_index) {
+                v->varyings[varying_index] = lerp(a->varyings[varying_index], b->varyings[varying_index], t);
+            }
+        }
+    }
+    
+    return out_count;
+}
+
+//
+// NOTE: Setup
+//
+
+// NOTE: The vertices have to be in front of the near plane, see clip_to_near_plane. Returns
+// false if there's nothing to draw, because the triangle is degenerate or off the target.
+// sample_radius grows the bounds for sample positions that are up to that far from the pixel
+// centers, see get_span.
+function
+b32 setup_triangle(Triangle_Setup* setup, Raster_Vertex* v0, Raster_Vertex* v1, Raster_Vertex* v2, u32 varying_count, u32 width, u32 height, f32 sample_radius) {
+    Assert(varying_count <= MAX_VARYINGS);
+    Raster_Vertex* v[3] = { v0, v1, v2 };
+    
+    u32 plane_count = PLANE_VARYINGS + varying_count;
+    f32 x[3];
+    f32 y[3];
+    f32 values[3][MAX_PLANES];
+    for (u32 i = 0; i < 3; ++i) {
+        V4 p = v[i]->position;
+        f32 one_over_w = 1.0f / p.w;
+        x[i] = (0.5f*p.x*one_over_w + 0.5f)*(f32)width;
+        y[i] = (0.5f*p.y*one_over_w + 0.5f)*(f32)height;
+        
+        values[i][PLANE_ONE_OVER_W] = one_over_w;
+        values[i][PLANE_DEPTH]      = p.z*one_over_w;
+        for (u32 varying_index = 0; varying_index < varying_count; ++varying_index) {
+            values[i][PLANE_VARYINGS + varying_index] = v[i]->varyings[varying_index]*one_over_w;
+        }
+    }
+    
+    f32 area = (x[1] - x[0])*(y[2] - y[0]) - (x[2] - x[0])*(y[1] - y[0]);
+    if (!(area != 0.0f)) {
+        return false;
+    }
+    
+    // NOTE: Clamped while still in float, so far off vertices can't overflow the conversion.
+    f32 min_x = Min(Min(x[0], x[1]), x[2]);
+    f32 min_y = Min(Min(y[0], y[1]), y[2]);
+    f32 max_x = Max(Max(x[0], x[1]), x[2]);
+    f32 max_y = Max(Max(y[0], y[1]), y[2]);
+    setup->bounds.min.x = (s32)ceilf (Clamp(min_x - 0.5f - sample_radius, 0.0f, (f32)width));
+    setup->bounds.min.y = (s32)ceilf (Clamp(min_y - 0.5f - sample_radius, 0.0f, (f32)height));
+    setup->bounds.max.x = (s32)floorf(Clamp(max_x - 0.5f + sample_radius, -1.0f, (f32)width  - 1.0f)) + 1;
+    setup->bounds.max.y = (s32)floorf(Clamp(max_y - 0.5f + sample_radius, -1.0f, (f32)height - 1.0f)) + 1;
+    if ((setup->bounds.min.x >= setup->bounds.max.x) ||
+        (setup->bounds.min.y >= setup->bounds.max.y)) {
+        return false;
+    }
+    
+    // NOTE: Each edge's c comes from whichever end is lower left, so the two triangles that
+    // share an edge get exactly negated equations and agree on which pixels are on it.
+    f32 sign = (area > 0.0f) ? 1.0f : -1.0f;
+    for (u32 i = 0; i < 3; ++i) {
+        u32 j = (i + 1) % 3;
+        u32 origin = ((y[i] < y[j]) || ((y[i] == y[j]) && (x[i] < x[j]))) ? i : j;
+        f32 a = sign*(y[i] - y[j]);
+        f32 b = sign*(x[j] - x[i]);
+        setup->edge_a[i] = a;
+        setup->edge_b[i] = b;
+        setup->edge_c[i] = -(a*x[origin] + b*y[origin]);
+    }
+    
+    f32 one_over_area = 1.0f / area;
+    f32 dx1 = x[1] - x[0];
+    f32 dy1 = y[1] - y[0];
+    f32 dx2 = x[2] - x[0];
+    f32 dy2 = y[2] - y[0];
+    
+    setup->plane_count = plane_count;
+    for (u32 plane_index = 0; plane_index < plane_count; ++plane_index) {
+        f32 d1 = values[1][plane_index] - values[0][plane_index];
+        f32 d2 = values[2][plane_index] - values[0][plane_index];
+        f32 dx = (d1*dy2 - d2*dy1)*one_over_area;
+        f32 dy = (d2*dx1 - d1*dx2)*one_over_area;
+        setup->plane_dx[plane_index]     = dx;
+        setup->plane_dy[plane_index]     = dy;
+        setup->plane_origin[plane_index] = values[0][plane_index] - dx*(x[0] - 0.5f) - dy*(y[0] - 0.5f);
+    }
+    
+    return true;
+}
+
+function
+b32 setup_triangle(Triangle_Setup* setup, Raster_Vertex* v0, Raster_Vertex* v1, Raster_Vertex* v2, u32 varying_count, u32 width, u32 height) {
+    b32 result = setup_triangle(setup, v0, v1, v2, varying_count, width, height, 0.0f);
+    return result;
+}
+
+// NOTE: The covered pixels [begin, end) of row y, which has to be inside the bounds, testing
+// each pixel at its center plus sample_offset. Left edges take samples that are exactly on
+// them, right edges don't. Both sides round the same expression, so a shared edge splits its
+// row with no gap and no overlap.
+function
+b32 get_span(Triangle_Setup* setup, s32 y, V2 sample_offset, s32* begin, s32* end) {
+    f32 sample_y = (f32)y + 0.5f + sample_offset.y;
+    f32 span_begin = (f32)setup->bounds.min.x;
+    f32 span_end   = (f32)setup->bounds.max.x;
+    
+    for (u32 i = 0; i < 3; ++i) {
+        f32 a = setup->edge_a[i];
+        f32 rest = setup->edge_b[i]*sample_y + setup->edge_c[i] + a*sample_offset.x;
+        if (a > 0.0f) {
+            f32 first = ceilf(-rest / a - 0.5f);
+            span_begin = Max(span_begin, first);
+        } else if (a < 0.0f) {
+            f32 last = ceilf(-rest / a - 0.5f);
+            span_end = Min(span_end, last);
+        } else if (!((rest > 0.0f) || ((rest == 0.0f) && (setup->edge_b[i] > 0.0f)))) {
+            return false;
+        }
+    }
+    
+    // NOTE: Also false for NaN, before it gets anywhere near a conversion.
+    b32 result = (span_begin < span_end);
+    if (result) {
+        *begin = (s32)span_begin;
+        *end   = (s32)span_end;
+    }
+    return result;
+}
+
+function
+b32 get_span(Triangle_Setup* setup, s32 y, s32* begin, s32* end) {
+    b32 result = get_span(setup, y, v2(0.0f, 0.0f), begin, end);
+    return result;
+}
+
+//
+// NOTE: Interpolation
+//
+
+function
+void begin_varyings(Varying_Stepper* stepper, Triangle_Setup* setup, s32 x, s32 y) {
+    stepper->plane_count = setup->plane_count;
+    for (u32 plane_index = 0; plane_index < setup->plane_count; ++plane_index) {
+        stepper->values[plane_index] = setup->plane_origin[plane_index] +
+                                       setup->plane_dx[plane_index]*(f32)x +
+                                       setup->plane_dy[plane_index]*(f32)y;
+    }
+}
+
+// NOTE: One pixel to the right.
+function
+void step_varyings(Varying_Stepper* stepper, Triangle_Setup* setup) {
+    for (u32 plane_index = 0; plane_index < stepper->plane_count; ++plane_index) {
+        stepper->values[plane_index] += setup->plane_dx[plane_index];
+    }
+}
+
+// NOTE: count steps to the right at once.
+function
+void step_varyings(Varying_Stepper* stepper, Triangle_Setup* setup, u32 count) {
+    for (u32 plane_index = 0; plane_index < stepper->plane_count; ++plane_index) {
+        stepper->values[plane_index] += setup->plane_dx[plane_index]*(f32)count;
+    }
+}
+
+// NOTE: Depth is already linear in screen space, it doesn't need the correction.
+function
+f32 get_depth(Varying_Stepper* stepper) {
+    f32 result = stepper->values[PLANE_DEPTH];
+    return result;
+}
+
+function
+void get_varyings(Varying_Stepper* stepper, f32* varyings) {
+    f32 w = 1.0f / stepper->values[PLANE_ONE_OVER_W];
+    for (u32 plane_index = PLANE_VARYINGS; plane_index < stepper->plane_count; ++plane_index) {
+        varyings[plane_index - PLANE_VARYINGS] = stepper->values[plane_index]*w;
+    }
+}
+
+// NOTE: A plane at the stepper's pixel and three to the right of it, lanes being how far right.
+internal __m128 evaluate_plane(Varying_Stepper* stepper, Triangle_Setup* setup, u32 plane_index, __m128 lanes) {
+    __m128 result = _mm_add_ps(_mm_set1_ps(stepper->values[plane_index]),
+                               _mm_mul_ps(_mm_set1_ps(setup->plane_dx[plane_index]), lanes));
+    return result;
+}
+
+// NOTE: Lanes from count on repeat the last pixel, so they never go past the end of the span
+// where 1/w might not be positive anymore.
+internal __m128 get_batch_lanes(u32 count) {
+    __m128 result = _mm_min_ps(_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_set1_ps((f32)count - 1.0f));
+    return result;
+}
+
+// NOTE: Depth for the stepper's pixel and the three to the right of it, one per lane, without
+// moving the stepper. The same bits as get_varyings gives, so a depth only pass can be
+// followed by an equal depth test.
+function
+__m128 get_depths(Varying_Stepper* stepper, Triangle_Setup* setup, u32 count) {
+    __m128 result = evaluate_plane(stepper, setup, PLANE_DEPTH, get_batch_lanes(count));
+    return result;
+}
+
+// NOTE: Depth and varyings for the stepper's pixel and the three to the right of it, one per
+// lane, without moving the stepper.
+function
+void get_varyings(Varying_Stepper* stepper, Triangle_Setup* setup, u32 count, __m128* depth, __m128* varyings) {
+    __m128 lanes = get_batch_lanes(count);
+    __m128 w = _mm_div_ps(_mm_set1_ps(1.0f), evaluate_plane(stepper, setup, PLANE_ONE_OVER_W, lanes));
+    
+    *depth = evaluate_plane(stepper, setup, PLANE_DEPTH, lanes);
+    for (u32 plane_index = PLANE_VARYINGS; plane_index < stepper->plane_count; ++plane_index) {
+        varyings[plane_index - PLANE_VARYINGS] = _mm_mul_ps(evaluate_plane(stepper, setup, plane_index, lanes), w);
+    }
+}
+
+// NOTE: The screen space derivatives (d/dx, d/dy) of a varying at the stepper's pixel, for
+// picking mip levels. The quotient rule on varying/w over 1/w, so it stays perspective correct.
+function
+V2 get_varying_gradient(Varying_Stepper* stepper, Triangle_Setup* setup, u32 varying_index) {
+    u32 plane_index = PLANE_VARYINGS + varying_index;
+    f32 w = 1.0f / stepper->values[PLANE_ONE_OVER_W];
+    f32 value = stepper->values[plane_index]*w;
+    V2 result = v2((setup->plane_dx[plane_index] - value*setup->plane_dx[PLANE_ONE_OVER_W])*w,
+                   (setup->plane_dy[plane_index] - value*setup->plane_dy[PLANE_ONE_OVER_W])*w);
+    return result;
+}
+
+// NOTE: Clip space for a point given in pixels, with w = 1, for drawing straight to the screen.
+function
+V4 pixel_to_clip(V2 p, f32 depth, u32 width, u32 height) {
+    V4 result = v4(2.0f*p.x / (f32)width - 1.0f, 2.0f*p.y / (f32)height - 1.0f, depth, 1.0f);
+    return result;
+}
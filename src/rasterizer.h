@@ -0,0 +1,52 @@
+/* date = October 19th 2026 7:50 pm */
+
+#ifndef RASTERIZER_H
+#define RASTERIZER_H
+
+//
+// NOTE: Triangle setup and varyings. A vertex is a clip space position and up to
+// MAX_VARYINGS floats of whatever the shading wants: colors, uvs, normals. Setup does the
+// perspective divide and turns 1/w, depth and every varying/w into a plane equation in screen
+// space, so stepping one pixel to the right is one add per plane. The per pixel perspective
+// correction is one divide to get w back and one multiply per varying.
+//
+// Spans come straight out of the three edge functions, so there's no per pixel coverage test.
+// Pixel centers are at +0.5, and a pixel exactly on an edge shared by two triangles goes to
+// only one of them.
+//
+
+#define MAX_VARYINGS 16
+
+// NOTE: The planes Triangle_Setup interpolates: 1/w and depth, then one per varying.
+#define PLANE_ONE_OVER_W 0
+#define PLANE_DEPTH      1
+#define PLANE_VARYINGS   2
+#define MAX_PLANES       (PLANE_VARYINGS + MAX_VARYINGS)
+
+typedef struct Raster_Vertex {
+    V4 position; // NOTE: Clip space, before the divide
+    f32 varyings[MAX_VARYINGS];
+} Raster_Vertex;
+
+typedef struct Triangle_Setup {
+    // NOTE: The pixels to consider, already clipped to the target. max is exclusive.
+    Rect2i bounds;
+    
+    // NOTE: a*x + b*y + c >= 0 inside, for x and y at pixel centers.
+    f32 edge_a[3];
+    f32 edge_b[3];
+    f32 edge_c[3];
+    
+    u32 plane_count;
+    f32 plane_dx[MAX_PLANES];
+    f32 plane_dy[MAX_PLANES];
+    f32 plane_origin[MAX_PLANES]; // NOTE: The value at the center of pixel (0, 0)
+} Triangle_Setup;
+
+// NOTE: The planes evaluated at one pixel, stepped along a span with step_varyings.
+typedef struct Varying_Stepper {
+    u32 plane_count;
+    f32 values[MAX_PLANES];
+} Varying_Stepper;
+
+#endif //RASTERIZER_H
@@ -1,3 +1,7 @@
+#if __linux__
+#define _GNU_SOURCE // NOTE: For vmsplice and F_SETPIPE_SZ, has to come before any system header
+#endif
+
 #define SDSTR_STATIC
 #define SDSTR_IMPLEMENTATION
 #define SDSTR_USE_STDLIB
@@ -5,8 +9,26 @@
 
 #include "render.h"
 
+#include "platform.c"
+#include "jobs.c"
 #include "image.c"
+#include "image_encoder.c"
+#include "image_pool.c"
+#include "tiled_image.c"
+#include "hdr_image.c"
+#include "rasterizer.c"
+#include "texture.c"
+#include "pipeline.c"
+#include "shadow.c"
+#include "frame_writer.c"
+#include "frame_stream.c"
 #include "obj.c"
+#include "simplify.c"
+#include "bvh.c"
+#include "line.c"
+#include "distance_field.c"
+#include "atlas.c"
+#include "msdf.c"
 
 function
 String_u8 read_entire_file(char* file_name, b32 null_terminate) {
@@ -38,285 +60,1680 @@ String_u8 read_entire_file(char* file_name, b32 null_terminate) {
     return result;
 }
 
+// NOTE: From the center of pixel p0 to the center of pixel p1, both included.
 function
 void plot_line(Image_u32* image, V2i p0, V2i p1, Color_ARGB color) {
-    s32 x0 = p0.x;
-    s32 y0 = p0.y;
-    s32 x1 = p1.x;
-    f32 y1 = p1.y;
+    draw_line(image, vector_convert(V2, p0) + 0.5f, vector_convert(V2, p1) + 0.5f, 1.0f, color, LineStyle_Aliased);
+}
+
+function
+void plot_triangle(Image_u32* image, V2i p0, V2i p1, V2i p2, Color_ARGB color) {
+    plot_line(image, p0, p1, color);
+    plot_line(image, p1, p2, color);
+    plot_line(image, p2, p0, color);
+}
+
+//
+// NOTE: Barycentric pipelines, one per blend mode
+//
+
+typedef struct Barycentric_Uniforms {
+    V4 positions[3];
+    u8 alpha;
+} Barycentric_Uniforms;
+
+internal void barycentric_vertex_shader(Barycentric_Uniforms* uniforms, u32 triangle_index, u32 corner, Raster_Vertex* out) {
+    out->position = uniforms->positions[corner];
+    for (u32 i = 0; i < 3; ++i) {
+        out->varyings[i] = (i == corner) ? 1.0f : 0.0f;
+    }
+}
+
+// NOTE: The weights are the color, premultiplied by the alpha.
+internal __m128i barycentric_fragment_shader(Barycentric_Uniforms* uniforms, Fragment_Batch* batch) {
+    __m128 alpha = _mm_set1_ps((f32)uniforms->alpha);
+    __m128 zero  = _mm_setzero_ps();
+    __m128 one   = _mm_set1_ps(1.0f);
+    
+    __m128i r = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(batch->varyings[0], zero), one), alpha));
+    __m128i g = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(batch->varyings[1], zero), one), alpha));
+    __m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(batch->varyings[2], zero), one), alpha));
+    
+    __m128i result = _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)),
+                                  _mm_or_si128(_mm_slli_epi32(r, 16), _mm_set1_epi32((s32)uniforms->alpha << 24)));
+    return result;
+}
+
+#define PIPELINE_NAME            draw_barycentric_replace
+#define PIPELINE_UNIFORMS        Barycentric_Uniforms
+#define PIPELINE_VERTEX_SHADER   barycentric_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER barycentric_fragment_shader
+#define PIPELINE_VARYING_COUNT   3
+#define PIPELINE_DEPTH_TEST      DepthTest_None
+#define PIPELINE_BLEND_MODE      BlendMode_Replace
+#include "pipeline_template.c"
+
+#define PIPELINE_NAME            draw_barycentric_over
+#define PIPELINE_UNIFORMS        Barycentric_Uniforms
+#define PIPELINE_VERTEX_SHADER   barycentric_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER barycentric_fragment_shader
+#define PIPELINE_VARYING_COUNT   3
+#define PIPELINE_DEPTH_TEST      DepthTest_None
+#define PIPELINE_BLEND_MODE      BlendMode_Over
+#include "pipeline_template.c"
+
+#define PIPELINE_NAME            draw_barycentric_add
+#define PIPELINE_UNIFORMS        Barycentric_Uniforms
+#define PIPELINE_VERTEX_SHADER   barycentric_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER barycentric_fragment_shader
+#define PIPELINE_VARYING_COUNT   3
+#define PIPELINE_DEPTH_TEST      DepthTest_None
+#define PIPELINE_BLEND_MODE      BlendMode_Add
+#include "pipeline_template.c"
+
+#define PIPELINE_NAME            draw_barycentric_multiply
+#define PIPELINE_UNIFORMS        Barycentric_Uniforms
+#define PIPELINE_VERTEX_SHADER   barycentric_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER barycentric_fragment_shader
+#define PIPELINE_VARYING_COUNT   3
+#define PIPELINE_DEPTH_TEST      DepthTest_None
+#define PIPELINE_BLEND_MODE      BlendMode_Multiply
+#include "pipeline_template.c"
+
+// NOTE: Fragments get color's alpha and go through the blend stage with mode. The mode is
+// picked once here, each one has its own pipeline.
+function
+void rasterize_triangle(Image_u32* image, V2i p0, V2i p1, V2i p2, Color_ARGB color, BlendMode mode) {
+    Barycentric_Uniforms uniforms = {};
+    uniforms.positions[0] = pixel_to_clip(vector_convert(V2, p0), 0.0f, image->width, image->height);
+    uniforms.positions[1] = pixel_to_clip(vector_convert(V2, p1), 0.0f, image->width, image->height);
+    uniforms.positions[2] = pixel_to_clip(vector_convert(V2, p2), 0.0f, image->width, image->height);
+    uniforms.alpha = color.a;
+    
+    Render_Target target = {};
+    target.color = image;
+    
+    switch (mode) {
+        case BlendMode_Replace:  { draw_barycentric_replace (&target, &uniforms, 1); } break;
+        case BlendMode_Over:     { draw_barycentric_over    (&target, &uniforms, 1); } break;
+        case BlendMode_Add:      { draw_barycentric_add     (&target, &uniforms, 1); } break;
+        case BlendMode_Multiply: { draw_barycentric_multiply(&target, &uniforms, 1); } break;
+        InvalidDefaultCase;
+    }
+}
+
+function
+void rasterize_triangle(Image_u32* image, V2i p0, V2i p1, V2i p2, Color_ARGB color) {
+    rasterize_triangle(image, p0, p1, p2, rgb(color.r, color.g, color.b), BlendMode_Replace);
+}
+
+#define PIPELINE_NAME            draw_barycentric_replace
+#define PIPELINE_UNIFORMS        Barycentric_Uniforms
+#define PIPELINE_VERTEX_SHADER   barycentric_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER barycentric_fragment_shader
+#define PIPELINE_VARYING_COUNT   3
+#define PIPELINE_DEPTH_TEST      DepthTest_None
+#define PIPELINE_BLEND_MODE      BlendMode_Replace
+#include "multisample_template.c"
+
+#define PIPELINE_NAME            draw_barycentric_over
+#define PIPELINE_UNIFORMS        Barycentric_Uniforms
+#define PIPELINE_VERTEX_SHADER   barycentric_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER barycentric_fragment_shader
+#define PIPELINE_VARYING_COUNT   3
+#define PIPELINE_DEPTH_TEST      DepthTest_None
+#define PIPELINE_BLEND_MODE      BlendMode_Over
+#include "multisample_template.c"
+
+#define PIPELINE_NAME            draw_barycentric_add
+#define PIPELINE_UNIFORMS        Barycentric_Uniforms
+#define PIPELINE_VERTEX_SHADER   barycentric_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER barycentric_fragment_shader
+#define PIPELINE_VARYING_COUNT   3
+#define PIPELINE_DEPTH_TEST      DepthTest_None
+#define PIPELINE_BLEND_MODE      BlendMode_Add
+#include "multisample_template.c"
+
+#define PIPELINE_NAME            draw_barycentric_multiply
+#define PIPELINE_UNIFORMS        Barycentric_Uniforms
+#define PIPELINE_VERTEX_SHADER   barycentric_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER barycentric_fragment_shader
+#define PIPELINE_VARYING_COUNT   3
+#define PIPELINE_DEPTH_TEST      DepthTest_None
+#define PIPELINE_BLEND_MODE      BlendMode_Multiply
+#include "multisample_template.c"
+
+// NOTE: The same, anti-aliased. Edge pixels blend with what's under them by coverage once
+// target is resolved.
+function
+void rasterize_triangle(Multisample_Target* target, V2i p0, V2i p1, V2i p2, Color_ARGB color, BlendMode mode) {
+    Barycentric_Uniforms uniforms = {};
+    uniforms.positions[0] = pixel_to_clip(vector_convert(V2, p0), 0.0f, target->width, target->height);
+    uniforms.positions[1] = pixel_to_clip(vector_convert(V2, p1), 0.0f, target->width, target->height);
+    uniforms.positions[2] = pixel_to_clip(vector_convert(V2, p2), 0.0f, target->width, target->height);
+    uniforms.alpha = color.a;
+    
+    switch (mode) {
+        case BlendMode_Replace:  { draw_barycentric_replace (target, &uniforms, 1); } break;
+        case BlendMode_Over:     { draw_barycentric_over    (target, &uniforms, 1); } break;
+        case BlendMode_Add:      { draw_barycentric_add     (target, &uniforms, 1); } break;
+        case BlendMode_Multiply: { draw_barycentric_multiply(target, &uniforms, 1); } break;
+        InvalidDefaultCase;
+    }
+}
+
+//
+// NOTE: Mesh pipelines
+//
+
+// NOTE: How much light faces turned away from the light still get.
+#define MESH_AMBIENT 0.15f
+
+typedef struct Mesh_Uniforms {
+    Mesh* mesh;
+    M4x4 model_view_projection;
+    V3 light_direction; // NOTE: Towards the light, in model space
+    Color_ARGB color;   // NOTE: For the untextured pipelines
+    Texture* texture;
+    
+    // NOTE: For the shadowed pipelines, which light in world space.
+    Shadow_Map* shadow_map;
+    M4x4 model;
+    M4x4 light_model_view_projection;
+} Mesh_Uniforms;
+
+// NOTE: Varying 0 is the light, 1 and 2 are the uv. The mesh has no normals, so it's lit with
+// the face normal.
+internal void mesh_vertex_shader(Mesh_Uniforms* uniforms, u32 triangle_index, u32 corner, Raster_Vertex* out) {
+    Mesh* mesh = uniforms->mesh;
+    Triangle* triangle = mesh->triangles + triangle_index;
+    
+    V3 p = mesh->vertices[triangle->e[corner]];
+    out->position = m4x4_transform_v4(uniforms->model_view_projection, v4(p.x, p.y, p.z, 1.0f));
+    
+    V3 a = mesh->vertices[triangle->a];
+    V3 b = mesh->vertices[triangle->b];
+    V3 c = mesh->vertices[triangle->c];
+    V3 normal = normalize(cross(b - a, c - a));
+    out->varyings[0] = MESH_AMBIENT + (1.0f - MESH_AMBIENT)*Max(dot(normal, uniforms->light_direction), 0.0f);
+    
+    V2 uv = v2(0.0f, 0.0f);
+    if (mesh->texcoords) {
+        uv = mesh->texcoords[mesh->texcoord_triangles[triangle_index].e[corner]];
+    }
+    out->varyings[1] = uv.x;
+    out->varyings[2] = uv.y;
+}
+
+// NOTE: Multiplies the rgb of four opaque colors by light, which is from 0 to 1.
+internal __m128i light_colors(__m128i colors, __m128 light) {
+    __m128i scale = _mm_cvtps_epi32(_mm_mul_ps(light, _mm_set1_ps(256.0f)));
+    scale = _mm_or_si128(scale, _mm_slli_epi32(scale, 16));
+    
+    __m128i pair_mask = _mm_set1_epi32(0x00FF00FF);
+    __m128i br = _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(colors, pair_mask), scale), 8);
+    __m128i g  = _mm_srli_epi16(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi32(colors, 8), _mm_set1_epi32(0xFF)), scale), 8);
+    
+    __m128i result = _mm_or_si128(_mm_or_si128(br, _mm_slli_epi32(g, 8)), _mm_set1_epi32((s32)0xFF000000));
+    return result;
+}
+
+internal __m128i mesh_flat_fragment_shader(Mesh_Uniforms* uniforms, Fragment_Batch* batch) {
+    __m128i result = light_colors(_mm_set1_epi32((s32)uniforms->color.argb), batch->varyings[0]);
+    return result;
+}
+
+internal __m128i mesh_textured_fragment_shader(Mesh_Uniforms* uniforms, Fragment_Batch* batch) {
+    f32 lod = get_texture_lod(uniforms->texture, get_varying_gradient(batch->stepper, batch->setup, 1),
+                              get_varying_gradient(batch->stepper, batch->setup, 2));
+    __m128i texels = sample_texture(uniforms->texture, batch->varyings[1], batch->varyings[2], lod, TextureFilter_Bilinear);
+    __m128i result = light_colors(texels, batch->varyings[0]);
+    return result;
+}
+
+#define PIPELINE_NAME            draw_mesh_flat
+#define PIPELINE_UNIFORMS        Mesh_Uniforms
+#define PIPELINE_VERTEX_SHADER   mesh_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER mesh_flat_fragment_shader
+#define PIPELINE_VARYING_COUNT   1
+#define PIPELINE_DEPTH_TEST      DepthTest_Less
+#define PIPELINE_BLEND_MODE      BlendMode_Replace
+#include "pipeline_template.c"
+
+#define PIPELINE_NAME            draw_mesh_textured
+#define PIPELINE_UNIFORMS        Mesh_Uniforms
+#define PIPELINE_VERTEX_SHADER   mesh_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER mesh_textured_fragment_shader
+#define PIPELINE_VARYING_COUNT   3
+#define PIPELINE_DEPTH_TEST      DepthTest_Less
+#define PIPELINE_BLEND_MODE      BlendMode_Replace
+#include "pipeline_template.c"
+
+#define VISIBILITY_DRAW_NAME       draw_mesh_flat_visibility
+#define VISIBILITY_SHADE_NAME      shade_mesh_flat_visibility
+#define VISIBILITY_UNIFORMS        Mesh_Uniforms
+#define VISIBILITY_VERTEX_SHADER   mesh_vertex_shader
+#define VISIBILITY_FRAGMENT_SHADER mesh_flat_fragment_shader
+#define VISIBILITY_VARYING_COUNT   1
+#include "visibility_template.c"
+
+#define VISIBILITY_DRAW_NAME       draw_mesh_textured_visibility
+#define VISIBILITY_SHADE_NAME      shade_mesh_textured_visibility
+#define VISIBILITY_UNIFORMS        Mesh_Uniforms
+#define VISIBILITY_VERTEX_SHADER   mesh_vertex_shader
+#define VISIBILITY_FRAGMENT_SHADER mesh_textured_fragment_shader
+#define VISIBILITY_VARYING_COUNT   3
+#include "visibility_template.c"
+
+#define PIPELINE_NAME            draw_mesh_flat
+#define PIPELINE_UNIFORMS        Mesh_Uniforms
+#define PIPELINE_VERTEX_SHADER   mesh_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER mesh_flat_fragment_shader
+#define PIPELINE_VARYING_COUNT   1
+#define PIPELINE_DEPTH_TEST      DepthTest_Less
+#define PIPELINE_BLEND_MODE      BlendMode_Replace
+#include "multisample_template.c"
+
+#define PIPELINE_NAME            draw_mesh_textured
+#define PIPELINE_UNIFORMS        Mesh_Uniforms
+#define PIPELINE_VERTEX_SHADER   mesh_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER mesh_textured_fragment_shader
+#define PIPELINE_VARYING_COUNT   3
+#define PIPELINE_DEPTH_TEST      DepthTest_Less
+#define PIPELINE_BLEND_MODE      BlendMode_Replace
+#include "multisample_template.c"
+
+// NOTE: Just the position, for depth only pipelines.
+internal void mesh_depth_vertex_shader(Mesh_Uniforms* uniforms, u32 triangle_index, u32 corner, Raster_Vertex* out) {
+    Mesh* mesh = uniforms->mesh;
+    V3 p = mesh->vertices[mesh->triangles[triangle_index].e[corner]];
+    out->position = m4x4_transform_v4(uniforms->model_view_projection, v4(p.x, p.y, p.z, 1.0f));
+}
+
+#define PIPELINE_NAME            draw_mesh_depth_only
+#define PIPELINE_UNIFORMS        Mesh_Uniforms
+#define PIPELINE_VERTEX_SHADER   mesh_depth_vertex_shader
+#include "depth_template.c"
+
+// NOTE: Varying 0 is the cosine to the light, without the ambient, 1 and 2 are the uv and 3 to
+// 6 the light space clip position. The position is transformed exactly as in
+// mesh_depth_vertex_shader, so these can follow a depth prepass.
+internal void mesh_shadowed_vertex_shader(Mesh_Uniforms* uniforms, u32 triangle_index, u32 corner, Raster_Vertex* out) {
+    Mesh* mesh = uniforms->mesh;
+    Triangle* triangle = mesh->triangles + triangle_index;
+    
+    V3 p = mesh->vertices[triangle->e[corner]];
+    out->position = m4x4_transform_v4(uniforms->model_view_projection, v4(p.x, p.y, p.z, 1.0f));
+    
+    V3 world[3];
+    for (u32 i = 0; i < 3; ++i) {
+        V3 vertex = mesh->vertices[triangle->e[i]];
+        world[i] = m4x4_transform_v4(uniforms->model, v4(vertex.x, vertex.y, vertex.z, 1.0f)).xyz;
+    }
+    V3 normal = normalize(cross(world[1] - world[0], world[2] - world[0]));
+    out->varyings[0] = Max(dot(normal, uniforms->shadow_map->light_direction), 0.0f);
+    
+    V2 uv = v2(0.0f, 0.0f);
+    if (mesh->texcoords) {
+        uv = mesh->texcoords[mesh->texcoord_triangles[triangle_index].e[corner]];
+    }
+    out->varyings[1] = uv.x;
+    out->varyings[2] = uv.y;
+    
+    V4 light_position = m4x4_transform_v4(uniforms->light_model_view_projection, v4(p.x, p.y, p.z, 1.0f));
+    out->varyings[3] = light_position.x;
+    out->varyings[4] = light_position.y;
+    out->varyings[5] = light_position.z;
+    out->varyings[6] = light_position.w;
+}
+
+internal __m128 get_shadowed_light(Mesh_Uniforms* uniforms, Fragment_Batch* batch) {
+    __m128 n_dot_l = batch->varyings[0];
+    __m128 lit = sample_shadow_map(uniforms->shadow_map, batch->varyings[3], batch->varyings[4],
+                                   batch->varyings[5], batch->varyings[6], n_dot_l);
+    __m128 result = _mm_add_ps(_mm_set1_ps(MESH_AMBIENT), _mm_mul_ps(_mm_set1_ps(1.0f - MESH_AMBIENT), _mm_mul_ps(n_dot_l, lit)));
+    return result;
+}
+
+internal __m128i mesh_shadowed_flat_fragment_shader(Mesh_Uniforms* uniforms, Fragment_Batch* batch) {
+    __m128i result = light_colors(_mm_set1_epi32((s32)uniforms->color.argb), get_shadowed_light(uniforms, batch));
+    return result;
+}
+
+internal __m128i mesh_shadowed_textured_fragment_shader(Mesh_Uniforms* uniforms, Fragment_Batch* batch) {
+    f32 lod = get_texture_lod(uniforms->texture, get_varying_gradient(batch->stepper, batch->setup, 1),
+                              get_varying_gradient(batch->stepper, batch->setup, 2));
+    __m128i texels = sample_texture(uniforms->texture, batch->varyings[1], batch->varyings[2], lod, TextureFilter_Bilinear);
+    __m128i result = light_colors(texels, get_shadowed_light(uniforms, batch));
+    return result;
+}
+
+#define PIPELINE_NAME            draw_mesh_shadowed_flat
+#define PIPELINE_UNIFORMS        Mesh_Uniforms
+#define PIPELINE_VERTEX_SHADER   mesh_shadowed_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER mesh_shadowed_flat_fragment_shader
+#define PIPELINE_VARYING_COUNT   7
+#define PIPELINE_DEPTH_TEST      DepthTest_LessEqual
+#define PIPELINE_BLEND_MODE      BlendMode_Replace
+#include "pipeline_template.c"
+
+#define PIPELINE_NAME            draw_mesh_shadowed_textured
+#define PIPELINE_UNIFORMS        Mesh_Uniforms
+#define PIPELINE_VERTEX_SHADER   mesh_shadowed_vertex_shader
+#define PIPELINE_FRAGMENT_SHADER mesh_shadowed_textured_fragment_shader
+#define PIPELINE_VARYING_COUNT   7
+#define PIPELINE_DEPTH_TEST      DepthTest_LessEqual
+#define PIPELINE_BLEND_MODE      BlendMode_Replace
+#include "pipeline_template.c"
+
+internal Mesh_Uniforms make_mesh_uniforms(Mesh* mesh, M4x4 model_view_projection, Texture* texture) {
+    Mesh_Uniforms result = {};
+    result.mesh                  = mesh;
+    result.model_view_projection = model_view_projection;
+    result.light_direction       = normalize(v3(0.3f, 0.5f, 1.0f));
+    result.color                 = rgb(200, 200, 200);
+    result.texture               = texture;
+    return result;
+}
+
+// NOTE: target needs a depth buffer. Without a texture, or texcoords, the mesh is drawn in
+// flat gray.
+function
+void draw_mesh(Render_Target* target, Mesh* mesh, M4x4 model_view_projection, Texture* texture) {
+    Mesh_Uniforms uniforms = make_mesh_uniforms(mesh, model_view_projection, texture);
+    if (texture && mesh->texcoords) {
+        draw_mesh_textured(target, &uniforms, mesh->triangle_count);
+    } else {
+        draw_mesh_flat(target, &uniforms, mesh->triangle_count);
+    }
+}
+
+function
+void draw_mesh(Multisample_Target* target, Mesh* mesh, M4x4 model_view_projection, Texture* texture) {
+    Mesh_Uniforms uniforms = make_mesh_uniforms(mesh, model_view_projection, texture);
+    if (texture && mesh->texcoords) {
+        draw_mesh_textured(target, &uniforms, mesh->triangle_count);
+    } else {
+        draw_mesh_flat(target, &uniforms, mesh->triangle_count);
+    }
+}
+
+//
+// NOTE: Instancing
+//
+
+typedef struct Mesh_Instance {
+    Mesh_Uniforms uniforms;
+    b32 textured;
+    b32 visible;
+    s32 min_y; // NOTE: The rows [min_y, max_y) it can cover.
+    s32 max_y;
+    
+    // NOTE: Its triangles in the current batch, at most two per mesh triangle.
+    u32 first_setup;
+    u32 setup_count;
+} Mesh_Instance;
+
+typedef struct Instanced_Draw {
+    Render_Target* target;
+    Mesh* mesh;       // NOTE: For the bounds, and the one drawn without lods.
+    Mesh_LODs* lods;  // NOTE: 0 to always draw mesh.
+    Texture* texture;
+    M4x4 view_projection;
+    Frustum frustum;
     
-    s32 dx =  Abs(x1 - x0);
-    s32 dy = -Abs(y1 - y0);
+    M4x4* models;
+    Mesh_Instance* instances;
+    u32 instance_count;
     
-    s32 xi = (x1 > x0 ? 1 : -1);
-    s32 yi = (y1 > y0 ? 1 : -1);
-    s32 err = dx + dy;
+    // NOTE: Indices of the visible instances, in draw order.
+    u32* visible;
+    u32 visible_count;
     
-    s32 x = x0;
-    s32 y = y0;
+    // NOTE: The visible instances [batch_first, batch_first + batch_count) are set up into
+    // these, then drawn.
+    u32 batch_first;
+    u32 batch_count;
+    Triangle_Setup* setups;
+    u32* setup_triangles; // NOTE: The mesh triangle of each setup, for the fragment shader.
+} Instanced_Draw;
+
+internal void instance_cull_job(void* user_data, u32 job_index, u32 worker_index) {
+    Instanced_Draw* draw = (Instanced_Draw*)user_data;
+    Mesh* mesh = draw->mesh;
     
-    for (;;) {
-        set_pixel(image, x, y, color);
+    u32 first = job_index*INSTANCE_CULL_BATCH;
+    u32 last  = Min(first + INSTANCE_CULL_BATCH, draw->instance_count);
+    for (u32 index = first; index < last; ++index) {
+        M4x4 model = draw->models[index];
+        Mesh_Instance* instance = draw->instances + index;
         
-        if (x == x1 && y == y1) {
-            break;
+        // NOTE: The longest basis vector bounds how much the model matrix can stretch the sphere.
+        f32 scale_sq = 0.0f;
+        for (u32 column = 0; column < 3; ++column) {
+            scale_sq = Max(scale_sq, length_sq(v3(model.e[0][column], model.e[1][column], model.e[2][column])));
         }
+        V3 center = m4x4_transform_v4(model, v4(mesh->bounds_center.x, mesh->bounds_center.y, mesh->bounds_center.z, 1.0f)).xyz;
+        f32 radius = mesh->bounds_radius*sqrtf(scale_sq);
         
-        s32 err2 = 2*err;
-        if (err2 >= dy) {
-            err += dy;
-            x += xi;
+        instance->visible = sphere_in_frustum(&draw->frustum, center, radius);
+        if (instance->visible) {
+            Mesh* instance_mesh = mesh;
+            if (draw->lods) {
+                u32 lod = select_mesh_lod(draw->lods, model, draw->view_projection, draw->target->color->height);
+                instance_mesh = draw->lods->lods + lod;
+            }
+            instance->uniforms = make_mesh_uniforms(instance_mesh, m4x4_mul(draw->view_projection, model), draw->texture);
+            instance->textured = draw->texture && instance_mesh->texcoords;
+            get_sphere_rows(draw->view_projection, center, radius, draw->target->color->height, &instance->min_y, &instance->max_y);
+        }
+    }
+}
+
+// NOTE: Transforms and sets up every triangle of one instance in the batch, once, for all the
+// bands it covers.
+internal void instance_setup_job(void* user_data, u32 job_index, u32 worker_index) {
+    Instanced_Draw* draw = (Instanced_Draw*)user_data;
+    Image_u32* color = draw->target->color;
+    Mesh_Instance* instance = draw->instances + draw->visible[draw->batch_first + job_index];
+    Mesh_Uniforms* uniforms = &instance->uniforms;
+    
+    Triangle_Setup* setups = draw->setups + instance->first_setup;
+    u32* setup_triangles = draw->setup_triangles + instance->first_setup;
+    u32 setup_count = 0;
+    for (u32 triangle_index = 0; triangle_index < uniforms->mesh->triangle_count; ++triangle_index) {
+        u32 count;
+        if (instance->textured) {
+            count = draw_mesh_textured_setup(uniforms, triangle_index, color->width, color->height, setups + setup_count);
+        } else {
+            count = draw_mesh_flat_setup(uniforms, triangle_index, color->width, color->height, setups + setup_count);
         }
-        if (err2 <= dx) {
-            err += dx;
-            y += yi;
+        for (u32 i = 0; i < count; ++i) {
+            setup_triangles[setup_count++] = triangle_index;
         }
     }
+    instance->setup_count = setup_count;
 }
 
+internal void instance_band_job(void* user_data, u32 job_index, u32 worker_index) {
+    Instanced_Draw* draw = (Instanced_Draw*)user_data;
+    Image_u32* color = draw->target->color;
+    
+    Rect2i band;
+    band.min.x = 0;
+    band.min.y = job_index*INSTANCE_BAND_HEIGHT;
+    band.max.x = color->width;
+    band.max.y = Min(band.min.y + INSTANCE_BAND_HEIGHT, (s32)color->height);
+    
+    Render_Target target = *draw->target;
+    target.scissor = &band;
+    
+    for (u32 i = 0; i < draw->batch_count; ++i) {
+        Mesh_Instance* instance = draw->instances + draw->visible[draw->batch_first + i];
+        if ((instance->max_y <= band.min.y) || (instance->min_y >= band.max.y)) {
+            continue;
+        }
+        
+        for (u32 setup_index = instance->first_setup; setup_index < instance->first_setup + instance->setup_count; ++setup_index) {
+            Triangle_Setup* setup = draw->setups + setup_index;
+            if ((setup->bounds.max.y <= band.min.y) || (setup->bounds.min.y >= band.max.y)) {
+                continue;
+            }
+            if (instance->textured) {
+                draw_mesh_textured_rasterize(&target, &instance->uniforms, draw->setup_triangles[setup_index], setup);
+            } else {
+                draw_mesh_flat_rasterize(&target, &instance->uniforms, draw->setup_triangles[setup_index], setup);
+            }
+        }
+    }
+}
+
+internal void run_instance_jobs(Job_Pool* pool, u32 job_count, Job_Proc* proc, Instanced_Draw* draw) {
+    if (pool) {
+        parallel_for(pool, job_count, proc, draw);
+    } else {
+        for (u32 job_index = 0; job_index < job_count; ++job_index) {
+            proc(draw, job_index, 0);
+        }
+    }
+}
+
+internal void draw_instances(Render_Target* target, Job_Pool* pool, Mesh* mesh, Mesh_LODs* lods, M4x4 view_projection, M4x4* models, u32 instance_count, Texture* texture) {
+    Instanced_Draw draw = {};
+    draw.target          = target;
+    draw.mesh            = mesh;
+    draw.lods            = lods;
+    draw.texture         = texture;
+    draw.view_projection = view_projection;
+    draw.frustum         = make_frustum(view_projection);
+    draw.models          = models;
+    draw.instances       = (Mesh_Instance*)malloc(sizeof(Mesh_Instance)*(umm)Max(instance_count, 1));
+    draw.instance_count  = instance_count;
+    draw.visible         = (u32*)malloc(sizeof(u32)*(umm)Max(instance_count, 1));
+    
+    u32 cull_job_count = (instance_count + INSTANCE_CULL_BATCH - 1) / INSTANCE_CULL_BATCH;
+    u32 band_job_count = (target->color->height + INSTANCE_BAND_HEIGHT - 1) / INSTANCE_BAND_HEIGHT;
+    run_instance_jobs(pool, cull_job_count, instance_cull_job, &draw);
+    
+    for (u32 index = 0; index < instance_count; ++index) {
+        if (draw.instances[index].visible) {
+            draw.visible[draw.visible_count++] = index;
+        }
+    }
+    
+    // NOTE: Every level of detail has at most as many triangles as mesh, so any one instance
+    // fits in a batch.
+    u32 setup_capacity = Max(INSTANCE_SETUP_BATCH, 2*mesh->triangle_count);
+    if (draw.visible_count) {
+        draw.setups          = (Triangle_Setup*)malloc(sizeof(Triangle_Setup)*(umm)setup_capacity);
+        draw.setup_triangles = (u32*)malloc(sizeof(u32)*(umm)setup_capacity);
+    }
+    
+    while (draw.batch_first < draw.visible_count) {
+        u32 setup_count = 0;
+        draw.batch_count = 0;
+        while (draw.batch_first + draw.batch_count < draw.visible_count) {
+            Mesh_Instance* instance = draw.instances + draw.visible[draw.batch_first + draw.batch_count];
+            u32 max_setup_count = 2*instance->uniforms.mesh->triangle_count;
+            if (setup_count + max_setup_count > setup_capacity) {
+                break;
+            }
+            instance->first_setup = setup_count;
+            setup_count += max_setup_count;
+            ++draw.batch_count;
+        }
+        
+        run_instance_jobs(pool, draw.batch_count, instance_setup_job, &draw);
+        run_instance_jobs(pool, band_job_count, instance_band_job, &draw);
+        draw.batch_first += draw.batch_count;
+    }
+    
+    free(draw.setup_triangles);
+    free(draw.setups);
+    free(draw.visible);
+    free(draw.instances);
+}
+
+// NOTE: The same as calling draw_mesh for each model in turn, but instances outside the view
+// are culled and the rest are drawn by pool in bands. The mesh needs its bounds, and the
+// pool can be 0.
 function
-void plot_triangle(Image_u32* image, V2i p0, V2i p1, V2i p2, Color_ARGB color) {
-    plot_line(image, p0, p1, color);
-    plot_line(image, p1, p2, color);
-    plot_line(image, p2, p0, color);
+void draw_mesh_instanced(Render_Target* target, Job_Pool* pool, Mesh* mesh, M4x4 view_projection, M4x4* models, u32 instance_count, Texture* texture) {
+    draw_instances(target, pool, mesh, 0, view_projection, models, instance_count, texture);
 }
 
+// NOTE: The same, with each instance drawn at the level of detail select_mesh_lod picks for it.
 function
-void bayercentric(V2i a, V2i b, V2i c, V2i p, f32* u, f32* v, f32* w) {
-    V2 v0 = vector_convert(V2, (b - a));
-    V2 v1 = vector_convert(V2, (c - a));
-    V2 v2 = vector_convert(V2, (p - a));
-    f32 d00 = dot(v0, v0);
-    f32 d01 = dot(v0, v1);
-    f32 d11 = dot(v1, v1);
-    f32 d20 = dot(v2, v0);
-    f32 d21 = dot(v2, v1);
-    f32 denom = d00*d11 - d01*d01;
-    *v = (d11*d20 - d01*d21) / denom;
-    *w = (d00*d21 - d01*d20) / denom;
-    *u = (1.0f - *v - *w);
+void draw_mesh_instanced(Render_Target* target, Job_Pool* pool, Mesh_LODs* lods, M4x4 view_projection, M4x4* models, u32 instance_count, Texture* texture) {
+    draw_instances(target, pool, lods->lods, lods, view_projection, models, instance_count, texture);
 }
 
-typedef struct SlopeData {
-    s32 height;
-    f32 step;
-    f32 x;
-} SlopeData;
+function
+void draw_mesh(Render_Target* target, Mesh_LODs* lods, M4x4 model, M4x4 view_projection, Texture* texture) {
+    u32 lod = select_mesh_lod(lods, model, view_projection, target->color->height);
+    draw_mesh(target, lods->lods + lod, m4x4_mul(view_projection, model), texture);
+}
 
+// NOTE: Only depth, for a prepass or a shadow map.
 function
-void fill_slope_data(V2i p0, V2i p1, SlopeData* data) {
-    data->height = (p1.y - p0.y);
-    data->step   = (f32)(p1.x - p0.x) / (f32)data->height;
-    data->x      = (f32)p0.x;
+void draw_mesh_depth(Image_f32* depth, Mesh* mesh, M4x4 model_view_projection) {
+    Mesh_Uniforms uniforms = {};
+    uniforms.mesh                  = mesh;
+    uniforms.model_view_projection = model_view_projection;
+    draw_mesh_depth_only(depth, &uniforms, mesh->triangle_count);
 }
 
 function
-void rasterize_triangle(Image_u32* image, V2i p0, V2i p1, V2i p2, Color_ARGB color) {
-    if (p1.y < p0.y) { Swap(p0, p1); }
-    if (p2.y < p0.y) { Swap(p0, p2); }
-    if (p2.y < p1.y) { Swap(p1, p2); }
+void render_shadow_map(Shadow_Map* map, Mesh* mesh, M4x4 model) {
+    draw_mesh_depth(&map->depth, mesh, m4x4_mul(map->light_view_projection, model));
+}
+
+// NOTE: Lit by the shadow map's light, and shadowed by whatever was rendered into it. Pixels at
+// the same depth as what's in target pass, so this can follow draw_mesh_depth of the same mesh
+// and only shade what's visible.
+function
+void draw_mesh(Render_Target* target, Mesh* mesh, M4x4 model, M4x4 view_projection, Texture* texture, Shadow_Map* shadow_map) {
+    Mesh_Uniforms uniforms = make_mesh_uniforms(mesh, m4x4_mul(view_projection, model), texture);
+    uniforms.shadow_map                  = shadow_map;
+    uniforms.model                       = model;
+    uniforms.light_model_view_projection = m4x4_mul(shadow_map->light_view_projection, model);
+    if (texture && mesh->texcoords) {
+        draw_mesh_shadowed_textured(target, &uniforms, mesh->triangle_count);
+    } else {
+        draw_mesh_shadowed_flat(target, &uniforms, mesh->triangle_count);
+    }
+}
+
+// NOTE: The same through a visibility buffer, so each pixel of target is shaded once however
+// many triangles cover it. buffer is cleared here and keeps the depth afterwards. pool can be 0.
+function
+void draw_mesh(Visibility_Buffer* buffer, Image_u32* target, Job_Pool* pool, Mesh* mesh, M4x4 model_view_projection, Texture* texture) {
+    Mesh_Uniforms uniforms = make_mesh_uniforms(mesh, model_view_projection, texture);
+    clear_visibility_buffer(buffer);
+    if (texture && mesh->texcoords) {
+        draw_mesh_textured_visibility(buffer, &uniforms, mesh->triangle_count);
+        shade_mesh_textured_visibility(buffer, &uniforms, target, pool);
+    } else {
+        draw_mesh_flat_visibility(buffer, &uniforms, mesh->triangle_count);
+        shade_mesh_flat_visibility(buffer, &uniforms, target, pool);
+    }
+}
+
+// NOTE: Straight onto the screen, x and y from -1 to 1 covering the image and +z towards the viewer.
+function
+void draw_mesh(Image_u32* image, Mesh* mesh) {
+    Image_f32 depth = allocate_image_f32(image->width, image->height);
+    clear_image(&depth, 1.0f);
     
-    if (p0.y != p2.y) {
-        b32 short_side = (p1.y - p0.y)*(p2.x - p0.x) < (p2.y - p0.y)*(p1.x - p0.x);
-        
-        SlopeData slope_data[2];
-        fill_slope_data(p0, p2, &slope_data[!short_side]);
-        
-        for (s32 y = p0.y, end_y = p0.y; ; ++y) {
-            if (y >= end_y) {
-                if (y >= p2.y) {
-                    break;
+    Render_Target target = {};
+    target.color = image;
+    target.depth = &depth;
+    
+    M4x4 screen = {
+        {
+            { 1, 0,  0,    0,    },
+            { 0, 1,  0,    0,    },
+            { 0, 0, -0.5f, 0.5f, },
+            { 0, 0,  0,    1,    },
+        }
+    };
+    draw_mesh(&target, mesh, screen, 0);
+    
+    free_image(&depth);
+}
+
+function
+Image_u32 make_glyph_mask(char* glyph, u32 width, u32 height) {
+    Image_u32 result = allocate_image(width, height);
+    for (u32 cell_y = 0; cell_y < 5; ++cell_y) {
+        for (u32 cell_x = 0; cell_x < 5; ++cell_x) {
+            if (glyph[(4 - cell_y)*5 + cell_x]) {
+                u32 x0 = (cell_x*width + 4) / 5;
+                u32 y0 = (cell_y*height + 4) / 5;
+                u32 x1 = ((cell_x + 1)*width + 4) / 5;
+                u32 y1 = ((cell_y + 1)*height + 4) / 5;
+                fill_rect(&result, x0, y0, x1 - x0, y1 - y0, (Color_ARGB) { .a = 255 });
+            }
+        }
+    }
+    return result;
+}
+
+function
+void voronoi_test(void) {
+    enum { N = 512 };
+    Image_u32 image_source = allocate_image(N, N);
+    
+    char a[] = {
+        0, 0, 1, 0, 0,
+        0, 1, 0, 1, 0,
+        1, 0, 0, 0, 1,
+        1, 1, 1, 1, 1,
+        1, 0, 0, 0, 1,
+    };
+    
+    u32 margin = 128;
+    Image_u32 glyph = make_glyph_mask(a, N - 2*margin, N - 2*margin);
+    blit_image(&image_source, margin, margin, &glyph);
+    free_image(&glyph);
+    
+    Image_u32 sdf = produce_signed_distance_field(&image_source, 8);
+    write_image("signed_distance_field.bmp", &sdf);
+    
+    // NOTE: Through a pool, only the first field allocates and faults in its images.
+    Image_Pool pool;
+    create_image_pool(&pool, true);
+    f64 pool_start_time = get_time_seconds();
+    for (u32 i = 0; i < 8; ++i) {
+        Image_u32 pooled_sdf = produce_signed_distance_field(&image_source, 8, &pool);
+        release_image(&pool, &pooled_sdf);
+    }
+    printf("pooled distance fields: %.2f ms each, %llu allocations, %llu reuses\n",
+           1000.0*(get_time_seconds() - pool_start_time) / 8.0,
+           (unsigned long long)pool.allocation_count, (unsigned long long)pool.reuse_count);
+    destroy_image_pool(&pool);
+    
+    // NOTE: The outer flood again on the tiled layout, checked against the linear one.
+    Image_u32 linear_seeds = allocate_image(N, N);
+    seed_nearest_seed_map(&image_source, DistanceField_Outer, &linear_seeds);
+    Tiled_Image_u32 tiled_seeds   = allocate_tiled_image(N, N);
+    Tiled_Image_u32 tiled_scratch = allocate_tiled_image(N, N);
+    tile_image(&linear_seeds, &tiled_seeds);
+    
+    f64 linear_start_time = get_time_seconds();
+    jump_flood(&linear_seeds, 0);
+    f64 tiled_start_time = get_time_seconds();
+    jump_flood(&tiled_seeds, 0, &tiled_scratch);
+    f64 tiled_end_time = get_time_seconds();
+    
+    Image_u32 resolved_seeds = allocate_image(N, N);
+    resolve_tiled_image(&tiled_seeds, &resolved_seeds);
+    b32 identical = (memcmp(resolved_seeds.pixels, linear_seeds.pixels, get_total_pixel_size(&linear_seeds)) == 0);
+    printf("jump flood: linear %.2f ms, tiled %.2f ms, %s\n",
+           1000.0*(tiled_start_time - linear_start_time), 1000.0*(tiled_end_time - tiled_start_time),
+           identical ? "identical" : "mismatch");
+    
+    free_image(&linear_seeds);
+    free_image(&resolved_seeds);
+    free_image(&tiled_seeds);
+    free_image(&tiled_scratch);
+    
+    Image_u8 sdf_u8 = produce_signed_distance_field_u8(&image_source, 32.0f);
+    write_image("signed_distance_field_r8.bmp", &sdf_u8);
+    
+    Image_u16 sdf_u16 = produce_signed_distance_field_u16(&image_source, 32.0f);
+    write_image("signed_distance_field_r16.pgm", &sdf_u16);
+    
+    Image_f16 sdf_f16 = produce_signed_distance_field_f16(&image_source);
+    write_image("signed_distance_field_f16.pfm", &sdf_f16);
+    
+    // NOTE: Box filter the source down by 4 to get an anti-aliased mask, and recover
+    // the edge from its coverage instead of thresholding.
+    u32 scale = 4;
+    Image_u32 image_small = allocate_image(N / scale, N / scale);
+    for (u32 y = 0; y < image_small.height; ++y) {
+        for (u32 x = 0; x < image_small.width; ++x) {
+            u32 coverage = 0;
+            for (u32 sub_y = 0; sub_y < scale; ++sub_y) {
+                for (u32 sub_x = 0; sub_x < scale; ++sub_x) {
+                    coverage += (Color_ARGB) { .argb = get_pixel(&image_source, scale*x + sub_x, scale*y + sub_y) }.a;
                 }
-                
-                if (y < p1.y) {
-                    fill_slope_data(p0, p1, &slope_data[short_side]);
-                    end_y = p1.y;
-                } else {
-                    fill_slope_data(p1, p2, &slope_data[short_side]);
-                    end_y = p2.y;
+            }
+            set_pixel(&image_small, x, y, (Color_ARGB) { .a = (u8)(coverage / (scale*scale)) });
+        }
+    }
+    
+    Image_u8 sdf_aa = produce_signed_distance_field_u8(&image_small, 8.0f, DistanceFieldSeeding_AntiAliased);
+    write_image("signed_distance_field_aa_r8.bmp", &sdf_aa);
+    
+    Tiled_Distance_Field_Io io = {};
+    io.src_image = &image_source;
+    if (begin_tiled_bmp_output(&io, "signed_distance_field_tiled_r8.bmp", N, N, 128)) {
+        Tiled_Distance_Field_Desc desc = {};
+        desc.width      = N;
+        desc.height     = N;
+        desc.tile_size  = 128;
+        desc.spread     = 32.0f;
+        desc.seeding    = DistanceFieldSeeding_Threshold;
+        desc.read_alpha = read_alpha_from_image;
+        desc.write_tile = write_tile_to_bmp;
+        desc.user_data  = &io;
+        produce_signed_distance_field_tiled(&desc);
+        end_tiled_bmp_output(&io);
+        
+        // NOTE: Read back and checked against the whole-image field with the same spread. Only
+        // pixels where the flood missed the nearest seed in one of the two can differ.
+        Loaded_Image tiled;
+        if (read_image("signed_distance_field_tiled_r8.bmp", &tiled)) {
+            u32 tolerance = 2;
+            u32 mismatches = 0;
+            u32 max_difference = 0;
+            for (u32 y = 0; y < N; ++y) {
+                for (u32 x = 0; x < N; ++x) {
+                    s32 tiled_value = (Color_ARGB) { .argb = get_pixel(&tiled.image, x, y) }.r;
+                    s32 whole_value = get_pixel(&sdf_u8, x, y);
+                    u32 difference = (u32)Abs(tiled_value - whole_value);
+                    mismatches += (difference != 0);
+                    max_difference = Max(max_difference, difference);
                 }
             }
+            printf("tiled distance field: %u pixels differ from the whole image, by at most %u, %s\n", mismatches,
+                   max_difference, (max_difference <= tolerance) ? "match" : "mismatch");
+            free_loaded_image(&tiled);
+        }
+    }
+}
+
+// NOTE: Narrow skylines packed with thin rectangles, which is when the skyline has as many
+// nodes as the atlas is wide. Checks the skyline still covers the width and nothing overlaps.
+function
+void skyline_packer_test(void) {
+    u32 failures = 0;
+    u32 packed_count = 0;
+    u32 seed = 1;
+    for (u32 width = 1; width <= 8; ++width) {
+        for (u32 round = 0; round < 64; ++round) {
+            u32 height = 16;
+            u8 occupied[8*16] = {};
+            Skyline_Packer packer;
+            begin_skyline_packer(&packer, width, height);
             
-            for (s32 x = (s32)slope_data[0].x; x < (s32)slope_data[1].x; ++x) {
-                f32 u, v, w;
-                bayercentric(p0, p1, p2, v2i(x, y), &u, &v, &w);
-                set_pixel(image, x, y, rgb((s32)(255.0f*u), (s32)(255.0f*v), (s32)(255.0f*w)));
+            // NOTE: The first round starts with 1x1, 1x2, 1x1, which leaves one node per column.
+            u32 heights[] = { 1, 2, 1 };
+            for (u32 i = 0; i < 64; ++i) {
+                seed = seed*1664525 + 1013904223;
+                u32 rect_width  = (round && (seed & 0x30000)) ? 1 + (seed >> 20) % width : 1;
+                u32 rect_height = (!round && (i < ArrayCount(heights))) ? heights[i] : 1 + (seed >> 24) % 3;
+                
+                u32 x, y;
+                if (!skyline_pack(&packer, rect_width, rect_height, &x, &y)) {
+                    continue;
+                }
+                ++packed_count;
+                
+                for (u32 row = y; row < y + rect_height; ++row) {
+                    for (u32 column = x; column < x + rect_width; ++column) {
+                        failures += occupied[row*width + column];
+                        occupied[row*width + column] = 1;
+                    }
+                }
+                
+                u32 covered = 0;
+                for (u32 node_index = 0; node_index < packer.node_count; ++node_index) {
+                    failures += (packer.nodes[node_index].x != covered) || !packer.nodes[node_index].width;
+                    covered += packer.nodes[node_index].width;
+                }
+                failures += (covered != width) || (packer.node_count > width);
             }
             
-            slope_data[0].x += slope_data[0].step;
-            slope_data[1].x += slope_data[1].step;
+            end_skyline_packer(&packer);
         }
     }
+    
+    printf("skyline packer: %u rectangles packed, %u failures\n", packed_count, failures);
 }
 
-function void draw_mesh(Image_u32* image, Mesh* mesh) {
-    for (u32 triangle_index = 0; triangle_index < mesh->triangle_count; ++triangle_index) {
-        Triangle* t = mesh->triangles + triangle_index;
-        V2i screen_coords[3];
-        for (u32 vert_index = 0; vert_index < 3; ++vert_index) {
-            V3 v0 = mesh->vertices[t->e[vert_index]];
-            s32 x0 = (s32)(0.5f*image->width*(v0.x + 1.0f));
-            s32 y0 = (s32)(0.5f*image->height*(v0.y + 1.0f));
-            screen_coords[vert_index] = v2i(x0, y0);
+function
+void atlas_test(void) {
+    char glyphs[][25] = {
+        {
+            0, 0, 1, 0, 0,
+            0, 1, 0, 1, 0,
+            1, 0, 0, 0, 1,
+            1, 1, 1, 1, 1,
+            1, 0, 0, 0, 1,
+        },
+        {
+            1, 1, 1, 1, 0,
+            1, 0, 0, 0, 1,
+            1, 1, 1, 1, 0,
+            1, 0, 0, 0, 1,
+            1, 1, 1, 1, 0,
+        },
+        {
+            0, 1, 1, 1, 1,
+            1, 0, 0, 0, 0,
+            1, 0, 0, 0, 0,
+            1, 0, 0, 0, 0,
+            0, 1, 1, 1, 1,
+        },
+    };
+    
+    enum { MASK_COUNT = 1024 };
+    Image_u32* masks = (Image_u32*)malloc(sizeof(Image_u32)*MASK_COUNT);
+    for (u32 mask_index = 0; mask_index < MASK_COUNT; ++mask_index) {
+        u32 size = 10 + rand() % 40;
+        masks[mask_index] = make_glyph_mask(glyphs[mask_index % ArrayCount(glyphs)], size, size + rand() % 8);
+    }
+    
+    Job_Pool pool;
+    create_job_pool(&pool, 0);
+    
+    Distance_Field_Atlas_Desc desc = {};
+    desc.atlas_width = 2048;
+    desc.padding     = 4;
+    desc.spread      = 4.0f;
+    desc.seeding     = DistanceFieldSeeding_Threshold;
+    
+    Distance_Field_Atlas atlas = produce_distance_field_atlas(&pool, masks, MASK_COUNT, &desc);
+    write_image("distance_field_atlas.bmp", &atlas.image);
+    write_atlas_metadata("distance_field_atlas.txt", &atlas);
+    
+    free_distance_field_atlas(&atlas);
+    destroy_job_pool(&pool);
+    for (u32 mask_index = 0; mask_index < MASK_COUNT; ++mask_index) {
+        free_image(&masks[mask_index]);
+    }
+    free(masks);
+}
+
+// NOTE: Generates a single and a multi-channel field for the same glyph at low resolution and
+// blows both up, to compare how well they hold on to the corners.
+function
+void multi_channel_distance_field_test(void) {
+    char glyph[] = {
+        0, 0, 1, 0, 0,
+        0, 1, 0, 1, 0,
+        1, 0, 0, 0, 1,
+        1, 1, 1, 1, 1,
+        1, 0, 0, 0, 1,
+    };
+    
+    u32 mask_size  = 128;
+    u32 field_size = 24;
+    u32 view_size  = 512;
+    f32 spread     = 2.0f;
+    
+    Image_u32 mask = make_glyph_mask(glyph, mask_size, mask_size);
+    
+    Shape shape = shape_from_mask(&mask);
+    color_shape_edges(&shape, 3.0f);
+    
+    // NOTE: Leave a margin so the field has room to fall off around the glyph.
+    f32 margin = 4.0f;
+    f32 scale  = ((f32)field_size - 2.0f*margin) / (f32)mask_size;
+    Image_u32 msdf = produce_multi_channel_distance_field(&shape, field_size, field_size, scale, v2(margin, margin), spread);
+    
+    // NOTE: The alpha channel is the plain true distance field, so it doubles as the single channel reference.
+    Image_u32 sdf = clone_image(&msdf);
+    for (u32 y = 0; y < sdf.height; ++y) {
+        for (u32 x = 0; x < sdf.width; ++x) {
+            u8 value = (Color_ARGB) { .argb = get_pixel(&sdf, x, y) }.a;
+            set_pixel(&sdf, x, y, rgb(value, value, value));
         }
-        rasterize_triangle(image, screen_coords[0], screen_coords[1], screen_coords[2], rgb(rand() % 255,
-                                                                                            rand() % 255,
-                                                                                            rand() % 255));
+    }
+    
+    Image_u32 msdf_view = render_distance_field_preview(&msdf, true,  spread, view_size, view_size);
+    Image_u32 sdf_view  = render_distance_field_preview(&sdf,  false, spread, view_size, view_size);
+    write_image("multi_channel_distance_field.bmp", &msdf);
+    write_image("multi_channel_distance_field_view.bmp", &msdf_view);
+    write_image("single_channel_distance_field_view.bmp", &sdf_view);
+    
+    free_shape(&shape);
+    free_image(&mask);
+    free_image(&msdf);
+    free_image(&sdf);
+    free_image(&msdf_view);
+    free_image(&sdf_view);
+}
+
+// NOTE: With a clear mask, only the tiles the last frame drew to get cleared.
+function
+void draw_turntable_frame(Image_u32* image, Tile_Clear_Mask* clear_mask, u32 frame_index, u32 frame_count) {
+    if (clear_mask) {
+        fast_clear_image(image, clear_mask, rgb(0, 0, 0));
+    } else {
+        clear_image(image, rgb(0, 0, 0));
+    }
+    
+    f32 angle = 2.0f*3.14159265f*(f32)frame_index / (f32)frame_count;
+    V2i p[3];
+    for (u32 i = 0; i < 3; ++i) {
+        f32 a = angle + 2.0f*3.14159265f*(f32)i / 3.0f;
+        p[i] = (V2i) { (s32)(256.0f + 200.0f*cosf(a)), (s32)(256.0f + 200.0f*sinf(a)) };
+    }
+    rasterize_triangle(image, p[0], p[1], p[2], rgb(255, 128, 0));
+    
+    if (clear_mask) {
+        s32 min_x = Min(p[0].x, Min(p[1].x, p[2].x));
+        s32 min_y = Min(p[0].y, Min(p[1].y, p[2].y));
+        s32 max_x = Max(p[0].x, Max(p[1].x, p[2].x));
+        s32 max_y = Max(p[0].y, Max(p[1].y, p[2].y));
+        mark_touched(clear_mask, min_x, min_y, max_x - min_x + 1, max_y - min_y + 1);
     }
 }
 
 function
-u32 u32_log2(u32 n) {
-    // https://stackoverflow.com/questions/994593/how-to-do-an-integer-log2-in-c
-#define S(k) if (n >= (1 << k)) { i += k; n >>= k; }
-    u32 i = -(n == 0);
-    S(16); S(8); S(4); S(2); S(1);
-    return i;
-#undef S
+void frame_writer_test(void) {
+    u32 frame_count = 60;
+    
+    Frame_Writer writer;
+    begin_frame_writer(&writer, 512, 512, 2);
+    
+    for (u32 frame_index = 0; frame_index < frame_count; ++frame_index) {
+        Image_u32 image = acquire_frame(&writer);
+        draw_turntable_frame(&image, 0, frame_index, frame_count);
+        
+        char file_name[64];
+        snprintf(file_name, sizeof(file_name), "frame_%03u.bmp", frame_index);
+        submit_frame(&writer, file_name, &image);
+    }
+    
+    end_frame_writer(&writer);
+    print_frame_writer_stats(&writer.stats);
 }
 
-typedef enum DistanceFieldType {
-    DistanceField_Outer,
-    DistanceField_Inner,
-} DistanceFieldType;
+// NOTE: Three overlapping translucent triangles per blend mode, each mode in its own quadrant.
+function
+void blend_test(void) {
+    Image_u32 image = allocate_image(512, 512);
+    clear_image(&image, rgb(96, 96, 96));
+    
+    BlendMode modes[] = { BlendMode_Replace, BlendMode_Over, BlendMode_Add, BlendMode_Multiply };
+    for (u32 mode_index = 0; mode_index < ArrayCount(modes); ++mode_index) {
+        Image_u32 quadrant = get_sub_image(&image, 256*(mode_index % 2), 256*(mode_index / 2), 256, 256);
+        for (u32 i = 0; i < 3; ++i) {
+            s32 dx = 40*(s32)i;
+            rasterize_triangle(&quadrant, v2i(16 + dx, 32), v2i(136 + dx, 32), v2i(76 + dx, 224),
+                               rgba(255, 255, 255, 160), modes[mode_index]);
+        }
+    }
+    
+    write_image("blend_modes.png", &image, ImageFormat_PNG);
+    free_image(&image);
+}
 
+// NOTE: Three overlapping colored lights, added up in linear light and resolved to sRGB.
+// Where they overlap they go past 1 and clip to white instead of wrapping or going muddy.
 function
-Image_u32 produce_distance_field(Image_u32* src, u32 bullshit_multiplier, DistanceFieldType type) {
-    Image_u32 image_a = allocate_image(src->width, src->height);
-    Image_u32 image_b = allocate_image(src->width, src->height);
+void hdr_test(void) {
+    u32 width  = 1024;
+    u32 height = 1024;
+    
+    Image_V4  light = allocate_image_v4(width, height);
+    Image_u32 image = allocate_image(width, height);
     
-    Image_u32* image_read  = &image_a;
-    Image_u32* image_write = &image_b;
+    V2 centers[] = { v2(400.0f, 600.0f), v2(624.0f, 600.0f), v2(512.0f, 400.0f) };
+    V4 colors[]  = { v4(2.0f, 0.1f, 0.1f, 0.0f), v4(0.1f, 2.0f, 0.1f, 0.0f), v4(0.1f, 0.1f, 2.0f, 0.0f) };
     
-    for (u32 y = 0; y < image_read->height; ++y) {
-        for (u32 x = 0; x < image_read->width; ++x) {
-            Color_ARGB pixel = (Color_ARGB) { .argb = get_pixel(src, x, y) };
-            if (((type == DistanceField_Outer) && (pixel.a > 127)) ||
-                ((type == DistanceField_Inner) && (pixel.a <= 127)))
-            {
-                set_pixel(image_read, x, y, (Color_ARGB) { .bg = x, .ra = y });
+    clear_image(&light, v4(0.0f, 0.0f, 0.0f, 1.0f));
+    for (u32 light_index = 0; light_index < ArrayCount(centers); ++light_index) {
+        for (u32 y = 0; y < height; ++y) {
+            for (u32 x = 0; x < width; ++x) {
+                V2 d = v2((f32)x, (f32)y) - centers[light_index];
+                f32 falloff = 1.0f / (1.0f + dot(d, d)*(1.0f / 4096.0f));
+                blend_pixel(&light, x, y, colors[light_index]*falloff, BlendMode_Add);
             }
         }
     }
     
-    u32 N = Max(src->width, src->height);
-    u32 N_log2 = u32_log2(N);
-    for (u32 pass_index = 0; pass_index < N_log2; ++pass_index) {
-        s32 offset = (s32)(1 << (N_log2 - pass_index - 1));
-        
-        V2i pairs[] = {
-            { -offset, -offset }, { 0, -offset }, { offset, -offset },
-            { -offset, 0       }, { 0, 0       }, { offset, 0       },
-            { -offset, offset  }, { 0, offset  }, { offset, offset  },
-        };
+    Job_Pool pool;
+    create_job_pool(&pool, 0);
+    
+    u32 iterations = 16;
+    f64 start_time = get_time_seconds();
+    for (u32 i = 0; i < iterations; ++i) {
+        resolve_image(&pool, &light, &image);
+    }
+    f64 seconds = (get_time_seconds() - start_time) / (f64)iterations;
+    printf("hdr resolve %ux%u: %.3f ms\n", width, height, 1000.0*seconds);
+    
+    write_image("hdr_lights.png", &image, ImageFormat_PNG);
+    
+    destroy_job_pool(&pool);
+    free_image(&image);
+    free_image(&light);
+}
+
+// NOTE: A textured floor running from behind the camera off into the distance, so it gets
+// clipped by the near plane, and the texture has to drop down the mips towards the horizon.
+// Shaded four pixels at a time, with one LOD per batch.
+function
+void perspective_test(void) {
+    Image_u32 image = allocate_image(512, 512);
+    clear_image(&image, rgb(40, 40, 60));
+    
+    Image_u32 checker = allocate_image(64, 64);
+    for (u32 y = 0; y < checker.height; ++y) {
+        for (u32 x = 0; x < checker.width; ++x) {
+            b32 odd = ((x >> 3) + (y >> 3)) & 1;
+            set_pixel(&checker, x, y, odd ? rgb(230, 230, 230) : rgb(200, 60, 30));
+        }
+    }
+    
+    Texture texture;
+    create_texture(&texture, &checker);
+    free_image(&checker);
+    
+    M4x4 projection = m4x4_perspective(60.0f*DEG_TO_RAD, (f32)image.width / (f32)image.height, 0.1f, 100.0f);
+    M4x4 view = m4x4_translation(v3(0.0f, -1.0f, 0.0f));
+    M4x4 view_projection = m4x4_mul(projection, view);
+    
+    V3 corners[4] = { v3(-4.0f, 0.0f, 2.0f), v3(4.0f, 0.0f, 2.0f), v3(4.0f, 0.0f, -40.0f), v3(-4.0f, 0.0f, -40.0f) };
+    V2 uvs[4]     = { v2(0.0f, 0.0f), v2(8.0f, 0.0f), v2(8.0f, 42.0f), v2(0.0f, 42.0f) };
+    
+    Raster_Vertex vertices[4] = {};
+    for (u32 i = 0; i < 4; ++i) {
+        vertices[i].position = m4x4_transform_v4(view_projection, v4(corners[i].x, corners[i].y, corners[i].z, 1.0f));
+        vertices[i].varyings[0] = uvs[i].x;
+        vertices[i].varyings[1] = uvs[i].y;
+    }
+    
+    u32 triangles[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+    for (u32 triangle_index = 0; triangle_index < ArrayCount(triangles); ++triangle_index) {
+        u32* t = triangles[triangle_index];
         
-        for (u32 y = 0; y < image_read->height; ++y) {
-            for (u32 x = 0; x < image_read->width; ++x) {
-                u32 closest_distance = UINT32_MAX;
-                u32 closest_x = UINT32_MAX;
-                u32 closest_y = UINT32_MAX;
-                
-                for (u32 pair_index = 0; pair_index < 9; ++pair_index) {
-                    s32 read_x = (s32)x + pairs[pair_index].x;
-                    s32 read_y = (s32)y + pairs[pair_index].y;
-                    if (read_x < 0)                        { read_x = 0; }
-                    if (read_x >= (s32)image_read->width)  { read_x = image_read->width - 1; }
-                    if (read_y < 0)                        { read_y = 0; }
-                    if (read_y >= (s32)image_read->height) { read_y = image_read->height - 1; }
-                    
-                    Color_ARGB pixel = { .argb = get_pixel(image_read, read_x, read_y) };
-                    if (pixel.bg || pixel.ra) {
-                        s32 diff_x = (s32)pixel.bg - (s32)x;
-                        s32 diff_y = (s32)pixel.ra - (s32)y;
-                        u32 distance_sq = diff_x*diff_x + diff_y*diff_y;
-                        if (closest_distance > distance_sq) {
-                            closest_distance = distance_sq;
-                            closest_x = pixel.bg;
-                            closest_y = pixel.ra;
+        Raster_Vertex clipped[4];
+        u32 clipped_count = clip_to_near_plane(&vertices[t[0]], &vertices[t[1]], &vertices[t[2]], 2, clipped);
+        for (u32 i = 2; i < clipped_count; ++i) {
+            Triangle_Setup setup;
+            if (setup_triangle(&setup, &clipped[0], &clipped[i - 1], &clipped[i], 2, image.width, image.height)) {
+                for (s32 y = setup.bounds.min.y; y < setup.bounds.max.y; ++y) {
+                    s32 span_begin, span_end;
+                    if (get_span(&setup, y, &span_begin, &span_end)) {
+                        Varying_Stepper stepper;
+                        begin_varyings(&stepper, &setup, span_begin, y);
+                        for (s32 x = span_begin; x < span_end; x += 4) {
+                            f32 lod = get_texture_lod(&texture, get_varying_gradient(&stepper, &setup, 0),
+                                                      get_varying_gradient(&stepper, &setup, 1));
+                            
+                            f32 u[4] = {};
+                            f32 v[4] = {};
+                            u32 count = Min(span_end - x, 4);
+                            for (u32 lane = 0; lane < count; ++lane) {
+                                f32 uv[2];
+                                get_varyings(&stepper, uv);
+                                u[lane] = uv[0];
+                                v[lane] = uv[1];
+                                step_varyings(&stepper, &setup);
+                            }
+                            
+                            u32 texels[4];
+                            _mm_storeu_si128((__m128i*)texels, sample_texture(&texture, _mm_loadu_ps(u), _mm_loadu_ps(v), lod, TextureFilter_Bilinear));
+                            memcpy(get_pixel_pointer(&image, x, y), texels, sizeof(u32)*count);
                         }
                     }
                 }
-                
-                if ((closest_x != UINT32_MAX) &&
-                    (closest_y != UINT32_MAX))
-                {
-                    set_pixel(image_write, x, y, (Color_ARGB) { .bg = closest_x, .ra = closest_y });
-                }
             }
         }
-        
-        copy_image(image_write, image_read);
-        Swap(image_read, image_write);
-    }
-    
-    for (u32 y = 0; y < image_read->height; ++y) {
-        for (u32 x = 0; x < image_read->width; ++x) {
-            Color_ARGB pixel = { .argb = get_pixel(image_read, x, y) };
-            s32 diff_x = (s32)pixel.bg - (s32)x;
-            s32 diff_y = (s32)pixel.ra - (s32)y;
-            u32 distance_sq = diff_x*diff_x + diff_y*diff_y;
-            f32 distance = sqrt((f32)distance_sq);
-            s32 write_distance = bullshit_multiplier*(u32)(255*(distance / (f32)N));
-            if (write_distance < 0)   { write_distance = 0; }
-            if (write_distance > 255) { write_distance = 255; }
-            write_distance = (255 - write_distance);
-            set_pixel(image_write, x, y, rgb(write_distance, write_distance, write_distance));
+    }
+    
+    write_image("perspective_floor.png", &image, ImageFormat_PNG);
+    free_texture(&texture);
+    free_image(&image);
+}
+
+// NOTE: A fan of lines in each style, a few running off the edges.
+function
+void line_test(void) {
+    Image_u32 image = allocate_image(512, 512);
+    clear_image(&image, rgb(255, 255, 255));
+    
+    f32 widths[4] = { 1.0f, 1.0f, 3.0f, 3.0f };
+    LineStyle styles[4] = { LineStyle_Aliased, LineStyle_AntiAliased, LineStyle_Aliased, LineStyle_AntiAliased };
+    for (u32 quadrant = 0; quadrant < 4; ++quadrant) {
+        V2 center = v2(128.0f + 256.0f*(f32)(quadrant & 1), 128.0f + 256.0f*(f32)(quadrant >> 1));
+        for (u32 i = 0; i < 24; ++i) {
+            f32 angle = (f32)i*(TAU_32 / 24.0f);
+            V2 end = center + v2(cosf(angle), sinf(angle))*((i & 1) ? 100.0f : 180.0f);
+            draw_line(&image, center, end, widths[quadrant], rgb(20, 20, 80), styles[quadrant]);
         }
     }
     
-    free_image(image_read);
+    write_image("lines.png", &image, ImageFormat_PNG);
+    free_image(&image);
+}
 
-    Image_u32 result = *image_write;
-    return result;
+function
+void mesh_test(void) {
+    String_u8 obj = read_entire_file("african_head.obj", false);
+    Mesh mesh;
+    if (!obj.data || !parse_obj(obj, &mesh)) {
+        return;
+    }
+    
+    Image_u32 image = allocate_image(800, 800);
+    clear_image(&image, rgb(40, 40, 60));
+    Image_f32 depth = allocate_image_f32(image.width, image.height);
+    clear_image(&depth, 1.0f);
+    
+    Render_Target target = {};
+    target.color = &image;
+    target.depth = &depth;
+    
+    // NOTE: Without the diffuse map it's drawn untextured.
+    Texture texture;
+    Texture* diffuse = 0;
+    Loaded_Image loaded;
+    if (read_image("african_head_diffuse.tga", &loaded)) {
+        create_texture(&texture, &loaded.image);
+        free_loaded_image(&loaded);
+        diffuse = &texture;
+    }
+    
+    M4x4 projection = m4x4_perspective(40.0f*DEG_TO_RAD, (f32)image.width / (f32)image.height, 0.1f, 100.0f);
+    M4x4 view = m4x4_translation(v3(0.0f, 0.0f, -3.0f));
+    M4x4 model = m4x4_y_rotation(20.0f*DEG_TO_RAD);
+    M4x4 model_view_projection = m4x4_mul(projection, m4x4_mul(view, model));
+    
+    f64 start_time = get_time_seconds();
+    draw_mesh(&target, &mesh, model_view_projection, diffuse);
+    f64 forward_time = get_time_seconds() - start_time;
+    write_image("african_head.png", &image, ImageFormat_PNG);
+    
+    // NOTE: Should come out the same, with each pixel shaded once.
+    Job_Pool pool;
+    create_job_pool(&pool, 0);
+    Visibility_Buffer visibility = allocate_visibility_buffer(image.width, image.height);
+    clear_image(&image, rgb(40, 40, 60));
+    
+    start_time = get_time_seconds();
+    draw_mesh(&visibility, &image, &pool, &mesh, model_view_projection, diffuse);
+    f64 visibility_time = get_time_seconds() - start_time;
+    write_image("african_head_visibility.png", &image, ImageFormat_PNG);
+    
+    Multisample_Target multisample = allocate_multisample_target(image.width, image.height);
+    clear_multisample_target(&multisample, rgb(40, 40, 60), 1.0f);
+    
+    start_time = get_time_seconds();
+    draw_mesh(&multisample, &mesh, model_view_projection, diffuse);
+    resolve_multisample_target(&pool, &multisample, &image);
+    f64 multisample_time = get_time_seconds() - start_time;
+    write_image("african_head_msaa.png", &image, ImageFormat_PNG);
+    
+    printf("mesh: forward %.2fms, visibility buffer %.2fms, %ux msaa %.2fms\n", forward_time*1000.0,
+           visibility_time*1000.0, MSAA_SAMPLE_COUNT, multisample_time*1000.0);
+    
+    // NOTE: The wireframe over the top, each shared edge drawn once.
+    Mesh_Edges edges = build_mesh_edges(&mesh);
+    start_time = get_time_seconds();
+    draw_mesh_wireframe(&image, &mesh, &edges, model_view_projection, 1.0f, premultiply(rgba(0, 0, 0, 160)), LineStyle_AntiAliased);
+    f64 wireframe_time = get_time_seconds() - start_time;
+    write_image("african_head_wireframe.png", &image, ImageFormat_PNG);
+    printf("mesh: %u edges of %u triangles, wireframe %.2fms\n", edges.edge_count, mesh.triangle_count, wireframe_time*1000.0);
+    free_mesh_edges(&edges);
+    
+    free_multisample_target(&multisample);
+    free_visibility_buffer(&visibility);
+    destroy_job_pool(&pool);
+    if (diffuse) {
+        free_texture(diffuse);
+    }
+    free_image(&depth);
+    free_image(&image);
+    free(obj.data);
 }
 
+// NOTE: The head standing over a floor, shadowed by a light up and to the left. The camera pass
+// lays down depth first, so the shadowed pipelines only shade what ends up visible.
 function
-Image_u32 produce_signed_distance_field(Image_u32* src, u32 bullshit_multiplier) {
-    Image_u32 positive_distance_field = produce_distance_field(src, 8, DistanceField_Outer);
-    Image_u32 negative_distance_field = produce_distance_field(src, 8, DistanceField_Inner);
+void shadow_test(void) {
+    String_u8 obj = read_entire_file("african_head.obj", false);
+    Mesh head;
+    if (!obj.data || !parse_obj(obj, &head)) {
+        return;
+    }
     
-    for (u32 y = 0; y < positive_distance_field.height; ++y) {
-        for (u32 x = 0; x < positive_distance_field.width; ++x) {
-            u8 positive = (Color_ARGB) { .argb = get_pixel(&positive_distance_field, x, y) }.r;
-            u8 negative = (Color_ARGB) { .argb = get_pixel(&negative_distance_field, x, y) }.r;
-            u8 combined = (255 - positive) / 2 + negative / 2;
-            // NOTE: We're overwriting the contents of positive_distance_field, but this is fine because we're not reading from this position again
-            set_pixel(&positive_distance_field, x, y, (Color_ARGB) { .r = combined, .g = combined, .b = combined, .a = 255 });
-        }
+    f32 floor_size = 2.5f;
+    f32 floor_y = -0.9f;
+    V3 floor_vertices[] = {
+        v3(-floor_size, floor_y, -floor_size),
+        v3(-floor_size, floor_y,  floor_size),
+        v3( floor_size, floor_y,  floor_size),
+        v3( floor_size, floor_y, -floor_size),
+    };
+    Triangle floor_triangles[] = { { { 0, 1, 2 } }, { { 0, 2, 3 } } };
+    Mesh floor = {};
+    floor.vertex_count   = ArrayCount(floor_vertices);
+    floor.vertices       = floor_vertices;
+    floor.triangle_count = ArrayCount(floor_triangles);
+    floor.triangles      = floor_triangles;
+    compute_mesh_bounds(&floor);
+    
+    Texture texture;
+    Texture* diffuse = 0;
+    Loaded_Image loaded;
+    if (read_image("african_head_diffuse.tga", &loaded)) {
+        create_texture(&texture, &loaded.image);
+        free_loaded_image(&loaded);
+        diffuse = &texture;
     }
+    
+    M4x4 head_model  = m4x4_y_rotation(20.0f*DEG_TO_RAD);
+    M4x4 floor_model = m4x4_identity();
+    
+    // NOTE: The sphere has to take in the floor's corners as well as the head.
+    f64 start_time = get_time_seconds();
+    Shadow_Map shadow_map = allocate_shadow_map(1024, v3(-0.6f, 1.0f, 0.5f), v3(0.0f, 0.0f, 0.0f), 3.7f);
+    clear_shadow_map(&shadow_map);
+    render_shadow_map(&shadow_map, &head,  head_model);
+    render_shadow_map(&shadow_map, &floor, floor_model);
+    f64 shadow_time = get_time_seconds() - start_time;
+    
+    Image_u32 image = allocate_image(800, 800);
+    clear_image(&image, rgb(40, 40, 60));
+    Image_f32 depth = allocate_image_f32(image.width, image.height);
+    clear_image(&depth, 1.0f);
+    
+    Render_Target target = {};
+    target.color = &image;
+    target.depth = &depth;
+    
+    M4x4 projection = m4x4_perspective(40.0f*DEG_TO_RAD, (f32)image.width / (f32)image.height, 0.1f, 100.0f);
+    M4x4 view = m4x4_look_at(v3(0.0f, 1.5f, 4.0f), v3(0.0f, -0.3f, 0.0f), v3(0.0f, 1.0f, 0.0f));
+    M4x4 view_projection = m4x4_mul(projection, view);
+    
+    start_time = get_time_seconds();
+    draw_mesh_depth(&depth, &head,  m4x4_mul(view_projection, head_model));
+    draw_mesh_depth(&depth, &floor, m4x4_mul(view_projection, floor_model));
+    f64 prepass_time = get_time_seconds() - start_time;
+    
+    start_time = get_time_seconds();
+    draw_mesh(&target, &head,  head_model,  view_projection, diffuse, &shadow_map);
+    draw_mesh(&target, &floor, floor_model, view_projection, 0,       &shadow_map);
+    f64 shade_time = get_time_seconds() - start_time;
+    write_image("shadows.png", &image, ImageFormat_PNG);
+    
+    printf("shadows: %ux%u shadow map %.2fms, depth prepass %.2fms, shading %.2fms\n", shadow_map.depth.width,
+           shadow_map.depth.height, shadow_time*1000.0, prepass_time*1000.0, shade_time*1000.0);
+    
+    free_shadow_map(&shadow_map);
+    if (diffuse) {
+        free_texture(diffuse);
+    }
+    free_image(&depth);
+    free_image(&image);
+    free(obj.data);
+}
 
-    free_image(&negative_distance_field);
+// NOTE: A field of heads, a lot of them off screen, drawn one by one and then instanced. The
+// two should match exactly.
+function
+void instancing_test(void) {
+    String_u8 obj = read_entire_file("african_head.obj", false);
+    Mesh mesh;
+    if (!obj.data || !parse_obj(obj, &mesh)) {
+        return;
+    }
+    
+    u32 grid_size = 24;
+    u32 instance_count = grid_size*grid_size;
+    M4x4* models = (M4x4*)malloc(sizeof(M4x4)*instance_count);
+    for (u32 i = 0; i < instance_count; ++i) {
+        f32 x = 2.5f*((f32)(i % grid_size) - 0.5f*(f32)grid_size);
+        f32 z = -2.5f*(f32)(i / grid_size);
+        models[i] = m4x4_mul(m4x4_translation(v3(x, 0.0f, z)), m4x4_y_rotation((f32)i*0.7f));
+    }
+    
+    Image_u32 image = allocate_image(800, 600);
+    Image_u32 reference = allocate_image(image.width, image.height);
+    Image_f32 depth = allocate_image_f32(image.width, image.height);
+    
+    Render_Target target = {};
+    target.color = &reference;
+    target.depth = &depth;
+    
+    M4x4 projection = m4x4_perspective(60.0f*DEG_TO_RAD, (f32)image.width / (f32)image.height, 0.1f, 100.0f);
+    M4x4 view = m4x4_look_at(v3(0.0f, 3.0f, 4.0f), v3(0.0f, 0.0f, -8.0f), v3(0.0f, 1.0f, 0.0f));
+    M4x4 view_projection = m4x4_mul(projection, view);
+    
+    clear_image(&reference, rgb(40, 40, 60));
+    clear_image(&depth, 1.0f);
+    f64 start_time = get_time_seconds();
+    for (u32 i = 0; i < instance_count; ++i) {
+        draw_mesh(&target, &mesh, m4x4_mul(view_projection, models[i]), 0);
+    }
+    f64 serial_time = get_time_seconds() - start_time;
+    
+    Job_Pool pool;
+    create_job_pool(&pool, 0);
+    target.color = &image;
+    clear_image(&image, rgb(40, 40, 60));
+    clear_image(&depth, 1.0f);
+    start_time = get_time_seconds();
+    draw_mesh_instanced(&target, &pool, &mesh, view_projection, models, instance_count, 0);
+    f64 instanced_time = get_time_seconds() - start_time;
+    write_image("instances.png", &image, ImageFormat_PNG);
+    
+    u32 mismatches = 0;
+    for (u32 y = 0; y < image.height; ++y) {
+        mismatches += (memcmp(get_pixel_pointer(&image, 0, y), get_pixel_pointer(&reference, 0, y), sizeof(u32)*image.width) != 0);
+    }
+    printf("instancing: %u instances, one by one %.2fms, instanced %.2fms, %u rows differ\n", instance_count,
+           serial_time*1000.0, instanced_time*1000.0, mismatches);
+    
+    // NOTE: Again with the far heads simplified.
+    start_time = get_time_seconds();
+    Mesh_LODs lods = build_mesh_lods(&mesh, 64);
+    f64 build_time = get_time_seconds() - start_time;
+    
+    clear_image(&image, rgb(40, 40, 60));
+    clear_image(&depth, 1.0f);
+    start_time = get_time_seconds();
+    draw_mesh_instanced(&target, &pool, &lods, view_projection, models, instance_count, 0);
+    f64 lod_time = get_time_seconds() - start_time;
+    write_image("instances_lod.png", &image, ImageFormat_PNG);
+    
+    printf("instancing: %u levels of detail, down to %u triangles, built in %.2fms, drawn %.2fms\n", lods.lod_count,
+           lods.lods[lods.lod_count - 1].triangle_count, build_time*1000.0, lod_time*1000.0);
+    free_mesh_lods(&lods);
+    
+    destroy_job_pool(&pool);
+    free_image(&depth);
+    free_image(&reference);
+    free_image(&image);
+    free(models);
+    free(obj.data);
+}
 
-    return positive_distance_field;
+// NOTE: Ray casts the head through its BVH, then draws only the triangles a narrower view
+// can see, found by culling the BVH against its frustum.
+function
+void bvh_test(void) {
+    String_u8 obj = read_entire_file("african_head.obj", false);
+    Mesh mesh;
+    if (!obj.data || !parse_obj(obj, &mesh)) {
+        return;
+    }
+    
+    Job_Pool pool;
+    create_job_pool(&pool, 0);
+    f64 start_time = get_time_seconds();
+    BVH bvh = build_bvh(&mesh, &pool);
+    f64 build_time = get_time_seconds() - start_time;
+    
+    Image_u32 image = allocate_image(400, 400);
+    V3 eye = v3(0.0f, 0.0f, 3.0f);
+    V3 light_direction = normalize(v3(0.3f, 0.5f, 1.0f));
+    f32 tan_half_fov = tanf(20.0f*DEG_TO_RAD);
+    
+    u32 hit_count = 0;
+    start_time = get_time_seconds();
+    for (u32 y = 0; y < image.height; ++y) {
+        u32* row = get_pixel_pointer(&image, 0, y);
+        for (u32 x = 0; x < image.width; ++x) {
+            f32 ndc_x = 2.0f*((f32)x + 0.5f) / (f32)image.width  - 1.0f;
+            f32 ndc_y = 2.0f*((f32)y + 0.5f) / (f32)image.height - 1.0f;
+            V3 direction = normalize(v3(ndc_x*tan_half_fov, ndc_y*tan_half_fov, -1.0f));
+            
+            Color_ARGB color = rgb(40, 40, 60);
+            BVH_Hit hit;
+            if (intersect_bvh(&bvh, &mesh, eye, direction, F32_MAX, &hit)) {
+                Triangle* triangle = mesh.triangles + hit.triangle_index;
+                V3 p0 = mesh.vertices[triangle->a];
+                V3 normal = normalize(cross(mesh.vertices[triangle->b] - p0, mesh.vertices[triangle->c] - p0));
+                u8 light = (u8)(255.0f*(MESH_AMBIENT + (1.0f - MESH_AMBIENT)*Max(dot(normal, light_direction), 0.0f)));
+                color = rgb(light, light, light);
+                ++hit_count;
+            }
+            row[x] = color.argb;
+        }
+    }
+    f64 ray_time = get_time_seconds() - start_time;
+    write_image("bvh_raycast.png", &image, ImageFormat_PNG);
+    
+    printf("bvh: %u triangles, %u nodes, built in %.2fms, %u rays in %.2fms, %u hits\n", bvh.triangle_count, bvh.node_count,
+           build_time*1000.0, image.width*image.height, ray_time*1000.0, hit_count);
+    
+    // NOTE: Every 8th ray each way again, against every triangle.
+    u32 sampled_ray_count = 0;
+    u32 ray_mismatches = 0;
+    for (u32 y = 0; y < image.height; y += 8) {
+        for (u32 x = 0; x < image.width; x += 8) {
+            f32 ndc_x = 2.0f*((f32)x + 0.5f) / (f32)image.width  - 1.0f;
+            f32 ndc_y = 2.0f*((f32)y + 0.5f) / (f32)image.height - 1.0f;
+            V3 direction = normalize(v3(ndc_x*tan_half_fov, ndc_y*tan_half_fov, -1.0f));
+            
+            BVH_Hit hit;
+            b32 bvh_hit = intersect_bvh(&bvh, &mesh, eye, direction, F32_MAX, &hit);
+            
+            BVH_Hit linear_hit;
+            b32 any_linear_hit = false;
+            f32 closest = F32_MAX;
+            for (u32 i = 0; i < mesh.triangle_count; ++i) {
+                Triangle* triangle = mesh.triangles + i;
+                if (intersect_triangle(eye, direction, mesh.vertices[triangle->a], mesh.vertices[triangle->b],
+                                       mesh.vertices[triangle->c], closest, &linear_hit)) {
+                    linear_hit.triangle_index = i;
+                    closest = linear_hit.t;
+                    any_linear_hit = true;
+                }
+            }
+            
+            if (bvh_hit != any_linear_hit) {
+                ++ray_mismatches;
+            } else if (bvh_hit && ((hit.triangle_index != linear_hit.triangle_index) || (Abs(hit.t - linear_hit.t) > 1e-5f))) {
+                ++ray_mismatches;
+            }
+            ++sampled_ray_count;
+        }
+    }
+    printf("bvh: %u rays checked against every triangle, %u differ\n", sampled_ray_count, ray_mismatches);
+    
+    // NOTE: The culled triangles share the mesh's vertices and texcoords.
+    M4x4 projection = m4x4_perspective(12.0f*DEG_TO_RAD, 1.0f, 0.1f, 100.0f);
+    M4x4 view = m4x4_look_at(v3(0.0f, 0.0f, 3.0f), v3(0.2f, 0.25f, 0.0f), v3(0.0f, 1.0f, 0.0f));
+    M4x4 view_projection = m4x4_mul(projection, view);
+    Frustum frustum = make_frustum(view_projection);
+    
+    u32* visible = (u32*)malloc(sizeof(u32)*mesh.triangle_count);
+    start_time = get_time_seconds();
+    u32 visible_count = get_bvh_triangles_in_frustum(&bvh, &frustum, visible);
+    f64 cull_time = get_time_seconds() - start_time;
+    
+    Mesh culled = mesh;
+    culled.triangle_count = visible_count;
+    culled.triangles = (Triangle*)malloc(sizeof(Triangle)*(umm)Max(visible_count, 1));
+    culled.texcoord_triangles = 0;
+    if (mesh.texcoords) {
+        culled.texcoord_triangles = (Triangle*)malloc(sizeof(Triangle)*(umm)Max(visible_count, 1));
+    }
+    for (u32 i = 0; i < visible_count; ++i) {
+        culled.triangles[i] = mesh.triangles[visible[i]];
+        if (mesh.texcoords) {
+            culled.texcoord_triangles[i] = mesh.texcoord_triangles[visible[i]];
+        }
+    }
+    
+    Image_f32 depth = allocate_image_f32(image.width, image.height);
+    Render_Target target = {};
+    target.color = &image;
+    target.depth = &depth;
+    clear_image(&image, rgb(40, 40, 60));
+    clear_image(&depth, 1.0f);
+    draw_mesh(&target, &culled, view_projection, 0);
+    write_image("bvh_culled.png", &image, ImageFormat_PNG);
+    
+    // NOTE: The BVH can keep more than clipping would, but never less: anything not all outside
+    // one of the planes has to be in there.
+    u8* in_visible = (u8*)calloc(mesh.triangle_count, sizeof(u8));
+    for (u32 i = 0; i < visible_count; ++i) {
+        in_visible[visible[i]] = true;
+    }
+    u32 missing_count = 0;
+    for (u32 i = 0; i < mesh.triangle_count; ++i) {
+        Triangle* triangle = mesh.triangles + i;
+        V3 p0 = mesh.vertices[triangle->a];
+        V3 p1 = mesh.vertices[triangle->b];
+        V3 p2 = mesh.vertices[triangle->c];
+        
+        b32 outside = false;
+        for (u32 plane_index = 0; plane_index < ArrayCount(frustum.planes); ++plane_index) {
+            V4 plane = frustum.planes[plane_index];
+            if ((dot(plane.xyz, p0) + plane.w < 0.0f) && (dot(plane.xyz, p1) + plane.w < 0.0f) &&
+                (dot(plane.xyz, p2) + plane.w < 0.0f)) {
+                outside = true;
+                break;
+            }
+        }
+        missing_count += (!outside && !in_visible[i]);
+    }
+    free(in_visible);
+    
+    printf("bvh: %u of %u triangles in the frustum, culled in %.3fms, %u missing\n", visible_count, mesh.triangle_count,
+           cull_time*1000.0, missing_count);
+    
+    free(culled.texcoord_triangles);
+    free(culled.triangles);
+    free(visible);
+    free_image(&depth);
+    free_image(&image);
+    free_bvh(&bvh);
+    destroy_job_pool(&pool);
+    free(obj.data);
 }
 
+// NOTE: Pass "-" to stream to stdout, e.g. into ffmpeg -f yuv4mpegpipe -i - turntable.mp4
 function
-void voronoi_test(void) {
-    enum { N = 512 };
-    Image_u32 image_source = allocate_image(N, N);
+void frame_stream_test(char* path) {
+    u32 frame_count = 60;
     
-    char a[] = {
-        0, 0, 1, 0, 0,
-        0, 1, 0, 1, 0,
-        1, 0, 0, 0, 1,
-        1, 1, 1, 1, 1,
-        1, 0, 0, 0, 1,
+    Frame_Stream stream;
+    if (begin_frame_stream(&stream, path, FrameStreamFormat_Y4M, 512, 512, 30)) {
+        Image_u32 image = allocate_image(512, 512);
+        Tile_Clear_Mask clear_mask;
+        create_tile_clear_mask(&clear_mask, image.width, image.height);
+        for (u32 frame_index = 0; frame_index < frame_count; ++frame_index) {
+            draw_turntable_frame(&image, &clear_mask, frame_index, frame_count);
+            if (!write_frame(&stream, &image)) {
+                break;
+            }
+        }
+        free_tile_clear_mask(&clear_mask);
+        free_image(&image);
+    }
+    end_frame_stream(&stream);
+}
+
+function
+void image_reader_test(void) {
+    char* file_names[] = {
+        "frame_000.bmp",
+        "signed_distance_field_r8.bmp",
+        "signed_distance_field_r16.pgm",
     };
     
-    u32 margin = 128;
-    for (u32 y = margin; y < image_source.height - margin; ++y) {
-        for (u32 x = margin; x < image_source.width - margin; ++x) {
-            u32 read_x = 5*(x - margin) / (image_source.width - 2*margin);
-            u32 read_y = 4 - 5*(y - margin) / (image_source.height - 2*margin);
-            char read_pixel = a[read_y*5 + read_x];
-            if (read_pixel) {
-                set_pixel(&image_source, x, y, (Color_ARGB) { .a = 255 });
-            }
+    for (u32 i = 0; i < ArrayCount(file_names); ++i) {
+        Loaded_Image loaded;
+        if (read_image(file_names[i], &loaded)) {
+            printf("%s: %ux%u, %s\n", file_names[i], loaded.image.width, loaded.image.height,
+                   loaded.mapping.data ? "mapped" : "copied");
+            free_loaded_image(&loaded);
         }
     }
+    
+    // NOTE: Grayscale files load with the gray value in alpha, so the distance field can be rebuilt from one.
+    Loaded_Image mask;
+    if (read_image("signed_distance_field_r16.pgm", &mask)) {
+        Image_u8 sdf = produce_signed_distance_field_u8(&mask.image, 8.0f);
+        write_image("signed_distance_field_from_file_r8.bmp", &sdf);
+        free_image(&sdf);
+        free_loaded_image(&mask);
+    }
+}
 
-    Image_u32 sdf = produce_signed_distance_field(&image_source, 8);
-    write_image("signed_distance_field.bmp", &sdf);
+function
+void benchmark_image_format(char* label, Image_u32* image, ImageFormat format, char* file_name) {
+    u32 iterations = 8;
+    
+    f64 start_time = get_time_seconds();
+    for (u32 i = 0; i < iterations; ++i) {
+        write_image(file_name, image, format);
+    }
+    f64 seconds = (get_time_seconds() - start_time) / (f64)iterations;
+    
+    File_Mapping file;
+    umm file_size = 0;
+    if (map_file(file_name, &file)) {
+        file_size = file.size;
+        unmap_file(&file);
+    }
+    
+    f64 megabytes = (f64)get_total_pixel_size(image) / (1024.0*1024.0);
+    printf("%-6s %-16s %8.2f ms %8.1f MB/s %10llu bytes (%.1f%%)\n", label, file_name, 1000.0*seconds,
+           megabytes / seconds, (unsigned long long)file_size, 100.0*(f64)file_size / (f64)get_total_pixel_size(image));
+}
+
+function
+void image_format_benchmark(void) {
+    // NOTE: The two kinds of output that get written in bulk: rendered frames and distance field atlases.
+    Image_u32 frame = allocate_image(512, 512);
+    clear_image(&frame, rgb(0, 0, 0));
+    rasterize_triangle(&frame, (V2i) { 56, 56 }, (V2i) { 456, 156 }, (V2i) { 206, 456 }, rgb(255, 128, 0));
+    
+    benchmark_image_format("frame", &frame, ImageFormat_BMP, "benchmark.bmp");
+    benchmark_image_format("frame", &frame, ImageFormat_QOI, "benchmark.qoi");
+    benchmark_image_format("frame", &frame, ImageFormat_PNG, "benchmark.png");
+    
+    Loaded_Image atlas;
+    if (read_image("distance_field_atlas.bmp", &atlas)) {
+        benchmark_image_format("atlas", &atlas.image, ImageFormat_BMP, "benchmark.bmp");
+        benchmark_image_format("atlas", &atlas.image, ImageFormat_QOI, "benchmark.qoi");
+        benchmark_image_format("atlas", &atlas.image, ImageFormat_PNG, "benchmark.png");
+        free_loaded_image(&atlas);
+    }
+    
+    free_image(&frame);
 }
 
 #include <time.h>
@@ -336,5 +1753,20 @@ int main(int argc, char** argv) {
     write_image("test.bmp", &image);
 #else
     voronoi_test();
+    skyline_packer_test();
+    atlas_test();
+    multi_channel_distance_field_test();
+    blend_test();
+    hdr_test();
+    perspective_test();
+    line_test();
+    mesh_test();
+    shadow_test();
+    instancing_test();
+    bvh_test();
+    frame_writer_test();
+    frame_stream_test("turntable.y4m");
+    image_reader_test();
+    image_format_benchmark();
 #endif
 }
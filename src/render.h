@@ -15,6 +15,27 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <float.h>
+#include <emmintrin.h>
+
+//
+
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <signal.h>
+#endif
 
 //
 
@@ -39,7 +60,25 @@
 void* global_heap_alloc(umm size);
 void global_heap_free(void* ptr);
 
+#include "platform.h"
+#include "jobs.h"
 #include "image.h"
+#include "image_encoder.h"
+#include "image_pool.h"
+#include "tiled_image.h"
+#include "hdr_image.h"
+#include "rasterizer.h"
+#include "texture.h"
+#include "pipeline.h"
+#include "shadow.h"
+#include "frame_writer.h"
+#include "frame_stream.h"
 #include "obj.h"
+#include "simplify.h"
+#include "bvh.h"
+#include "line.h"
+#include "distance_field.h"
+#include "atlas.h"
+#include "msdf.h"
 
 #endif //RENDER_H
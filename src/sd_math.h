@@ -497,6 +497,12 @@ SD_MATH_API f32 dot(V2 a, V2 b) {
     return a.x*b.x + a.y*b.y;
 }
 
+// @Note: The z of the 3D cross product, positive if b is counter-clockwise from a.
+SD_MATH_OVERLOAD
+SD_MATH_API f32 cross(V2 a, V2 b) {
+    return a.x*b.y - a.y*b.x;
+}
+
 SD_MATH_OVERLOAD
 SD_MATH_API V2 reflect(V2 a, V2 b) {
     f32 dot2 = 2.0f*dot(a, b);
@@ -1687,7 +1693,7 @@ SD_MATH_API V4 clamp(V4 n, f32 lo, f32 hi) {
 //
 
 SD_MATH_API M4x4 m4x4_mul(M4x4 a, M4x4 b) {
-    M4x4 result;
+    M4x4 result = {};
     for (int r = 0; r < 4; ++r) {
         for (int c = 0; c < 4; ++c) {
             for (int i = 0; i < 4; ++i) {
@@ -1761,4 +1767,77 @@ SD_MATH_API M4x4 m4x4_z_rotation(f32 angle) {
     return result;
 }
 
+SD_MATH_API M4x4 m4x4_translation(V3 t) {
+    M4x4 result = {
+        {
+            { 1, 0, 0, t.x, },
+            { 0, 1, 0, t.y, },
+            { 0, 0, 1, t.z, },
+            { 0, 0, 0, 1,   },
+        }
+    };
+    return result;
+}
+
+SD_MATH_API M4x4 m4x4_scale(V3 s) {
+    M4x4 result = {
+        {
+            { s.x, 0,   0,   0, },
+            { 0,   s.y, 0,   0, },
+            { 0,   0,   s.z, 0, },
+            { 0,   0,   0,   1, },
+        }
+    };
+    return result;
+}
+
+// @Note: Right handed, looking down -z. Depth goes from 0 at the near plane to w at the far
+// plane, so after the divide z is in [0, 1].
+SD_MATH_API M4x4 m4x4_perspective(f32 vertical_fov, f32 aspect, f32 near_z, f32 far_z) {
+    f32 f = SD_MATH_COS(0.5f*vertical_fov) / SD_MATH_SIN(0.5f*vertical_fov);
+    f32 range = 1.0f / (near_z - far_z);
+    M4x4 result = {
+        {
+            { f / aspect, 0, 0,             0,                    },
+            { 0,          f, 0,             0,                    },
+            { 0,          0, far_z*range,   near_z*far_z*range,   },
+            { 0,          0, -1,            0,                    },
+        }
+    };
+    return result;
+}
+
+// @Note: The same conventions as m4x4_perspective, for a box from (left, bottom, -near_z) to
+// (right, top, -far_z). w stays 1.
+SD_MATH_API M4x4 m4x4_orthographic(f32 left, f32 right, f32 bottom, f32 top, f32 near_z, f32 far_z) {
+    f32 width  = 1.0f / (right - left);
+    f32 height = 1.0f / (top - bottom);
+    f32 range  = 1.0f / (near_z - far_z);
+    M4x4 result = {
+        {
+            { 2.0f*width, 0,           0,     -(right + left)*width,  },
+            { 0,          2.0f*height, 0,     -(top + bottom)*height, },
+            { 0,          0,           range, near_z*range,           },
+            { 0,          0,           0,     1,                      },
+        }
+    };
+    return result;
+}
+
+// @Note: A right handed view matrix, eye at the origin looking down -z with up along +y.
+SD_MATH_API M4x4 m4x4_look_at(V3 eye, V3 target, V3 up) {
+    V3 f = normalize(target - eye);
+    V3 s = normalize(cross(f, up));
+    V3 u = cross(s, f);
+    M4x4 result = {
+        {
+            { s.x,  s.y,  s.z,  -dot(s, eye), },
+            { u.x,  u.y,  u.z,  -dot(u, eye), },
+            { -f.x, -f.y, -f.z, dot(f, eye),  },
+            { 0,    0,    0,    1,            },
+        }
+    };
+    return result;
+}
+
 #endif /* SD_MATH_H */
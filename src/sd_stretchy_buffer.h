@@ -26,6 +26,11 @@
 #define SD_SB_REALLOC(old_ptr, size) realloc(old_ptr, size)
 #endif
 
+#ifndef SD_SB_FREE
+#include <stdlib.h>
+#define SD_SB_FREE(ptr) free(ptr)
+#endif
+
 typedef struct Buffer_Header {
     size_t len;
     size_t cap;
@@ -42,7 +47,8 @@ typedef struct Buffer_Header {
 #define buf_push_ptr(b) (buf__fit(b, 1), (b) + buf__hdr(b)->len++)
 #define buf_push_array(b, n) (buf__fit(b, n), buf__hdr(b)->len += (n), (b) + buf_len(b) - (n))
 #define buf_end(b) ((b) + buf_len(b))
-#define buf_free(b) ((b) ? (SD_SB_REALLOC(buf__hdr(b), 0), (b) = 0) : 0)
+#define buf_clear(b) ((b) ? (buf__hdr(b)->len = 0) : 0)
+#define buf_free(b) ((b) ? (SD_SB_FREE(buf__hdr(b)), (b) = 0) : 0)
 
  SD_SB_API void* buf__grow(void* buf, umm new_len, umm elem_size) {
     SD_SB_ASSERT(buf_cap(buf) <= (SIZE_MAX - 1) / 2);
@@ -0,0 +1,97 @@
+//
+// NOTE: Shadow maps
+//
+
+// NOTE: Fits the light's view around a bounding sphere of everything that casts or receives
+// shadows. Render into it with render_shadow_map after clear_shadow_map.
+function
+Shadow_Map allocate_shadow_map(u32 size, V3 light_direction, V3 center, f32 radius) {
+    Shadow_Map result = {};
+    result.depth = allocate_image_f32(size, size);
+    result.light_direction = normalize(light_direction);
+    
+    V3 up = (Abs(result.light_direction.y) > 0.99f) ? v3(1.0f, 0.0f, 0.0f) : v3(0.0f, 1.0f, 0.0f);
+    M4x4 view = m4x4_look_at(center + result.light_direction*(2.0f*radius), center, up);
+    M4x4 projection = m4x4_orthographic(-radius, radius, -radius, radius, radius, 3.0f*radius);
+    result.light_view_projection = m4x4_mul(projection, view);
+    
+    // NOTE: About two texels worth of depth at 45 degrees, since a texel is 2*radius / size
+    // across and the depth range is 2*radius deep.
+    result.bias = 2.0f / (f32)size;
+    
+    return result;
+}
+
+function
+void free_shadow_map(Shadow_Map* map) {
+    free_image(&map->depth);
+    memset(map, 0, sizeof(*map));
+}
+
+function
+void clear_shadow_map(Shadow_Map* map) {
+    clear_image(&map->depth, 1.0f);
+}
+
+// NOTE: How lit four points are, from 0 in shadow to 1, given their light space clip
+// positions and the cosine between their normal and the light. Each lane tests a 4x4 block of
+// texels around its point, weighted as the sum of three bilinear taps a texel apart, so the
+// result moves smoothly as the point does. Points outside the map are lit.
+function
+__m128 sample_shadow_map(Shadow_Map* map, __m128 x, __m128 y, __m128 z, __m128 w, __m128 n_dot_l) {
+    __m128 one  = _mm_set1_ps(1.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 one_over_w = _mm_div_ps(one, w);
+    __m128 ndc_x = _mm_mul_ps(x, one_over_w);
+    __m128 ndc_y = _mm_mul_ps(y, one_over_w);
+    __m128 depth = _mm_mul_ps(z, one_over_w);
+    
+    __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(abs_ps(ndc_x), one), _mm_cmple_ps(abs_ps(ndc_y), one)),
+                               _mm_cmple_ps(depth, one));
+    
+    // NOTE: The bias grows with the tangent of the angle to the light, which is how fast depth
+    // changes across a texel.
+    __m128 cosine  = _mm_max_ps(n_dot_l, _mm_set1_ps(0.05f));
+    __m128 tangent = _mm_div_ps(_mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, _mm_mul_ps(cosine, cosine)), _mm_setzero_ps())), cosine);
+    __m128 reference = _mm_sub_ps(depth, _mm_mul_ps(_mm_set1_ps(map->bias), _mm_add_ps(one, tangent)));
+    
+    // NOTE: In texels, with texel centers on whole numbers.
+    __m128 u = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(ndc_x, half), half), _mm_set1_ps((f32)map->depth.width)),  half);
+    __m128 v = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(ndc_y, half), half), _mm_set1_ps((f32)map->depth.height)), half);
+    __m128 base_u = floor_ps(u);
+    __m128 base_v = floor_ps(v);
+    __m128 fraction_u = _mm_sub_ps(u, base_u);
+    __m128 fraction_v = _mm_sub_ps(v, base_v);
+    
+    __m128 third = _mm_set1_ps(1.0f / 3.0f);
+    __m128 weights_u[4] = { _mm_mul_ps(_mm_sub_ps(one, fraction_u), third), third, third, _mm_mul_ps(fraction_u, third) };
+    __m128 weights_v[4] = { _mm_mul_ps(_mm_sub_ps(one, fraction_v), third), third, third, _mm_mul_ps(fraction_v, third) };
+    
+    // NOTE: Lanes outside the map still do the lookups, clamped, and get thrown away.
+    s32 texel_u[4];
+    s32 texel_v[4];
+    _mm_storeu_si128((__m128i*)texel_u, _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(base_u, _mm_set1_ps(-1.0f)), _mm_set1_ps((f32)map->depth.width))));
+    _mm_storeu_si128((__m128i*)texel_v, _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(base_v, _mm_set1_ps(-1.0f)), _mm_set1_ps((f32)map->depth.height))));
+    
+    s32 max_u = (s32)map->depth.width  - 1;
+    s32 max_v = (s32)map->depth.height - 1;
+    __m128 lit = _mm_setzero_ps();
+    for (s32 offset_v = 0; offset_v < 4; ++offset_v) {
+        f32* rows[4];
+        for (u32 lane = 0; lane < 4; ++lane) {
+            rows[lane] = get_pixel_pointer(&map->depth, 0, Clamp(texel_v[lane] + offset_v - 1, 0, max_v));
+        }
+        
+        for (s32 offset_u = 0; offset_u < 4; ++offset_u) {
+            __m128 stored = _mm_setr_ps(rows[0][Clamp(texel_u[0] + offset_u - 1, 0, max_u)],
+                                        rows[1][Clamp(texel_u[1] + offset_u - 1, 0, max_u)],
+                                        rows[2][Clamp(texel_u[2] + offset_u - 1, 0, max_u)],
+                                        rows[3][Clamp(texel_u[3] + offset_u - 1, 0, max_u)]);
+            __m128 weight = _mm_mul_ps(weights_u[offset_u], weights_v[offset_v]);
+            lit = _mm_add_ps(lit, _mm_and_ps(_mm_cmple_ps(reference, stored), weight));
+        }
+    }
+    
+    __m128 result = _mm_or_ps(_mm_and_ps(inside, lit), _mm_andnot_ps(inside, one));
+    return result;
+}
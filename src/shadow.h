@@ -0,0 +1,25 @@
+/* date = October 19th 2026 11:05 pm */
+
+#ifndef SHADOW_H
+#define SHADOW_H
+
+//
+// NOTE: Shadow maps for a directional light. The map is a depth buffer rendered from the
+// light with a depth only pipeline. Shading looks a point up in it with percentage closer
+// filtering: the depth test is done per texel, then the results are filtered, which gives a
+// soft edge about three texels wide instead of blocky steps.
+//
+
+typedef struct Shadow_Map {
+    Image_f32 depth;
+    
+    V3 light_direction; // NOTE: Towards the light
+    M4x4 light_view_projection;
+    
+    // NOTE: Pulls the points being tested towards the light, so a surface doesn't shadow itself
+    // with its own rounding errors. In depth units, and scaled up where the surface is at a
+    // grazing angle to the light.
+    f32 bias;
+} Shadow_Map;
+
+#endif //SHADOW_H
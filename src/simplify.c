@@ -0,0 +1,597 @@
+//
+// NOTE: Quadrics
+//
+
+// NOTE: A sum of squared distances to planes, error(p) = p.A.p + 2*b.p + c, with A symmetric
+// so only its upper triangle is kept. Summed in f64, a vertex can end up with thousands.
+typedef struct Quadric {
+    f64 a00, a01, a02, a11, a12, a22;
+    f64 b0, b1, b2;
+    f64 c;
+} Quadric;
+
+// NOTE: normal has to be unit length, the plane is dot(normal, p) + d = 0.
+internal Quadric plane_quadric(V3 normal, f32 d, f32 weight) {
+    f64 x = normal.x;
+    f64 y = normal.y;
+    f64 z = normal.z;
+    Quadric result;
+    result.a00 = weight*x*x; result.a01 = weight*x*y; result.a02 = weight*x*z;
+    result.a11 = weight*y*y; result.a12 = weight*y*z;
+    result.a22 = weight*z*z;
+    result.b0  = weight*x*d; result.b1  = weight*y*d; result.b2  = weight*z*d;
+    result.c   = weight*(f64)d*d;
+    return result;
+}
+
+internal void add_quadric(Quadric* q, Quadric* add) {
+    q->a00 += add->a00; q->a01 += add->a01; q->a02 += add->a02;
+    q->a11 += add->a11; q->a12 += add->a12;
+    q->a22 += add->a22;
+    q->b0  += add->b0;  q->b1  += add->b1;  q->b2  += add->b2;
+    q->c   += add->c;
+}
+
+internal f64 quadric_error(Quadric* q, V3 p) {
+    f64 x = p.x;
+    f64 y = p.y;
+    f64 z = p.z;
+    f64 result = x*(q->a00*x + 2.0*(q->a01*y + q->a02*z + q->b0)) +
+                 y*(q->a11*y + 2.0*(q->a12*z + q->b1)) +
+                 z*(q->a22*z + 2.0*q->b2) + q->c;
+    return result;
+}
+
+// NOTE: Where the error is smallest, solving A.p = -b. Fails when A is close to singular,
+// which is when the planes are close to parallel and a whole line or plane is as good.
+internal b32 quadric_minimum(Quadric* q, V3* out) {
+    f64 c00 = q->a11*q->a22 - q->a12*q->a12;
+    f64 c01 = q->a02*q->a12 - q->a01*q->a22;
+    f64 c02 = q->a01*q->a12 - q->a02*q->a11;
+    f64 det = q->a00*c00 + q->a01*c01 + q->a02*c02;
+    
+    f64 trace = q->a00 + q->a11 + q->a22;
+    if (Abs(det) <= 1e-6*trace*trace*trace) {
+        return false;
+    }
+    
+    f64 c11 = q->a00*q->a22 - q->a02*q->a02;
+    f64 c12 = q->a01*q->a02 - q->a00*q->a12;
+    f64 c22 = q->a00*q->a11 - q->a01*q->a01;
+    f64 one_over_det = 1.0 / det;
+    out->x = (f32)(-(c00*q->b0 + c01*q->b1 + c02*q->b2)*one_over_det);
+    out->y = (f32)(-(c01*q->b0 + c11*q->b1 + c12*q->b2)*one_over_det);
+    out->z = (f32)(-(c02*q->b0 + c12*q->b1 + c22*q->b2)*one_over_det);
+    return true;
+}
+
+//
+// NOTE: Edge collapses
+//
+
+// NOTE: b collapses into a, which moves to position. Only still good if neither end has
+// changed since, which the versions check.
+typedef struct Edge_Collapse {
+    f32 cost;
+    u32 a;
+    u32 b;
+    u32 version_a;
+    u32 version_b;
+    V3 position;
+} Edge_Collapse;
+
+// NOTE: A binary min heap on cost.
+typedef struct Collapse_Heap {
+    u32 count;
+    u32 capacity;
+    Edge_Collapse* entries;
+} Collapse_Heap;
+
+internal void push_collapse(Collapse_Heap* heap, Edge_Collapse collapse) {
+    if (heap->count == heap->capacity) {
+        heap->capacity = Max(2*heap->capacity, 256);
+        heap->entries = (Edge_Collapse*)realloc(heap->entries, sizeof(Edge_Collapse)*(umm)heap->capacity);
+    }
+    
+    u32 index = heap->count++;
+    while (index) {
+        u32 parent = (index - 1) / 2;
+        if (heap->entries[parent].cost <= collapse.cost) {
+            break;
+        }
+        heap->entries[index] = heap->entries[parent];
+        index = parent;
+    }
+    heap->entries[index] = collapse;
+}
+
+internal Edge_Collapse pop_collapse(Collapse_Heap* heap) {
+    Assert(heap->count);
+    Edge_Collapse result = heap->entries[0];
+    Edge_Collapse last = heap->entries[--heap->count];
+    
+    u32 index = 0;
+    for (;;) {
+        u32 child = 2*index + 1;
+        if (child >= heap->count) {
+            break;
+        }
+        if ((child + 1 < heap->count) && (heap->entries[child + 1].cost < heap->entries[child].cost)) {
+            ++child;
+        }
+        if (last.cost <= heap->entries[child].cost) {
+            break;
+        }
+        heap->entries[index] = heap->entries[child];
+        index = child;
+    }
+    if (heap->count) {
+        heap->entries[index] = last;
+    }
+    
+    return result;
+}
+
+//
+// NOTE: Simplification
+//
+
+// NOTE: Boundary planes count this many times a triangle's, so open edges hold still unless
+// collapsing along them is nearly free.
+#define SIMPLIFY_BOUNDARY_WEIGHT 16.0f
+
+// NOTE: A collapse is skipped if it turns any triangle further than this from where it faced,
+// as the cosine between the old and new normals.
+#define SIMPLIFY_MIN_NORMAL_COSINE 0.25f
+
+typedef struct Simplifier {
+    V3* positions;
+    Quadric* quadrics;
+    u32* versions;
+    b32* vertex_removed;
+    
+    // NOTE: Stretchy buffers of the triangles around each vertex. Collapses leave removed
+    // triangles in them, which are skipped.
+    u32** vertex_triangles;
+    
+    Triangle* triangles;
+    Triangle* texcoord_triangles;
+    b32* triangle_removed;
+    u32 triangle_count; // NOTE: The ones left
+    
+    Collapse_Heap heap;
+    u32* neighbors; // NOTE: Scratch, a stretchy buffer
+} Simplifier;
+
+internal b32 triangle_has_vertex(Triangle* triangle, u32 vertex) {
+    b32 result = (triangle->a == vertex) || (triangle->b == vertex) || (triangle->c == vertex);
+    return result;
+}
+
+internal V3 get_triangle_normal(V3 p0, V3 p1, V3 p2) {
+    V3 result = cross(p1 - p0, p2 - p0);
+    return result;
+}
+
+// NOTE: Into simplifier->neighbors, each once.
+internal void gather_neighbors(Simplifier* simplifier, u32 vertex) {
+    buf_clear(simplifier->neighbors);
+    u32* triangles = simplifier->vertex_triangles[vertex];
+    for (u32 i = 0; i < buf_len(triangles); ++i) {
+        if (simplifier->triangle_removed[triangles[i]]) {
+            continue;
+        }
+        
+        Triangle* triangle = simplifier->triangles + triangles[i];
+        for (u32 corner = 0; corner < 3; ++corner) {
+            u32 other = triangle->e[corner];
+            if (other == vertex) {
+                continue;
+            }
+            
+            b32 found = false;
+            for (u32 j = 0; j < buf_len(simplifier->neighbors); ++j) {
+                if (simplifier->neighbors[j] == other) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                buf_push(simplifier->neighbors, other);
+            }
+        }
+    }
+}
+
+// NOTE: The cheapest spot for the merged vertex, falling back on the best of the ends and the
+// middle when the quadric has no single minimum.
+internal void push_edge_collapse(Simplifier* simplifier, u32 a, u32 b) {
+    Quadric quadric = simplifier->quadrics[a];
+    add_quadric(&quadric, &simplifier->quadrics[b]);
+    
+    V3 position;
+    f64 cost;
+    if (quadric_minimum(&quadric, &position)) {
+        cost = quadric_error(&quadric, position);
+    } else {
+        V3 candidates[3] = {
+            simplifier->positions[a],
+            simplifier->positions[b],
+            0.5f*(simplifier->positions[a] + simplifier->positions[b]),
+        };
+        position = candidates[0];
+        cost = quadric_error(&quadric, position);
+        for (u32 i = 1; i < ArrayCount(candidates); ++i) {
+            f64 candidate_cost = quadric_error(&quadric, candidates[i]);
+            if (candidate_cost < cost) {
+                cost = candidate_cost;
+                position = candidates[i];
+            }
+        }
+    }
+    
+    Edge_Collapse collapse;
+    collapse.cost      = (f32)Max(cost, 0.0);
+    collapse.a         = a;
+    collapse.b         = b;
+    collapse.version_a = simplifier->versions[a];
+    collapse.version_b = simplifier->versions[b];
+    collapse.position  = position;
+    push_collapse(&simplifier->heap, collapse);
+}
+
+// NOTE: Moving a and b to position mustn't flip or squash any triangle that survives, and a
+// and b mustn't share neighbors other than across the triangles on the edge, or the collapse
+// would pinch the surface into a non-manifold edge.
+internal b32 collapse_is_valid(Simplifier* simplifier, Edge_Collapse* collapse) {
+    u32 shared_triangles = 0;
+    u32 ends[2] = { collapse->a, collapse->b };
+    for (u32 end = 0; end < 2; ++end) {
+        u32* triangles = simplifier->vertex_triangles[ends[end]];
+        for (u32 i = 0; i < buf_len(triangles); ++i) {
+            if (simplifier->triangle_removed[triangles[i]]) {
+                continue;
+            }
+            
+            Triangle* triangle = simplifier->triangles + triangles[i];
+            if (triangle_has_vertex(triangle, collapse->a) && triangle_has_vertex(triangle, collapse->b)) {
+                shared_triangles += (end == 0);
+                continue;
+            }
+            
+            V3 old_corners[3];
+            V3 new_corners[3];
+            for (u32 corner = 0; corner < 3; ++corner) {
+                old_corners[corner] = simplifier->positions[triangle->e[corner]];
+                new_corners[corner] = (triangle->e[corner] == ends[end]) ? collapse->position : old_corners[corner];
+            }
+            V3 old_normal = get_triangle_normal(old_corners[0], old_corners[1], old_corners[2]);
+            V3 new_normal = get_triangle_normal(new_corners[0], new_corners[1], new_corners[2]);
+            f32 old_length = length(old_normal);
+            f32 new_length = length(new_normal);
+            if (!(new_length > 1e-6f*old_length) ||
+                (dot(old_normal, new_normal) < SIMPLIFY_MIN_NORMAL_COSINE*old_length*new_length)) {
+                return false;
+            }
+        }
+    }
+    
+    gather_neighbors(simplifier, collapse->a);
+    u32 shared_neighbors = 0;
+    u32* b_triangles = simplifier->vertex_triangles[collapse->b];
+    for (u32 i = 0; i < buf_len(simplifier->neighbors); ++i) {
+        u32 neighbor = simplifier->neighbors[i];
+        for (u32 j = 0; j < buf_len(b_triangles); ++j) {
+            if (!simplifier->triangle_removed[b_triangles[j]] && triangle_has_vertex(simplifier->triangles + b_triangles[j], neighbor)) {
+                ++shared_neighbors;
+                break;
+            }
+        }
+    }
+    // NOTE: b counts as its own neighbor through the triangles on the edge.
+    b32 result = (shared_neighbors == shared_triangles + 1);
+    return result;
+}
+
+internal void apply_collapse(Simplifier* simplifier, Edge_Collapse* collapse) {
+    u32 a = collapse->a;
+    u32 b = collapse->b;
+    
+    u32* b_triangles = simplifier->vertex_triangles[b];
+    for (u32 i = 0; i < buf_len(b_triangles); ++i) {
+        u32 triangle_index = b_triangles[i];
+        if (simplifier->triangle_removed[triangle_index]) {
+            continue;
+        }
+        
+        Triangle* triangle = simplifier->triangles + triangle_index;
+        if (triangle_has_vertex(triangle, a)) {
+            simplifier->triangle_removed[triangle_index] = true;
+            --simplifier->triangle_count;
+        } else {
+            for (u32 corner = 0; corner < 3; ++corner) {
+                if (triangle->e[corner] == b) {
+                    triangle->e[corner] = a;
+                }
+            }
+            buf_push(simplifier->vertex_triangles[a], triangle_index);
+        }
+    }
+    buf_free(simplifier->vertex_triangles[b]);
+    
+    simplifier->positions[a] = collapse->position;
+    add_quadric(&simplifier->quadrics[a], &simplifier->quadrics[b]);
+    simplifier->vertex_removed[b] = true;
+    ++simplifier->versions[a];
+    ++simplifier->versions[b];
+}
+
+// NOTE: A copy of mesh with at most target_triangle_count triangles, or as close as it can get
+// without breaking the surface. error gets how far the result can be from the original, in
+// model units. The result is freed with free_simplified_mesh.
+function
+Mesh simplify_mesh(Mesh* mesh, u32 target_triangle_count, f32* error) {
+    Simplifier simplifier = {};
+    u32 vertex_count = mesh->vertex_count;
+    simplifier.positions        = (V3*)malloc(sizeof(V3)*(umm)vertex_count);
+    simplifier.quadrics         = (Quadric*)calloc(vertex_count, sizeof(Quadric));
+    simplifier.versions         = (u32*)calloc(vertex_count, sizeof(u32));
+    simplifier.vertex_removed   = (b32*)calloc(vertex_count, sizeof(b32));
+    simplifier.vertex_triangles = (u32**)calloc(vertex_count, sizeof(u32*));
+    simplifier.triangles        = (Triangle*)malloc(sizeof(Triangle)*(umm)mesh->triangle_count);
+    simplifier.triangle_removed = (b32*)calloc(mesh->triangle_count, sizeof(b32));
+    simplifier.triangle_count   = mesh->triangle_count;
+    memcpy(simplifier.positions, mesh->vertices,  sizeof(V3)*(umm)vertex_count);
+    memcpy(simplifier.triangles, mesh->triangles, sizeof(Triangle)*(umm)mesh->triangle_count);
+    if (mesh->texcoords) {
+        simplifier.texcoord_triangles = (Triangle*)malloc(sizeof(Triangle)*(umm)mesh->triangle_count);
+        memcpy(simplifier.texcoord_triangles, mesh->texcoord_triangles, sizeof(Triangle)*(umm)mesh->triangle_count);
+    }
+    
+    for (u32 triangle_index = 0; triangle_index < mesh->triangle_count; ++triangle_index) {
+        Triangle* triangle = simplifier.triangles + triangle_index;
+        V3 p0 = simplifier.positions[triangle->a];
+        V3 p1 = simplifier.positions[triangle->b];
+        V3 p2 = simplifier.positions[triangle->c];
+        V3 normal = get_triangle_normal(p0, p1, p2);
+        f32 normal_length = length(normal);
+        
+        // NOTE: Degenerate triangles still go in the lists, so they get cleaned up by collapses.
+        if (normal_length > 0.0f) {
+            normal = normal*(1.0f / normal_length);
+            Quadric quadric = plane_quadric(normal, -dot(normal, p0), 1.0f);
+            for (u32 corner = 0; corner < 3; ++corner) {
+                add_quadric(&simplifier.quadrics[triangle->e[corner]], &quadric);
+            }
+        }
+        for (u32 corner = 0; corner < 3; ++corner) {
+            buf_push(simplifier.vertex_triangles[triangle->e[corner]], triangle_index);
+        }
+    }
+    
+    // NOTE: An edge is on a boundary if it's in one triangle. Its plane goes through it, at
+    // right angles to the triangle.
+    for (u32 triangle_index = 0; triangle_index < mesh->triangle_count; ++triangle_index) {
+        Triangle* triangle = simplifier.triangles + triangle_index;
+        V3 p[3] = { simplifier.positions[triangle->a], simplifier.positions[triangle->b], simplifier.positions[triangle->c] };
+        V3 face_normal = get_triangle_normal(p[0], p[1], p[2]);
+        
+        for (u32 corner = 0; corner < 3; ++corner) {
+            u32 a = triangle->e[corner];
+            u32 b = triangle->e[(corner + 1) % 3];
+            u32 sharing = 0;
+            u32* a_triangles = simplifier.vertex_triangles[a];
+            for (u32 i = 0; i < buf_len(a_triangles); ++i) {
+                sharing += triangle_has_vertex(simplifier.triangles + a_triangles[i], b);
+            }
+            
+            V3 edge_normal = cross(p[(corner + 1) % 3] - p[corner], face_normal);
+            f32 edge_normal_length = length(edge_normal);
+            if ((sharing == 1) && (edge_normal_length > 0.0f)) {
+                edge_normal = edge_normal*(1.0f / edge_normal_length);
+                Quadric quadric = plane_quadric(edge_normal, -dot(edge_normal, p[corner]), SIMPLIFY_BOUNDARY_WEIGHT);
+                add_quadric(&simplifier.quadrics[a], &quadric);
+                add_quadric(&simplifier.quadrics[b], &quadric);
+            }
+        }
+    }
+    
+    for (u32 vertex = 0; vertex < vertex_count; ++vertex) {
+        gather_neighbors(&simplifier, vertex);
+        for (u32 i = 0; i < buf_len(simplifier.neighbors); ++i) {
+            if (simplifier.neighbors[i] > vertex) {
+                push_edge_collapse(&simplifier, vertex, simplifier.neighbors[i]);
+            }
+        }
+    }
+    
+    f32 max_cost = 0.0f;
+    while ((simplifier.triangle_count > target_triangle_count) && simplifier.heap.count) {
+        Edge_Collapse collapse = pop_collapse(&simplifier.heap);
+        if (simplifier.vertex_removed[collapse.a] || simplifier.vertex_removed[collapse.b] ||
+            (collapse.version_a != simplifier.versions[collapse.a]) ||
+            (collapse.version_b != simplifier.versions[collapse.b])) {
+            continue;
+        }
+        if (!collapse_is_valid(&simplifier, &collapse)) {
+            continue;
+        }
+        
+        apply_collapse(&simplifier, &collapse);
+        max_cost = Max(max_cost, collapse.cost);
+        
+        gather_neighbors(&simplifier, collapse.a);
+        for (u32 i = 0; i < buf_len(simplifier.neighbors); ++i) {
+            push_edge_collapse(&simplifier, collapse.a, simplifier.neighbors[i]);
+        }
+    }
+    
+    // NOTE: The cost is a sum of squared distances to planes of the original triangles around
+    // the collapse, so its root is at least the distance to the furthest of them.
+    if (error) {
+        *error = sqrtf(max_cost);
+    }
+    
+    // NOTE: Only the vertices still in use, renumbered in their old order.
+    u32* remap = (u32*)malloc(sizeof(u32)*(umm)Max(vertex_count, 1));
+    u32 new_vertex_count = 0;
+    memset(remap, 0xFF, sizeof(u32)*(umm)vertex_count);
+    for (u32 triangle_index = 0; triangle_index < mesh->triangle_count; ++triangle_index) {
+        if (!simplifier.triangle_removed[triangle_index]) {
+            for (u32 corner = 0; corner < 3; ++corner) {
+                remap[simplifier.triangles[triangle_index].e[corner]] = 0;
+            }
+        }
+    }
+    for (u32 vertex = 0; vertex < vertex_count; ++vertex) {
+        if (remap[vertex] == 0) {
+            remap[vertex] = new_vertex_count++;
+        }
+    }
+    
+    Mesh result = {};
+    result.vertex_count   = new_vertex_count;
+    result.vertices       = (V3*)malloc(sizeof(V3)*(umm)Max(new_vertex_count, 1));
+    result.triangle_count = simplifier.triangle_count;
+    result.triangles      = (Triangle*)malloc(sizeof(Triangle)*(umm)Max(simplifier.triangle_count, 1));
+    for (u32 vertex = 0; vertex < vertex_count; ++vertex) {
+        if (remap[vertex] != 0xFFFFFFFF) {
+            result.vertices[remap[vertex]] = simplifier.positions[vertex];
+        }
+    }
+    
+    if (mesh->texcoords) {
+        result.texcoord_count     = mesh->texcoord_count;
+        result.texcoords          = (V2*)malloc(sizeof(V2)*(umm)mesh->texcoord_count);
+        result.texcoord_triangles = (Triangle*)malloc(sizeof(Triangle)*(umm)Max(simplifier.triangle_count, 1));
+        memcpy(result.texcoords, mesh->texcoords, sizeof(V2)*(umm)mesh->texcoord_count);
+    }
+    
+    u32 triangle_count = 0;
+    for (u32 triangle_index = 0; triangle_index < mesh->triangle_count; ++triangle_index) {
+        if (simplifier.triangle_removed[triangle_index]) {
+            continue;
+        }
+        
+        Triangle* triangle = result.triangles + triangle_count;
+        for (u32 corner = 0; corner < 3; ++corner) {
+            triangle->e[corner] = remap[simplifier.triangles[triangle_index].e[corner]];
+        }
+        if (mesh->texcoords) {
+            result.texcoord_triangles[triangle_count] = simplifier.texcoord_triangles[triangle_index];
+        }
+        ++triangle_count;
+    }
+    
+    if (new_vertex_count) {
+        compute_mesh_bounds(&result);
+    }
+    
+    for (u32 vertex = 0; vertex < vertex_count; ++vertex) {
+        buf_free(simplifier.vertex_triangles[vertex]);
+    }
+    buf_free(simplifier.neighbors);
+    free(remap);
+    free(simplifier.heap.entries);
+    free(simplifier.triangle_removed);
+    free(simplifier.texcoord_triangles);
+    free(simplifier.triangles);
+    free(simplifier.vertex_triangles);
+    free(simplifier.vertex_removed);
+    free(simplifier.versions);
+    free(simplifier.quadrics);
+    free(simplifier.positions);
+    
+    return result;
+}
+
+function
+void free_simplified_mesh(Mesh* mesh) {
+    free(mesh->vertices);
+    free(mesh->triangles);
+    free(mesh->texcoords);
+    free(mesh->texcoord_triangles);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+//
+// NOTE: Levels of detail
+//
+
+// NOTE: Halves the triangles each level until min_triangle_count, or until a level can't get
+// rid of MESH_LOD_MIN_REDUCTION of them. Each level is simplified from the one before, so its
+// error is the sum of theirs. mesh has to outlive the result.
+function
+Mesh_LODs build_mesh_lods(Mesh* mesh, u32 min_triangle_count) {
+    Mesh_LODs result = {};
+    result.lods[0]   = *mesh;
+    result.errors[0] = 0.0f;
+    result.lod_count = 1;
+    
+    // NOTE: select_mesh_lod goes by lods[0]'s bounds, and mesh may not have come from
+    // parse_obj. The simplified levels find their own.
+    if (mesh->vertex_count) {
+        compute_mesh_bounds(&result.lods[0]);
+    }
+    
+    while (result.lod_count < MESH_MAX_LODS) {
+        Mesh* previous = result.lods + result.lod_count - 1;
+        u32 target_triangle_count = previous->triangle_count / 2;
+        if (target_triangle_count < min_triangle_count) {
+            break;
+        }
+        
+        f32 error;
+        Mesh lod = simplify_mesh(previous, target_triangle_count, &error);
+        if (!lod.triangle_count ||
+            ((f32)lod.triangle_count > (1.0f - MESH_LOD_MIN_REDUCTION)*(f32)previous->triangle_count)) {
+            free_simplified_mesh(&lod);
+            break;
+        }
+        
+        result.lods[result.lod_count]   = lod;
+        result.errors[result.lod_count] = result.errors[result.lod_count - 1] + error;
+        ++result.lod_count;
+    }
+    
+    return result;
+}
+
+function
+void free_mesh_lods(Mesh_LODs* lods) {
+    for (u32 i = 1; i < lods->lod_count; ++i) {
+        free_simplified_mesh(&lods->lods[i]);
+    }
+    memset(lods, 0, sizeof(*lods));
+}
+
+// NOTE: The coarsest level whose error projects to at most MESH_LOD_PIXEL_ERROR pixels on a
+// target height pixels tall. A model unit at the bounding sphere's center covers
+// |row 1 of view_projection| / w of the 2 units of clip space height, times the longest
+// basis vector of model. Anything reaching behind the eye gets the full mesh.
+function
+u32 select_mesh_lod(Mesh_LODs* lods, M4x4 model, M4x4 view_projection, u32 height) {
+    Mesh* mesh = lods->lods;
+    V4 center = m4x4_transform_v4(model, v4(mesh->bounds_center.x, mesh->bounds_center.y, mesh->bounds_center.z, 1.0f));
+    V4 clip = m4x4_transform_v4(view_projection, center);
+    
+    f32 scale_sq = 0.0f;
+    for (u32 column = 0; column < 3; ++column) {
+        scale_sq = Max(scale_sq, length_sq(v3(model.e[0][column], model.e[1][column], model.e[2][column])));
+    }
+    f32 scale = sqrtf(scale_sq);
+    
+    f32 near_w = clip.w - mesh->bounds_radius*scale*length(v3(view_projection.e[3][0], view_projection.e[3][1], view_projection.e[3][2]));
+    if (near_w <= 0.0f) {
+        return 0;
+    }
+    
+    f32 rows_per_unit = length(v3(view_projection.e[1][0], view_projection.e[1][1], view_projection.e[1][2]));
+    f32 pixels_per_unit = 0.5f*(f32)height*rows_per_unit*scale / near_w;
+    
+    u32 result = 0;
+    while ((result + 1 < lods->lod_count) && (lods->errors[result + 1]*pixels_per_unit <= MESH_LOD_PIXEL_ERROR)) {
+        ++result;
+    }
+    return result;
+}
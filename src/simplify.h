@@ -0,0 +1,35 @@
+/* date = October 19th 2026 11:40 pm */
+
+#ifndef SIMPLIFY_H
+#define SIMPLIFY_H
+
+//
+// NOTE: Mesh simplification and levels of detail. simplify_mesh collapses edges, cheapest
+// first, by quadric error (Garland and Heckbert): each vertex carries the sum of the squared
+// distances to the planes of the triangles around it, and an edge collapses to wherever that
+// sum over both its ends is smallest. Edges on open boundaries also get planes along them, so
+// holes and silhouettes keep their shape. Collapses that would flip a triangle or pinch the
+// surface are skipped.
+//
+// Texcoords keep their own indices per corner, so seams stay seams, but the texcoords
+// themselves don't move with the vertices.
+//
+
+#define MESH_MAX_LODS 8
+
+// NOTE: A level has to lose at least this fraction of the triangles of the one before.
+#define MESH_LOD_MIN_REDUCTION 0.1f
+
+// NOTE: select_mesh_lod picks the coarsest level whose error covers at most this many pixels.
+#define MESH_LOD_PIXEL_ERROR 1.0f
+
+typedef struct Mesh_LODs {
+    u32 lod_count;
+    // NOTE: lods[0] is the mesh they were built from, and isn't owned. Each level after it has
+    // about half the triangles of the one before. Every level has its bounds filled in.
+    Mesh lods[MESH_MAX_LODS];
+    // NOTE: How far, in model units, each level can be from the original surface.
+    f32 errors[MESH_MAX_LODS];
+} Mesh_LODs;
+
+#endif //SIMPLIFY_H
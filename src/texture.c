@@ -0,0 +1,201 @@
+//
+// NOTE: Mip chain
+//
+
+// NOTE: Each texel of dst is the average of the 2x2 texels of src it covers, weighted by
+// alpha so transparent texels don't bleed their color. When a size is odd the last row or
+// column of src has no pair, so the last row or column of dst averages three instead.
+internal void downsample_mip(Tiled_Image_u32* src, Tiled_Image_u32* dst) {
+    for (u32 y = 0; y < dst->height; ++y) {
+        u32 y0 = 2*y;
+        u32 y1 = (y == dst->height - 1) ? src->height : 2*y + 2;
+        for (u32 x = 0; x < dst->width; ++x) {
+            u32 x0 = 2*x;
+            u32 x1 = (x == dst->width - 1) ? src->width : 2*x + 2;
+            
+            V4 sum = v4(0.0f, 0.0f, 0.0f, 0.0f);
+            for (u32 src_y = y0; src_y < y1; ++src_y) {
+                for (u32 src_x = x0; src_x < x1; ++src_x) {
+                    Color_ARGB texel;
+                    texel.argb = get_pixel(src, src_x, src_y);
+                    sum += color_to_linear(texel);
+                }
+            }
+            
+            // NOTE: Back to straight alpha, which is how textures are stored.
+            V4 average = sum / (f32)((y1 - y0)*(x1 - x0));
+            if (average.w > 0.0f) {
+                average.xyz /= average.w;
+            }
+            set_pixel(dst, x, y, linear_to_color(average));
+        }
+    }
+}
+
+// NOTE: The texture gets its own tiled copy of image, image can be freed after.
+function
+void create_texture(Texture* texture, Image_u32* image) {
+    memset(texture, 0, sizeof(*texture));
+    
+    texture->mips[0] = allocate_tiled_image(image->width, image->height);
+    tile_image(image, &texture->mips[0]);
+    texture->mip_count = 1;
+    
+    while (texture->mip_count < MAX_TEXTURE_MIPS) {
+        Tiled_Image_u32* src = &texture->mips[texture->mip_count - 1];
+        if ((src->width == 1) && (src->height == 1)) {
+            break;
+        }
+        
+        Tiled_Image_u32* dst = &texture->mips[texture->mip_count++];
+        *dst = allocate_tiled_image(Max(src->width / 2, 1), Max(src->height / 2, 1));
+        downsample_mip(src, dst);
+    }
+}
+
+function
+void free_texture(Texture* texture) {
+    for (u32 mip_index = 0; mip_index < texture->mip_count; ++mip_index) {
+        free_image(&texture->mips[mip_index]);
+    }
+    memset(texture, 0, sizeof(*texture));
+}
+
+// NOTE: The mip level for a footprint with these uv gradients, where du is (du/dx, du/dy)
+// in screen space and dv the same for v. 0 is the top level, it goes up by one each time
+// the footprint doubles.
+function
+f32 get_texture_lod(Texture* texture, V2 du, V2 dv) {
+    f32 width  = (f32)texture->mips[0].width;
+    f32 height = (f32)texture->mips[0].height;
+    V2 texels_per_x = v2(du.x*width, dv.x*height);
+    V2 texels_per_y = v2(du.y*width, dv.y*height);
+    f32 footprint_squared = Max(dot(texels_per_x, texels_per_x), dot(texels_per_y, texels_per_y));
+    f32 result = 0.5f*log2f(Max(footprint_squared, 1e-12f));
+    return result;
+}
+
+//
+// NOTE: Sampling
+//
+
+// NOTE: SSE2 has no floor. This truncates, then steps down the negatives that moved up.
+internal __m128 floor_ps(__m128 x) {
+    __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    __m128 result = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+    return result;
+}
+
+// NOTE: SSE2 has no 32 bit mullo either, pmuludq does the even and odd lanes separately.
+internal __m128i mullo_u32(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd  = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    __m128i result = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                        _mm_shuffle_epi32(odd,  _MM_SHUFFLE(0, 0, 2, 0)));
+    return result;
+}
+
+// NOTE: Clears the sign bits.
+internal __m128 abs_ps(__m128 x) {
+    __m128 result = _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+    return result;
+}
+
+// NOTE: Texel coordinates are at most one size out of range, from the bilinear footprint.
+internal __m128i wrap_texel_coordinate(__m128i x, __m128i size) {
+    x = _mm_add_epi32(x, _mm_and_si128(_mm_cmplt_epi32(x, _mm_setzero_si128()), size));
+    x = _mm_sub_epi32(x, _mm_andnot_si128(_mm_cmplt_epi32(x, size), size));
+    return x;
+}
+
+internal __m128i gather_texels(Tiled_Image_u32* mip, __m128i x, __m128i y) {
+    __m128i tile_mask  = _mm_set1_epi32(IMAGE_TILE_MASK);
+    __m128i tile_index = _mm_add_epi32(mullo_u32(_mm_srli_epi32(y, IMAGE_TILE_SHIFT), _mm_set1_epi32(mip->tiles_x)),
+                                       _mm_srli_epi32(x, IMAGE_TILE_SHIFT));
+    __m128i in_tile    = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(y, tile_mask), IMAGE_TILE_SHIFT),
+                                      _mm_and_si128(x, tile_mask));
+    
+    u32 offsets[4];
+    _mm_storeu_si128((__m128i*)offsets, _mm_add_epi32(_mm_slli_epi32(tile_index, 2*IMAGE_TILE_SHIFT), in_tile));
+    __m128i result = _mm_setr_epi32((s32)mip->pixels[offsets[0]], (s32)mip->pixels[offsets[1]],
+                                    (s32)mip->pixels[offsets[2]], (s32)mip->pixels[offsets[3]]);
+    return result;
+}
+
+// NOTE: (a*(256 - t) + b*t) / 256 in every 16 bit lane. a and b are channels from 0 to 255, t
+// goes from 0 to 256, so nothing overflows 16 bits.
+internal __m128i lerp_channels(__m128i a, __m128i b, __m128i t) {
+    __m128i one_minus_t = _mm_sub_epi16(_mm_set1_epi16(256), t);
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, one_minus_t), _mm_mullo_epi16(b, t));
+    __m128i result = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+    return result;
+}
+
+// NOTE: Four texels with the same bilinear weights, split into b/r and g/a pairs like blend_pixels does.
+internal __m128i bilinear_filter(__m128i c00, __m128i c10, __m128i c01, __m128i c11, __m128i tx, __m128i ty) {
+    __m128i mask = _mm_set1_epi32(0x00FF00FF);
+    
+    __m128i low = lerp_channels(lerp_channels(_mm_and_si128(c00, mask), _mm_and_si128(c10, mask), tx),
+                                lerp_channels(_mm_and_si128(c01, mask), _mm_and_si128(c11, mask), tx), ty);
+    __m128i high = lerp_channels(lerp_channels(_mm_and_si128(_mm_srli_epi32(c00, 8), mask), _mm_and_si128(_mm_srli_epi32(c10, 8), mask), tx),
+                                 lerp_channels(_mm_and_si128(_mm_srli_epi32(c01, 8), mask), _mm_and_si128(_mm_srli_epi32(c11, 8), mask), tx), ty);
+    
+    __m128i result = _mm_or_si128(low, _mm_slli_epi32(high, 8));
+    return result;
+}
+
+// NOTE: Four samples, returned as four Color_ARGBs. The mip is lod rounded to the nearest level.
+function
+__m128i sample_texture(Texture* texture, __m128 u, __m128 v, f32 lod, TextureFilter filter) {
+    u32 level = 0;
+    if (lod > 0.0f) {
+        level = Min((u32)(lod + 0.5f), texture->mip_count - 1);
+    }
+    Tiled_Image_u32* mip = &texture->mips[level];
+    
+    __m128i width  = _mm_set1_epi32(mip->width);
+    __m128i height = _mm_set1_epi32(mip->height);
+    
+    // NOTE: Wrapped to [0, 1) first, so big uvs can't overflow the conversions.
+    u = _mm_sub_ps(u, floor_ps(u));
+    v = _mm_sub_ps(v, floor_ps(v));
+    __m128 x = _mm_mul_ps(u, _mm_cvtepi32_ps(width));
+    __m128 y = _mm_mul_ps(v, _mm_cvtepi32_ps(height));
+    
+    __m128i result;
+    if (filter == TextureFilter_Nearest) {
+        __m128i texel_x = wrap_texel_coordinate(_mm_cvttps_epi32(x), width);
+        __m128i texel_y = wrap_texel_coordinate(_mm_cvttps_epi32(y), height);
+        result = gather_texels(mip, texel_x, texel_y);
+    } else {
+        // NOTE: Texel centers are at +0.5, so the footprint starts half a texel back.
+        x = _mm_sub_ps(x, _mm_set1_ps(0.5f));
+        y = _mm_sub_ps(y, _mm_set1_ps(0.5f));
+        __m128 x_floor = floor_ps(x);
+        __m128 y_floor = floor_ps(y);
+        
+        // NOTE: The weights go in both 16 bit halves of each lane, one per channel pair.
+        __m128i tx = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(x, x_floor), _mm_set1_ps(256.0f)));
+        __m128i ty = _mm_cvtps_epi32(_mm_mul_ps(_mm_sub_ps(y, y_floor), _mm_set1_ps(256.0f)));
+        tx = _mm_or_si128(tx, _mm_slli_epi32(tx, 16));
+        ty = _mm_or_si128(ty, _mm_slli_epi32(ty, 16));
+        
+        __m128i one = _mm_set1_epi32(1);
+        __m128i x0 = wrap_texel_coordinate(_mm_cvttps_epi32(x_floor), width);
+        __m128i y0 = wrap_texel_coordinate(_mm_cvttps_epi32(y_floor), height);
+        __m128i x1 = wrap_texel_coordinate(_mm_add_epi32(x0, one), width);
+        __m128i y1 = wrap_texel_coordinate(_mm_add_epi32(y0, one), height);
+        
+        result = bilinear_filter(gather_texels(mip, x0, y0), gather_texels(mip, x1, y0),
+                                 gather_texels(mip, x0, y1), gather_texels(mip, x1, y1), tx, ty);
+    }
+    
+    return result;
+}
+
+function
+Color_ARGB sample_texture(Texture* texture, V2 uv, f32 lod, TextureFilter filter) {
+    Color_ARGB result;
+    result.argb = (u32)_mm_cvtsi128_si32(sample_texture(texture, _mm_set1_ps(uv.x), _mm_set1_ps(uv.y), lod, filter));
+    return result;
+}
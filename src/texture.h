@@ -0,0 +1,28 @@
+/* date = October 19th 2026 8:30 pm */
+
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+//
+// NOTE: A texture is a mip chain of Tiled_Image_u32s, so a bilinear footprint, and usually a
+// whole batch of them, lands in one 8x8 tile instead of on two or more rows. The mips are box
+// filtered in linear light. Sampling wraps, and filters the stored sRGB bytes directly, like
+// a GPU texture without an sRGB format.
+//
+// The samplers take four uvs at a time and one LOD for all of them, the way a GPU picks one
+// mip per 2x2 quad.
+//
+
+#define MAX_TEXTURE_MIPS 16
+
+typedef enum TextureFilter {
+    TextureFilter_Nearest,
+    TextureFilter_Bilinear,
+} TextureFilter;
+
+typedef struct Texture {
+    u32 mip_count;
+    Tiled_Image_u32 mips[MAX_TEXTURE_MIPS];
+} Texture;
+
+#endif //TEXTURE_H
@@ -0,0 +1,107 @@
+function
+Tiled_Image_u32 allocate_tiled_image(u32 width, u32 height) {
+    Tiled_Image_u32 image = {};
+    image.width   = width;
+    image.height  = height;
+    image.tiles_x = (width  + IMAGE_TILE_MASK) >> IMAGE_TILE_SHIFT;
+    image.tiles_y = (height + IMAGE_TILE_MASK) >> IMAGE_TILE_SHIFT;
+    
+    umm pixel_size = sizeof(u32)*IMAGE_TILE_PIXELS*(umm)image.tiles_x*image.tiles_y;
+    image.pixels = (u32*)allocate_aligned(pixel_size, IMAGE_ALIGNMENT);
+    memset(image.pixels, 0, pixel_size);
+    
+    return image;
+}
+
+function
+void free_image(Tiled_Image_u32* image) {
+    free_aligned(image->pixels);
+    memset(image, 0, sizeof(*image));
+}
+
+function
+u32* get_tile_pointer(Tiled_Image_u32* image, u32 tile_x, u32 tile_y) {
+    u32* result = image->pixels + ((umm)tile_y*image->tiles_x + tile_x)*IMAGE_TILE_PIXELS;
+    return result;
+}
+
+function
+u32* get_pixel_pointer(Tiled_Image_u32* image, u32 x, u32 y) {
+    u32* tile = get_tile_pointer(image, x >> IMAGE_TILE_SHIFT, y >> IMAGE_TILE_SHIFT);
+    u32* result = tile + ((y & IMAGE_TILE_MASK) << IMAGE_TILE_SHIFT) + (x & IMAGE_TILE_MASK);
+    return result;
+}
+
+function
+u32 get_pixel(Tiled_Image_u32* image, u32 x, u32 y) {
+    u32 result = *get_pixel_pointer(image, x, y);
+    return result;
+}
+
+function
+void set_pixel(Tiled_Image_u32* image, u32 x, u32 y, Color_ARGB color) {
+    *get_pixel_pointer(image, x, y) = color.argb;
+}
+
+// NOTE: Clears the padding in the edge tiles too.
+function
+void clear_image(Tiled_Image_u32* image, Color_ARGB color) {
+    umm pixel_count = IMAGE_TILE_PIXELS*(umm)image->tiles_x*image->tiles_y;
+    for (umm i = 0; i < pixel_count; ++i) {
+        image->pixels[i] = color.argb;
+    }
+}
+
+// NOTE: The width and height of the part of a tile that's inside the image.
+function
+void get_tile_extent(Tiled_Image_u32* image, u32 tile_x, u32 tile_y, u32* width, u32* height) {
+    *width  = Min(IMAGE_TILE_SIZE, image->width  - (tile_x << IMAGE_TILE_SHIFT));
+    *height = Min(IMAGE_TILE_SIZE, image->height - (tile_y << IMAGE_TILE_SHIFT));
+}
+
+// NOTE: Linear to tiled. src and dst have to be the same size.
+function
+void tile_image(Image_u32* src, Tiled_Image_u32* dst) {
+    Assert((src->width == dst->width) && (src->height == dst->height));
+    for (u32 tile_y = 0; tile_y < dst->tiles_y; ++tile_y) {
+        for (u32 tile_x = 0; tile_x < dst->tiles_x; ++tile_x) {
+            u32* tile = get_tile_pointer(dst, tile_x, tile_y);
+            u32 width, height;
+            get_tile_extent(dst, tile_x, tile_y, &width, &height);
+            for (u32 row = 0; row < height; ++row) {
+                u32* src_row = get_pixel_pointer(src, tile_x << IMAGE_TILE_SHIFT, (tile_y << IMAGE_TILE_SHIFT) + row);
+                memcpy(tile + (row << IMAGE_TILE_SHIFT), src_row, sizeof(u32)*width);
+            }
+        }
+    }
+}
+
+// NOTE: Tiled to linear, for write_image and anything else that wants rows.
+function
+void resolve_tiled_image(Tiled_Image_u32* src, Image_u32* dst) {
+    Assert((src->width == dst->width) && (src->height == dst->height));
+    for (u32 tile_y = 0; tile_y < src->tiles_y; ++tile_y) {
+        for (u32 tile_x = 0; tile_x < src->tiles_x; ++tile_x) {
+            u32* tile = get_tile_pointer(src, tile_x, tile_y);
+            u32 width, height;
+            get_tile_extent(src, tile_x, tile_y, &width, &height);
+            for (u32 row = 0; row < height; ++row) {
+                u32* dst_row = get_pixel_pointer(dst, tile_x << IMAGE_TILE_SHIFT, (tile_y << IMAGE_TILE_SHIFT) + row);
+                memcpy(dst_row, tile + (row << IMAGE_TILE_SHIFT), sizeof(u32)*width);
+            }
+        }
+    }
+}
+
+function
+void write_image(char* file_name, Tiled_Image_u32* image, ImageFormat format) {
+    Image_u32 resolved = allocate_image(image->width, image->height);
+    resolve_tiled_image(image, &resolved);
+    write_image(file_name, &resolved, format);
+    free_image(&resolved);
+}
+
+function
+void write_image(char* file_name, Tiled_Image_u32* image) {
+    write_image(file_name, image, ImageFormat_BMP);
+}
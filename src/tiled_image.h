@@ -0,0 +1,30 @@
+/* date = October 19th 2026 5:40 pm */
+
+#ifndef TILED_IMAGE_H
+#define TILED_IMAGE_H
+
+//
+// NOTE: An image stored as 8x8 tiles instead of rows. A tile is 256 bytes, four cache lines,
+// so anything that reads a 2D neighbourhood touches a few lines instead of one per row.
+// Tiles are stored row-major, and the pixels inside a tile are row-major too. Tiles on the
+// right and top edges are padded when the size isn't a multiple of 8.
+//
+// Kernels that know about tiles walk them with get_tile_pointer. Everything else can use the
+// get_pixel / set_pixel overloads, or resolve to a linear Image_u32 first.
+//
+
+#define IMAGE_TILE_SHIFT 3
+#define IMAGE_TILE_SIZE (1 << IMAGE_TILE_SHIFT)
+#define IMAGE_TILE_MASK (IMAGE_TILE_SIZE - 1)
+#define IMAGE_TILE_PIXELS (IMAGE_TILE_SIZE*IMAGE_TILE_SIZE)
+
+typedef struct Tiled_Image_u32 {
+    u32 width;
+    u32 height;
+    u32 tiles_x;
+    u32 tiles_y;
+    
+    u32* pixels;
+} Tiled_Image_u32;
+
+#endif //TILED_IMAGE_H
@@ -0,0 +1,178 @@
+//
+// NOTE: Stamps out the two passes of a visibility buffer pipeline:
+//     void VISIBILITY_DRAW_NAME(Visibility_Buffer* buffer, VISIBILITY_UNIFORMS* uniforms, u32 triangle_count);
+//     void VISIBILITY_SHADE_NAME(Visibility_Buffer* buffer, VISIBILITY_UNIFORMS* uniforms, Image_u32* target);
+//     void VISIBILITY_SHADE_NAME(Visibility_Buffer* buffer, VISIBILITY_UNIFORMS* uniforms, Image_u32* target, Job_Pool* pool);
+// Define these and include this file:
+//     VISIBILITY_DRAW_NAME
+//     VISIBILITY_SHADE_NAME
+//     VISIBILITY_UNIFORMS
+//     VISIBILITY_VERTEX_SHADER
+//     VISIBILITY_FRAGMENT_SHADER
+//     VISIBILITY_VARYING_COUNT
+// The shaders are the same as for pipeline_template.c. The vertex shader runs in both passes
+// and has to give the same result each time. The shade pass only writes the pixels that were
+// drawn, and replaces them, so anything blended goes on top afterwards with a normal
+// pipeline and the same depth buffer.
+//
+
+#if !defined(VISIBILITY_DRAW_NAME) || !defined(VISIBILITY_SHADE_NAME) || !defined(VISIBILITY_UNIFORMS) || \
+    !defined(VISIBILITY_VERTEX_SHADER) || !defined(VISIBILITY_FRAGMENT_SHADER) || !defined(VISIBILITY_VARYING_COUNT)
+#error "A visibility pipeline needs all its parameters defined before including visibility_template.c"
+#endif
+
+//
+// NOTE: First pass, depth and triangle ids
+//
+
+internal __m128i Glue(VISIBILITY_DRAW_NAME, _id_shader)(VISIBILITY_UNIFORMS* uniforms, Fragment_Batch* batch) {
+    __m128i result = _mm_set1_epi32((s32)(batch->triangle_index + 1));
+    return result;
+}
+
+#define PIPELINE_NAME            Glue(VISIBILITY_DRAW_NAME, _ids)
+#define PIPELINE_UNIFORMS        VISIBILITY_UNIFORMS
+#define PIPELINE_VERTEX_SHADER   VISIBILITY_VERTEX_SHADER
+#define PIPELINE_FRAGMENT_SHADER Glue(VISIBILITY_DRAW_NAME, _id_shader)
+#define PIPELINE_VARYING_COUNT   0
+#define PIPELINE_DEPTH_TEST      DepthTest_Less
+#define PIPELINE_BLEND_MODE      BlendMode_Replace
+#include "pipeline_template.c"
+
+// NOTE: Triangle ids are per draw, so there's one draw per buffer between clears.
+function
+void VISIBILITY_DRAW_NAME(Visibility_Buffer* buffer, VISIBILITY_UNIFORMS* uniforms, u32 triangle_count) {
+    Render_Target target = {};
+    target.color = &buffer->ids;
+    target.depth = &buffer->depth;
+    Glue(VISIBILITY_DRAW_NAME, _ids)(&target, uniforms, triangle_count);
+}
+
+//
+// NOTE: Second pass, shading
+//
+
+// NOTE: Runs the vertex shader again and sets up the triangle with every varying. Near plane
+// clipping can turn it into a fan, but the fan's triangles all lie on the same planes, so the
+// first one that sets up will do for any of its pixels.
+internal b32 Glue(VISIBILITY_SHADE_NAME, _setup)(VISIBILITY_UNIFORMS* uniforms, u32 triangle_index, u32 width, u32 height, Triangle_Setup* setup) {
+    Raster_Vertex vertices[3];
+    for (u32 corner = 0; corner < 3; ++corner) {
+        VISIBILITY_VERTEX_SHADER(uniforms, triangle_index, corner, &vertices[corner]);
+    }
+    
+    Raster_Vertex clipped[4];
+    u32 clipped_count = clip_to_near_plane(&vertices[0], &vertices[1], &vertices[2], VISIBILITY_VARYING_COUNT, clipped);
+    for (u32 fan_index = 2; fan_index < clipped_count; ++fan_index) {
+        if (setup_triangle(setup, &clipped[0], &clipped[fan_index - 1], &clipped[fan_index], VISIBILITY_VARYING_COUNT, width, height)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef struct Glue(VISIBILITY_SHADE_NAME, _Job_Data) {
+    Visibility_Buffer* buffer;
+    VISIBILITY_UNIFORMS* uniforms;
+    Image_u32* target;
+    u32 tiles_x;
+} Glue(VISIBILITY_SHADE_NAME, _Job_Data);
+
+internal void Glue(VISIBILITY_SHADE_NAME, _job)(void* user_data, u32 job_index, u32 worker_index) {
+    Glue(VISIBILITY_SHADE_NAME, _Job_Data)* data = (Glue(VISIBILITY_SHADE_NAME, _Job_Data)*)user_data;
+    Image_u32* ids    = &data->buffer->ids;
+    Image_u32* target = data->target;
+    
+    u32 min_x = (job_index % data->tiles_x)*VISIBILITY_TILE_SIZE;
+    u32 min_y = (job_index / data->tiles_x)*VISIBILITY_TILE_SIZE;
+    u32 max_x = Min(min_x + VISIBILITY_TILE_SIZE, ids->width);
+    u32 max_y = Min(min_y + VISIBILITY_TILE_SIZE, ids->height);
+    
+    // NOTE: Neighbouring pixels mostly come from the same triangle, so the last setup is kept.
+    u32 setup_id = 0;
+    b32 setup_valid = false;
+    Triangle_Setup setup;
+    
+    for (u32 y = min_y; y < max_y; ++y) {
+        u32* id_row = get_pixel_pointer(ids, 0, y);
+        
+        u32 x = min_x;
+        while (x < max_x) {
+            u32 id = id_row[x];
+            if (!id) {
+                ++x;
+                continue;
+            }
+            
+            // NOTE: A batch is up to four pixels in a row from the same triangle.
+            u32 count = 1;
+            while ((count < 4) && (x + count < max_x) && (id_row[x + count] == id)) {
+                ++count;
+            }
+            
+            if (id != setup_id) {
+                setup_id = id;
+                setup_valid = Glue(VISIBILITY_SHADE_NAME, _setup)(data->uniforms, id - 1, ids->width, ids->height, &setup);
+            }
+            
+            if (setup_valid) {
+                Varying_Stepper stepper;
+                begin_varyings(&stepper, &setup, x, y);
+                
+                Fragment_Batch batch;
+                batch.x              = x;
+                batch.y              = y;
+                batch.count          = count;
+                batch.triangle_index = id - 1;
+                batch.setup          = &setup;
+                batch.stepper        = &stepper;
+                get_varyings(&stepper, &setup, count, &batch.depth, batch.varyings);
+                
+                __m128i colors = VISIBILITY_FRAGMENT_SHADER(data->uniforms, &batch);
+                u32* target_pixels = get_pixel_pointer(target, x, y);
+                if (count == 4) {
+                    _mm_storeu_si128((__m128i*)target_pixels, colors);
+                } else {
+                    u32 packed[4];
+                    _mm_storeu_si128((__m128i*)packed, colors);
+                    memcpy(target_pixels, packed, sizeof(u32)*count);
+                }
+            }
+            
+            x += count;
+        }
+    }
+}
+
+function
+void VISIBILITY_SHADE_NAME(Visibility_Buffer* buffer, VISIBILITY_UNIFORMS* uniforms, Image_u32* target, Job_Pool* pool) {
+    Assert((buffer->ids.width  == target->width) &&
+           (buffer->ids.height == target->height));
+    
+    Glue(VISIBILITY_SHADE_NAME, _Job_Data) data = {};
+    data.buffer   = buffer;
+    data.uniforms = uniforms;
+    data.target   = target;
+    data.tiles_x  = (target->width  + VISIBILITY_TILE_SIZE - 1) / VISIBILITY_TILE_SIZE;
+    u32 tiles_y   = (target->height + VISIBILITY_TILE_SIZE - 1) / VISIBILITY_TILE_SIZE;
+    
+    if (pool) {
+        parallel_for(pool, data.tiles_x*tiles_y, Glue(VISIBILITY_SHADE_NAME, _job), &data);
+    } else {
+        for (u32 job_index = 0; job_index < data.tiles_x*tiles_y; ++job_index) {
+            Glue(VISIBILITY_SHADE_NAME, _job)(&data, job_index, 0);
+        }
+    }
+}
+
+function
+void VISIBILITY_SHADE_NAME(Visibility_Buffer* buffer, VISIBILITY_UNIFORMS* uniforms, Image_u32* target) {
+    VISIBILITY_SHADE_NAME(buffer, uniforms, target, 0);
+}
+
+#undef VISIBILITY_DRAW_NAME
+#undef VISIBILITY_SHADE_NAME
+#undef VISIBILITY_UNIFORMS
+#undef VISIBILITY_VERTEX_SHADER
+#undef VISIBILITY_FRAGMENT_SHADER
+#undef VISIBILITY_VARYING_COUNT